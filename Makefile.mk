@@ -1075,6 +1075,24 @@ else
 FMAP_SPD_CACHE_ENTRY :=
 endif
 
+ifeq ($(CONFIG_EDID_CACHE_IN_FMAP),y)
+FMAP_EDID_CACHE_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x1000)
+FMAP_EDID_CACHE_SIZE := 0x1000
+FMAP_EDID_CACHE_ENTRY := $(CONFIG_EDID_CACHE_FMAP_NAME)@$(FMAP_EDID_CACHE_BASE) $(FMAP_EDID_CACHE_SIZE)
+FMAP_CURRENT_BASE := $(call int-add, $(FMAP_EDID_CACHE_BASE) $(FMAP_EDID_CACHE_SIZE))
+else
+FMAP_EDID_CACHE_ENTRY :=
+endif
+
+ifeq ($(CONFIG_PCI_OPROM_CACHE_IN_FMAP),y)
+FMAP_OPROM_CACHE_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x10000)
+FMAP_OPROM_CACHE_SIZE := $(CONFIG_PCI_OPROM_CACHE_FMAP_SIZE)
+FMAP_OPROM_CACHE_ENTRY := $(CONFIG_PCI_OPROM_CACHE_FMAP_NAME)@$(FMAP_OPROM_CACHE_BASE) $(FMAP_OPROM_CACHE_SIZE)
+FMAP_CURRENT_BASE := $(call int-add, $(FMAP_OPROM_CACHE_BASE) $(FMAP_OPROM_CACHE_SIZE))
+else
+FMAP_OPROM_CACHE_ENTRY :=
+endif
+
 ifeq ($(CONFIG_VPD),y)
 FMAP_VPD_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x4000)
 FMAP_VPD_SIZE := $(CONFIG_VPD_FMAP_SIZE)
@@ -1150,6 +1168,19 @@ else
 FMAP_MRC_CACHE_ENTRY :=
 endif
 
+#
+# NON-X86 RW_EDID_CACHE FMAP region
+#
+# position, size and entry line of EDID_CACHE relative to BIOS_BASE, if enabled
+ifeq ($(CONFIG_EDID_CACHE_IN_FMAP),y)
+FMAP_EDID_CACHE_BASE := $(call int-align, $(FMAP_CURRENT_BASE), 0x1000)
+FMAP_EDID_CACHE_SIZE := 0x1000
+FMAP_EDID_CACHE_ENTRY := $(CONFIG_EDID_CACHE_FMAP_NAME)@$(FMAP_EDID_CACHE_BASE) $(FMAP_EDID_CACHE_SIZE)
+FMAP_CURRENT_BASE := $(call int-add, $(FMAP_EDID_CACHE_BASE) $(FMAP_EDID_CACHE_SIZE))
+else
+FMAP_EDID_CACHE_ENTRY :=
+endif
+
 #
 # NON-X86 COREBOOT default cbfs FMAP region
 #
@@ -1170,6 +1201,8 @@ $(obj)/fmap.fmd: $(top)/Makefile.mk $(DEFAULT_FLASHMAP) $(obj)/config.h
 	    -e "s,##MRC_CACHE_ENTRY##,$(FMAP_MRC_CACHE_ENTRY)," \
 	    -e "s,##SMMSTORE_ENTRY##,$(FMAP_SMMSTORE_ENTRY)," \
 	    -e "s,##SPD_CACHE_ENTRY##,$(FMAP_SPD_CACHE_ENTRY)," \
+	    -e "s,##EDID_CACHE_ENTRY##,$(FMAP_EDID_CACHE_ENTRY)," \
+	    -e "s,##OPROM_CACHE_ENTRY##,$(FMAP_OPROM_CACHE_ENTRY)," \
 	    -e "s,##VPD_ENTRY##,$(FMAP_VPD_ENTRY)," \
 	    -e "s,##HSPHY_FW_ENTRY##,$(FMAP_HSPHY_FW_ENTRY)," \
 	    -e "s,##CBFS_BASE##,$(FMAP_CBFS_BASE)," \
@@ -32,6 +32,52 @@
 #include <usb/usb.h>
 #include "generic_hub.h"
 
+/* usb20 spec 9.1.2: the connection has to be stable for at least 100ms */
+#define DEBOUNCE_STABLE_US	(100 * 1000)
+#define DEBOUNCE_STEP_US	1000		/* linux uses 25ms */
+#define DEBOUNCE_TIMEOUT_US	(1500 * 1000)	/* linux uses this value */
+/* usb20 spec 11.5.1.5: reset should take 10 to 20ms */
+#define RESET_MIN_US		(10 * 1000)
+#define RESET_TIMEOUT_US	(22 * 1000)
+#define ENABLE_TIMEOUT_US	(10 * 1000)
+#define RECOVERY_US		(10 * 1000)	/* usb20 spec 7.1.7.5 */
+#define POWER_ON_US		(20 * 1000)	/* once for all ports */
+
+/* Number of powering hubs and of ports that are not idle, on all controllers */
+static int pending;
+
+static int
+generic_hub_owns_addr0(const generic_hub_port_state_t state)
+{
+	return state >= GEN_HUB_PORT_RESET;
+}
+
+static void
+generic_hub_set_state(usbdev_t *const dev, const int port,
+		      const generic_hub_port_state_t state)
+{
+	generic_hub_port_t *const p = &GEN_HUB(dev)->port_states[port];
+
+	if (generic_hub_owns_addr0(p->state) && !generic_hub_owns_addr0(state))
+		dev->controller->addr0_busy = 0;
+	else if (!generic_hub_owns_addr0(p->state) && generic_hub_owns_addr0(state))
+		dev->controller->addr0_busy = 1;
+
+	if (p->state == GEN_HUB_PORT_IDLE && state != GEN_HUB_PORT_IDLE)
+		++pending;
+	else if (p->state != GEN_HUB_PORT_IDLE && state == GEN_HUB_PORT_IDLE)
+		--pending;
+
+	p->state = state;
+	p->since = timer_us(0);
+}
+
+int
+generic_hub_enumerating(void)
+{
+	return pending > 0;
+}
+
 void
 generic_hub_destroy(usbdev_t *const dev)
 {
@@ -39,9 +85,13 @@ generic_hub_destroy(usbdev_t *const dev)
 	if (!hub)
 		return;
 
+	if (hub->powering)
+		--pending;
+
 	/* First, detach all devices behind this hub */
 	int port;
 	for (port = 1; port <= hub->num_ports; ++port) {
+		generic_hub_set_state(dev, port, GEN_HUB_PORT_IDLE);
 		if (hub->ports[port] >= 0) {
 			usb_debug("generic_hub: Detachment at port %d\n", port);
 			usb_detach_device(dev->controller, hub->ports[port]);
@@ -55,6 +105,7 @@ generic_hub_destroy(usbdev_t *const dev)
 			hub->ops->disable_port(dev, port);
 	}
 
+	free(hub->port_states);
 	free(hub->ports);
 	free(hub);
 }
@@ -63,33 +114,31 @@ static int
 generic_hub_debounce(usbdev_t *const dev, const int port)
 {
 	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const p = &hub->port_states[port];
 
-	const int step_ms	= 1;	/* linux uses 25ms, we're busy anyway */
-	const int at_least_ms	= 100;	/* 100ms as in usb20 spec 9.1.2 */
-	const int timeout_ms	= 1500;	/* linux uses this value */
+	if (timer_us(p->sampled) < DEBOUNCE_STEP_US)
+		return 0;
+	p->sampled = timer_us(0);
 
-	int total_ms = 0;
-	int stable_ms = 0;
-	while (stable_ms < at_least_ms && total_ms < timeout_ms) {
-		mdelay(step_ms);
-
-		const int changed = hub->ops->port_status_changed(dev, port);
-		const int connected = hub->ops->port_connected(dev, port);
-		if (changed < 0 || connected < 0)
-			return -1;
+	const int changed = hub->ops->port_status_changed(dev, port);
+	const int connected = hub->ops->port_connected(dev, port);
+	if (changed < 0 || connected < 0)
+		return -1;
 
-		if (!changed && connected) {
-			stable_ms += step_ms;
-		} else {
-			usb_debug("generic_hub: Unstable connection at %d\n",
-				  port);
-			stable_ms = 0;
-		}
-		total_ms += step_ms;
-	}
-	if (total_ms >= timeout_ms)
+	if (!changed && connected) {
+		if (timer_us(p->stable_since) < DEBOUNCE_STABLE_US)
+			return 0;
+	} else {
+		usb_debug("generic_hub: Unstable connection at %d\n", port);
+		p->stable_since = timer_us(0);
+		if (timer_us(p->since) < DEBOUNCE_TIMEOUT_US)
+			return 0;
 		usb_debug("generic_hub: Debouncing timed out at %d\n", port);
-	return 0; /* ignore timeouts, try to always go on */
+	}
+
+	/* ignore timeouts, try to always go on */
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_WAIT_ADDR0);
+	return 0;
 }
 
 int
@@ -122,14 +171,19 @@ generic_hub_resetport(usbdev_t *const dev, const int port)
 	/* wait for 10ms (usb20 spec 11.5.1.5: reset should take 10 to 20ms) */
 	mdelay(10);
 
-	/* now wait 12ms for the hub to finish the reset */
+	/* now wait 12ms (or what the hub asked for) for the hub to finish the reset */
+	const int steps = hub->ops->reset_timeout_ms > 10 ?
+			(hub->ops->reset_timeout_ms - 10) * 10 : 120;
 	const int ret = generic_hub_wait_for_port(
-			/* time out after 120 * 100us = 12ms */
-			dev, port, 0, hub->ops->port_in_reset, 120, 100);
+			/* time out after steps * 100us */
+			dev, port, 0, hub->ops->port_in_reset, steps, 100);
 	if (ret < 0)
 		return -1;
 	else if (!ret)
 		usb_debug("generic_hub: Reset timed out at port %d\n", port);
+	else if (hub->ops->finish_port_reset &&
+		 hub->ops->finish_port_reset(dev, port) < 0)
+		return -1;
 
 	return 0; /* ignore timeouts, try to always go on */
 }
@@ -146,45 +200,102 @@ generic_hub_detach_dev(usbdev_t *const dev, const int port)
 }
 
 static int
-generic_hub_attach_dev(usbdev_t *const dev, const int port)
+generic_hub_start_reset(usbdev_t *const dev, const int port)
 {
 	generic_hub_t *const hub = GEN_HUB(dev);
 
-	if (generic_hub_debounce(dev, port) < 0)
+	if (dev->controller->addr0_busy)
+		return 0;
+
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_RESET);
+
+	if (!hub->ops->reset_port) {
+		generic_hub_set_state(dev, port, GEN_HUB_PORT_RECOVERY);
+		return 0;
+	}
+
+	/* The generic reset can run in the background, others block. */
+	if (hub->ops->reset_port == generic_hub_resetport)
+		return hub->ops->start_port_reset(dev, port);
+
+	if (hub->ops->reset_port(dev, port) < 0)
 		return -1;
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_ENABLE);
+	return 0;
+}
 
-	if (hub->ops->reset_port) {
-		if (hub->ops->reset_port(dev, port) < 0)
-			return -1;
+static int
+generic_hub_finish_reset(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const p = &hub->port_states[port];
+	const uint64_t timeout = hub->ops->reset_timeout_ms ?
+			hub->ops->reset_timeout_ms * 1000ULL : RESET_TIMEOUT_US;
+
+	if (timer_us(p->since) < RESET_MIN_US)
+		return 0;
 
-		if (!hub->ops->port_connected(dev, port)) {
-			usb_debug(
-				"generic_hub: Port %d disconnected after "
-				"reset. Possibly upgraded, rescan required.\n",
-				port);
+	const int in_reset = hub->ops->port_in_reset(dev, port);
+	if (in_reset < 0)
+		return -1;
+	if (in_reset) {
+		if (timer_us(p->since) < timeout)
 			return 0;
-		}
+		/* ignore timeouts, try to always go on */
+		usb_debug("generic_hub: Reset timed out at port %d\n", port);
+	} else if (hub->ops->finish_port_reset &&
+		   hub->ops->finish_port_reset(dev, port) < 0) {
+		return -1;
+	}
 
-		/* after reset the port will be enabled automatically */
-		const int ret = generic_hub_wait_for_port(
-			/* time out after 1,000 * 10us = 10ms */
-			dev, port, 1, hub->ops->port_enabled, 1000, 10);
-		if (ret < 0)
-			return -1;
-		else if (!ret)
-			usb_debug("generic_hub: Port %d still "
-				  "disabled after 10ms\n", port);
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_ENABLE);
+	return 0;
+}
+
+static int
+generic_hub_wait_enable(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const p = &hub->port_states[port];
+
+	if (!hub->ops->port_connected(dev, port)) {
+		usb_debug("generic_hub: Port %d disconnected after "
+			  "reset. Possibly upgraded, rescan required.\n", port);
+		generic_hub_set_state(dev, port, GEN_HUB_PORT_IDLE);
+		return 0;
+	}
+
+	/* after reset the port will be enabled automatically */
+	const int enabled = hub->ops->port_enabled(dev, port);
+	if (enabled < 0)
+		return -1;
+	if (!enabled) {
+		if (timer_us(p->since) < ENABLE_TIMEOUT_US)
+			return 0;
+		usb_debug("generic_hub: Port %d still disabled after 10ms\n",
+			  port);
 	}
 
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_RECOVERY);
+	return 0;
+}
+
+static int
+generic_hub_attach_dev(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const p = &hub->port_states[port];
+
+	if (hub->ops->reset_port && timer_us(p->since) < RECOVERY_US)
+		return 0;
+
 	const usb_speed speed = hub->ops->port_speed(dev, port);
 	if (speed >= 0) {
 		usb_debug("generic_hub: Success at port %d\n", port);
-		if (hub->ops->reset_port)
-			mdelay(10); /* Reset recovery time
-				       (usb20 spec 7.1.7.5) */
 		hub->ports[port] = usb_attach_device(
 				dev->controller, dev->address, port, speed);
 	}
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_IDLE);
 	return 0;
 }
 
@@ -192,6 +303,9 @@ int
 generic_hub_scanport(usbdev_t *const dev, const int port)
 {
 	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const p = &hub->port_states[port];
+
+	generic_hub_set_state(dev, port, GEN_HUB_PORT_IDLE);
 
 	if (hub->ports[port] >= 0) {
 		usb_debug("generic_hub: Detachment at port %d\n", port);
@@ -204,12 +318,62 @@ generic_hub_scanport(usbdev_t *const dev, const int port)
 	if (hub->ops->port_connected(dev, port)) {
 		usb_debug("generic_hub: Attachment at port %d\n", port);
 
-		return generic_hub_attach_dev(dev, port);
+		generic_hub_set_state(dev, port, GEN_HUB_PORT_DEBOUNCE);
+		p->stable_since = p->sampled = p->since;
 	}
 
 	return 0;
 }
 
+void
+generic_hub_poll_ports(usbdev_t *const dev)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	int port;
+
+	if (hub->powering) {
+		if (timer_us(hub->power_on) < POWER_ON_US)
+			return;
+		hub->powering = 0;
+		--pending;
+
+		/* Start debouncing only now that the ports are powered. */
+		for (port = 1; port <= hub->num_ports; ++port) {
+			if (hub->port_states[port].state ==
+			    GEN_HUB_PORT_DEBOUNCE)
+				generic_hub_scanport(dev, port);
+		}
+		if (hub->ops->ports_powered)
+			hub->ops->ports_powered(dev);
+	}
+
+	for (port = 1; port <= hub->num_ports; ++port) {
+		int ret = 0;
+
+		switch (hub->port_states[port].state) {
+		case GEN_HUB_PORT_IDLE:
+			break;
+		case GEN_HUB_PORT_DEBOUNCE:
+			ret = generic_hub_debounce(dev, port);
+			break;
+		case GEN_HUB_PORT_WAIT_ADDR0:
+			ret = generic_hub_start_reset(dev, port);
+			break;
+		case GEN_HUB_PORT_RESET:
+			ret = generic_hub_finish_reset(dev, port);
+			break;
+		case GEN_HUB_PORT_ENABLE:
+			ret = generic_hub_wait_enable(dev, port);
+			break;
+		case GEN_HUB_PORT_RECOVERY:
+			ret = generic_hub_attach_dev(dev, port);
+			break;
+		}
+		if (ret < 0)
+			generic_hub_set_state(dev, port, GEN_HUB_PORT_IDLE);
+	}
+}
+
 static void
 generic_hub_poll(usbdev_t *const dev)
 {
@@ -217,6 +381,10 @@ generic_hub_poll(usbdev_t *const dev)
 	if (!hub)
 		return;
 
+	generic_hub_poll_ports(dev);
+	if (hub->powering)
+		return;
+
 	if (!(dev->quirks & USB_QUIRK_HUB_NO_USBSTS_PCD) &&
 	    hub->ops->hub_status_changed &&
 	    hub->ops->hub_status_changed(dev) != 1) {
@@ -225,6 +393,10 @@ generic_hub_poll(usbdev_t *const dev)
 
 	int port;
 	for (port = 1; port <= hub->num_ports; ++port) {
+		/* ports in the middle of an attachment are handled above */
+		if (hub->port_states[port].state != GEN_HUB_PORT_IDLE)
+			continue;
+
 		const int ret = hub->ops->port_status_changed(dev, port);
 		if (ret < 0) {
 			return;
@@ -244,7 +416,7 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 
 	dev->destroy = generic_hub_destroy;
 	dev->poll = generic_hub_poll;
-	dev->data = malloc(sizeof(generic_hub_t));
+	dev->data = calloc(1, sizeof(generic_hub_t));
 	if (!dev->data) {
 		usb_debug("generic_hub: ERROR: Out of memory\n");
 		return -1;
@@ -253,9 +425,12 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 	generic_hub_t *const hub = GEN_HUB(dev);
 	hub->num_ports = num_ports;
 	hub->ports = malloc(sizeof(*hub->ports) * (num_ports + 1));
+	hub->port_states = calloc(num_ports + 1, sizeof(*hub->port_states));
 	hub->ops = ops;
-	if (!hub->ports) {
+	if (!hub->ports || !hub->port_states) {
 		usb_debug("generic_hub: ERROR: Out of memory\n");
+		free(hub->port_states);
+		free(hub->ports);
 		free(dev->data);
 		dev->data = NULL;
 		return -1;
@@ -263,12 +438,15 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 	for (port = 1; port <= num_ports; ++port)
 		hub->ports[port] = NO_DEV;
 
-	/* Enable all ports */
+	/* Enable all ports, the hub's poll() waits once for all of them */
 	if (ops->enable_port) {
 		for (port = 1; port <= num_ports; ++port)
 			ops->enable_port(dev, port);
-		/* wait once for all ports */
-		mdelay(20);
+		hub->powering = 1;
+		hub->power_on = timer_us(0);
+		++pending;
+	} else if (ops->ports_powered) {
+		ops->ports_powered(dev);
 	}
 
 	return 0;
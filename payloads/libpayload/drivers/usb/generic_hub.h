@@ -53,17 +53,52 @@ typedef struct generic_hub_ops {
 	int (*disable_port)(usbdev_t *, int port);
 	/* starts a port reset (required if reset_port is set to a generic one from below) */
 	int (*start_port_reset)(usbdev_t *, int port);
+	/* called once a generic port reset finished in time (optional) */
+	int (*finish_port_reset)(usbdev_t *, int port);
+	/* upper limit for a generic port reset in ms, 0 for the usb20 default */
+	int reset_timeout_ms;
 
 	/* performs a port reset (optional, generic implementations below) */
 	int (*reset_port)(usbdev_t *, int port);
+
+	/* called once after enable_port() when all ports are powered (optional) */
+	void (*ports_powered)(usbdev_t *);
 } generic_hub_ops_t;
 
+/*
+ * Attachments are handled by a per-port state machine that is advanced from
+ * the hub's poll function, so the debounce and reset windows of all generic
+ * hub ports overlap. Hubs with their own reset_port() still reset in place.
+ * Only one port per controller at a time may be in the states from RESET to
+ * RECOVERY, as the device sits at the default address.
+ */
+typedef enum {
+	GEN_HUB_PORT_IDLE = 0,
+	GEN_HUB_PORT_DEBOUNCE,		/* waiting for a stable connection */
+	GEN_HUB_PORT_WAIT_ADDR0,	/* waiting for the default address */
+	GEN_HUB_PORT_RESET,		/* waiting for the port reset to finish */
+	GEN_HUB_PORT_ENABLE,		/* waiting for the port to get enabled */
+	GEN_HUB_PORT_RECOVERY,		/* reset recovery time */
+} generic_hub_port_state_t;
+
+typedef struct generic_hub_port {
+	generic_hub_port_state_t state;
+	uint64_t since;		/* timer_us() base of the current state */
+	uint64_t stable_since;	/* timer_us() base of the stable connection */
+	uint64_t sampled;	/* timer_us() base of the last debounce sample */
+} generic_hub_port_t;
+
 typedef struct generic_hub {
 	int num_ports;
 	/* port numbers are always 1 based,
 	   so we waste one int for convenience */
 	int *ports; /* allocated to sizeof(*ports)*(num_ports+1) */
 #define NO_DEV -1
+	generic_hub_port_t *port_states; /* same size as ports */
+
+	/* set while waiting for the ports to power up after enable_port() */
+	int powering;
+	uint64_t power_on;
 
 	const generic_hub_ops_t *ops;
 
@@ -76,7 +111,12 @@ int generic_hub_wait_for_port(usbdev_t *const dev, const int port,
 			      int (*const port_op)(usbdev_t *, int),
 			      int timeout_steps, const int step_us);
 int  generic_hub_resetport(usbdev_t *, int port);
+/* (re)starts the attachment of the port, which completes during later polls */
 int  generic_hub_scanport(usbdev_t *, int port);
+/* advances the port state machines, needed if the hub has its own poll() */
+void generic_hub_poll_ports(usbdev_t *);
+/* returns 1 while any hub still has attachments in progress */
+int  generic_hub_enumerating(void);
 /* the provided generic_hub_ops struct has to be static */
 int generic_hub_init(usbdev_t *, int num_ports, const generic_hub_ops_t *);
 
@@ -31,6 +31,7 @@
 #include <inttypes.h>
 #include <libpayload-config.h>
 #include <usb/usb.h>
+#include "generic_hub.h"
 
 #define DR_DESC gen_bmRequestType(device_to_host, standard_type, dev_recp)
 
@@ -91,16 +92,31 @@ usb_poll(void)
 	if (usb_poll_prepare)
 		usb_poll_prepare();
 
-	hci_t *controller = usb_hcs;
-	while (controller != NULL) {
-		int i;
-		for (i = 0; i < 128; i++) {
-			if (controller->devices[i] != 0) {
-				controller->devices[i]->poll(controller->devices[i]);
+	/*
+	 * Hub ports are attached over several polls, so that their debounce
+	 * and reset windows overlap. Keep polling until all the devices that
+	 * are present got enumerated.
+	 */
+	const uint64_t start = timer_us(0);
+	int enumerated = 0;
+	for (;;) {
+		hci_t *controller = usb_hcs;
+		while (controller != NULL) {
+			int i;
+			for (i = 0; i < 128; i++) {
+				if (controller->devices[i] != 0) {
+					controller->devices[i]->poll(controller->devices[i]);
+				}
 			}
+			controller = controller->next;
 		}
-		controller = controller->next;
+		if (!generic_hub_enumerating())
+			break;
+		enumerated = 1;
 	}
+	if (enumerated)
+		usb_debug("USB enumeration took %" PRIu64 "us\n",
+			  timer_us(start));
 }
 
 usbdev_t *
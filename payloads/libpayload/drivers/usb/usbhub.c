@@ -168,19 +168,6 @@ static void usb_hub_set_hub_depth(usbdev_t *const dev)
 			  dr.wValue, dev->address, ret);
 }
 
-static const generic_hub_ops_t usb_hub_ops = {
-	.hub_status_changed	= NULL,
-	.port_status_changed	= usb_hub_port_status_changed,
-	.port_connected		= usb_hub_port_connected,
-	.port_in_reset		= usb_hub_port_in_reset,
-	.port_enabled		= usb_hub_port_enabled,
-	.port_speed		= usb_hub_port_speed,
-	.enable_port		= usb_hub_enable_port,
-	.disable_port		= NULL,
-	.start_port_reset	= usb_hub_start_port_reset,
-	.reset_port		= generic_hub_resetport,
-};
-
 /* Clear CSC if set and enumerate port if it's connected regardless of change
    bits. Some broken hubs don't set CSC if already connected during reset. */
 static void
@@ -198,6 +185,28 @@ usb_hub_port_initialize(usbdev_t *const dev, const int port)
 	}
 }
 
+static void
+usb_hub_ports_powered(usbdev_t *const dev)
+{
+	int port;
+	for (port = 1; port <= GEN_HUB(dev)->num_ports; ++port)
+		usb_hub_port_initialize(dev, port);
+}
+
+static const generic_hub_ops_t usb_hub_ops = {
+	.hub_status_changed	= NULL,
+	.port_status_changed	= usb_hub_port_status_changed,
+	.port_connected		= usb_hub_port_connected,
+	.port_in_reset		= usb_hub_port_in_reset,
+	.port_enabled		= usb_hub_port_enabled,
+	.port_speed		= usb_hub_port_speed,
+	.enable_port		= usb_hub_enable_port,
+	.disable_port		= NULL,
+	.start_port_reset	= usb_hub_start_port_reset,
+	.reset_port		= generic_hub_resetport,
+	.ports_powered		= usb_hub_ports_powered,
+};
+
 static int
 usb_hub_handle_port_change(usbdev_t *const dev, const int port)
 {
@@ -250,6 +259,8 @@ usb_hub_poll(usbdev_t *const dev)
 	u8 buf[32] = { 0 };
 	const u8 *ibuf;
 
+	generic_hub_poll_ports(dev);
+
 	/* First, gather all change bits from finished interrupt transfers. */
 	const size_t port_bytes = MIN(ARRAY_SIZE(buf),
 			div_round_up(GEN_HUB(dev)->num_ports + 1, 8));
@@ -323,10 +334,7 @@ usb_hub_init(usbdev_t *const dev)
 		return;
 	}
 
-	int port;
-	for (port = 1; port <= num_ports; ++port)
-		usb_hub_port_initialize(dev, port);
-
+	/* Ports are initialized in usb_hub_ports_powered() during later polls. */
 	GEN_HUB(dev)->data = intrq;
 	dev->poll = usb_hub_poll;
 	dev->destroy = usb_hub_destroy;
@@ -237,6 +237,7 @@ struct usbdev_hc {
 	pcidev_t pcidev; // 0 if not used (eg on ARM)
 	hc_type type;
 	int latest_address;
+	int addr0_busy;		// a hub port reset put a device at address 0
 	usbdev_t *devices[128];	// dev 0 is root hub, 127 is last addressable
 
 	/* start():     Resume operation. */
@@ -472,7 +472,7 @@ int acpi_create_hmat_mpda(acpi_hmat_mpda_t *mpda, u32 initiator, u32 memory)
 {
 	memset((void *)mpda, 0, sizeof(acpi_hmat_mpda_t));
 
-	mpda->type = 0; /* Memory Proximity Domain Attributes structure */
+	mpda->type = ACPI_HMAT_STRUCTURE_MPDA;
 	mpda->length = sizeof(acpi_hmat_mpda_t);
 	/*
 	 * Proximity Domain for Attached Initiator field is valid.
@@ -485,6 +485,60 @@ int acpi_create_hmat_mpda(acpi_hmat_mpda_t *mpda, u32 initiator, u32 memory)
 	return mpda->length;
 }
 
+int acpi_create_hmat_sllbi(acpi_hmat_sllbi_t *sllbi, u8 flags, u8 data_type,
+			   u32 num_initiators, const u32 *initiators,
+			   u32 num_targets, const u32 *targets,
+			   u64 entry_base_unit, const u16 *entries)
+{
+	const size_t num_entries = num_initiators * num_targets;
+	u32 *domains = (u32 *)(sllbi + 1);
+	u16 *values = (u16 *)(domains + num_initiators + num_targets);
+	size_t length;
+
+	length = sizeof(acpi_hmat_sllbi_t) +
+		 (num_initiators + num_targets) * sizeof(u32) +
+		 num_entries * sizeof(u16);
+	/* Keep the following HMAT structures 4-byte aligned */
+	length = ALIGN_UP(length, sizeof(u32));
+
+	memset((void *)sllbi, 0, length);
+
+	sllbi->type = ACPI_HMAT_STRUCTURE_SLLBI;
+	sllbi->length = length;
+	sllbi->flags = flags;
+	sllbi->data_type = data_type;
+	sllbi->num_initiator_domains = num_initiators;
+	sllbi->num_target_domains = num_targets;
+	sllbi->entry_base_unit = entry_base_unit;
+
+	memcpy(domains, initiators, num_initiators * sizeof(u32));
+	memcpy(domains + num_initiators, targets, num_targets * sizeof(u32));
+	memcpy(values, entries, num_entries * sizeof(u16));
+
+	return sllbi->length;
+}
+
+int acpi_create_hmat_msci(acpi_hmat_msci_t *msci, u32 domain, u64 cache_size,
+			  u32 cache_attributes, u16 num_handles,
+			  const u16 *smbios_handles)
+{
+	size_t length = sizeof(acpi_hmat_msci_t) + num_handles * sizeof(u16);
+
+	length = ALIGN_UP(length, sizeof(u32));
+	memset((void *)msci, 0, length);
+
+	msci->type = ACPI_HMAT_STRUCTURE_MSCI;
+	msci->length = length;
+	msci->domain = domain;
+	msci->cache_size = cache_size;
+	msci->cache_attributes = cache_attributes;
+	msci->num_handlers = num_handles;
+	if (num_handles)
+		memcpy(msci + 1, smbios_handles, num_handles * sizeof(u16));
+
+	return msci->length;
+}
+
 void acpi_create_hmat(acpi_hmat_t *hmat,
 		 unsigned long (*acpi_fill_hmat)(unsigned long current))
 {
@@ -29,7 +29,9 @@ bootblock-y += cpu.S
 decompressor-y += cache.c
 bootblock-y += cache.c
 decompressor-y += mmu.c
+decompressor-y += xlat_table.c
 bootblock-y += mmu.c
+bootblock-y += xlat_table.c
 
 bootblock-$(CONFIG_BOOTBLOCK_CONSOLE) += exception.c
 
@@ -74,6 +76,7 @@ romstage-y += cache.c
 romstage-y += cpu.S
 romstage-y += exception.c
 romstage-y += mmu.c
+romstage-y += xlat_table.c
 
 romstage-generic-ccopts += $(armv8_flags)
 
@@ -94,6 +97,7 @@ ramstage-y += cache.c
 ramstage-y += cpu.S
 ramstage-y += exception.c
 ramstage-y += mmu.c
+ramstage-y += xlat_table.c
 
 ramstage-generic-ccopts += $(armv8_flags)
 
@@ -9,6 +9,8 @@
 
 #include <arch/cache.h>
 #include <arch/lib_helpers.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
 #include <program_loading.h>
 
 enum cache_type cpu_get_cache_type(enum cache_level level)
@@ -142,16 +144,132 @@ void dcache_invalidate_by_mva(void const *addr, size_t len)
 	dcache_op_va(addr, len, OP_DCIVAC);
 }
 
+/*
+ * Ranges of a program load that still need cache maintenance. Segments are
+ * collected here and handled all at once when the last one is loaded, so
+ * large loads can use set/way operations and the I-cache only needs to be
+ * invalidated once per program.
+ */
+#define MAX_PENDING_SEGMENTS 8
+
+struct pending_segment {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+static struct pending_segment pending[MAX_PENDING_SEGMENTS];
+static size_t num_pending;
+static size_t pending_bytes;
+/* Generic timer ticks spent in cache_sync_loaded_segments() in this stage */
+static uint64_t cache_maintenance_ticks;
+
+/*
+ * Above the total size of all data caches up to the PoC, walking all sets and
+ * ways takes fewer operations than cleaning every line by address.
+ */
+static size_t dcache_set_way_threshold(void)
+{
+	static size_t threshold;
+	enum cache_level level;
+	size_t cache_size, assoc;
+	uint32_t loc = (raw_read_clidr_el1() >> 24) & 0x7;
+
+	if (threshold)
+		return threshold;
+
+	for (level = CACHE_L1; level <= loc; level++) {
+		enum cache_type type = cpu_get_cache_type(level);
+
+		if (type == NO_CACHE || type == CACHE_INSTRUCTION)
+			continue;
+
+		cache_size = 0;
+		cpu_get_cache_info(level, CACHE_DATA, &cache_size, &assoc);
+		threshold += cache_size;
+	}
+
+	/* No information, never fall back to set/way. */
+	if (!threshold)
+		threshold = SIZE_MAX;
+
+	return threshold;
+}
+
+static void add_pending_segment(uintptr_t start, size_t size)
+{
+	uintptr_t end = start + size;
+	size_t i;
+
+	for (i = 0; i < num_pending; i++) {
+		struct pending_segment *seg = &pending[i];
+
+		/* Merge with overlapping or adjacent ranges. */
+		if (start <= seg->end && end >= seg->start) {
+			pending_bytes -= seg->end - seg->start;
+			seg->start = MIN(seg->start, start);
+			seg->end = MAX(seg->end, end);
+			pending_bytes += seg->end - seg->start;
+			return;
+		}
+	}
+
+	pending[num_pending].start = start;
+	pending[num_pending].end = end;
+	num_pending++;
+	pending_bytes += size;
+}
+
+void cache_sync_loaded_segments(void)
+{
+	uint32_t sctlr = raw_read_sctlr_el3();
+	uint64_t start_ticks, freq;
+	size_t i;
+
+	if (!num_pending)
+		return;
+
+	start_ticks = raw_read_cntpct_el0();
+
+	if (pending_bytes >= dcache_set_way_threshold()) {
+		if (sctlr & SCTLR_C)
+			dcache_clean_all();
+		else if (sctlr & SCTLR_I)
+			dcache_clean_invalidate_all();
+	} else {
+		for (i = 0; i < num_pending; i++) {
+			void *start = (void *)pending[i].start;
+			size_t size = pending[i].end - pending[i].start;
+
+			if (sctlr & SCTLR_C)
+				dcache_clean_by_mva(start, size);
+			else if (sctlr & SCTLR_I)
+				dcache_clean_invalidate_by_mva(start, size);
+		}
+	}
+	icache_invalidate_all();
+
+	cache_maintenance_ticks += raw_read_cntpct_el0() - start_ticks;
+	freq = raw_read_cntfrq_el0();
+	printk(BIOS_SPEW, "Cache maintenance: %zu bytes in %zu ranges, "
+	       "%llu ticks (%llu us) in this stage\n", pending_bytes, num_pending,
+	       cache_maintenance_ticks,
+	       freq ? cache_maintenance_ticks * 1000000 / freq : 0);
+
+	num_pending = 0;
+	pending_bytes = 0;
+}
+
 /*
  * For each segment of a program loaded this function is called
  * to invalidate caches for the addresses of the loaded segment
  */
 void arch_segment_loaded(uintptr_t start, size_t size, int flags)
 {
-	uint32_t sctlr = raw_read_sctlr_el3();
-	if (sctlr & SCTLR_C)
-		dcache_clean_by_mva((void *)start, size);
-	else if (sctlr & SCTLR_I)
-		dcache_clean_invalidate_by_mva((void *)start, size);
-	icache_invalidate_all();
+	if (num_pending == MAX_PENDING_SEGMENTS)
+		cache_sync_loaded_segments();
+
+	add_pending_segment(start, size);
+
+	if (flags & SEG_FINAL)
+		cache_sync_loaded_segments();
 }
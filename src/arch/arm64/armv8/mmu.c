@@ -10,10 +10,10 @@
 #include <arch/lib_helpers.h>
 #include <arch/cache.h>
 
-/* This just caches the next free table slot (okay to do since they fill up from
- * bottom to top and can never be freed up again). It will reset to its initial
- * value on stage transition, so we still need to check it for UNUSED_DESC. */
-static uint64_t *next_free_table = (void *)_ttb;
+/* Number of open mmu_config_batch_begin() calls. */
+static int batch_depth;
+/* Translation tables changed since the last TLB invalidation. */
+static bool tlb_flush_pending;
 
 static void print_tag(int level, uint64_t tag)
 {
@@ -27,139 +27,6 @@ static void print_tag(int level, uint64_t tag)
 					"device\n");
 }
 
-/* Func : get_block_attr
- * Desc : Get block descriptor attributes based on the value of tag in memrange
- * region
- */
-static uint64_t get_block_attr(unsigned long tag)
-{
-	uint64_t attr;
-
-	attr = (tag & MA_NS) ? BLOCK_NS : 0;
-	attr |= (tag & MA_RO) ? BLOCK_AP_RO : BLOCK_AP_RW;
-	attr |= BLOCK_ACCESS;
-
-	if (tag & MA_MEM) {
-		attr |= BLOCK_SH_INNER_SHAREABLE;
-		if (tag & MA_MEM_NC)
-			attr |= BLOCK_INDEX_MEM_NORMAL_NC << BLOCK_INDEX_SHIFT;
-		else
-			attr |= BLOCK_INDEX_MEM_NORMAL << BLOCK_INDEX_SHIFT;
-	} else {
-		attr |= BLOCK_INDEX_MEM_DEV_NGNRNE << BLOCK_INDEX_SHIFT;
-		attr |= BLOCK_XN;
-	}
-
-	return attr;
-}
-
-/* Func : setup_new_table
- * Desc : Get next free table from TTB and set it up to match old parent entry.
- */
-static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
-{
-	while (next_free_table[0] != UNUSED_DESC) {
-		next_free_table += GRANULE_SIZE/sizeof(*next_free_table);
-		if (_ettb - (u8 *)next_free_table <= 0)
-			die("Ran out of page table space!");
-	}
-
-	void *frame_base = (void *)(desc & XLAT_ADDR_MASK);
-	printk(BIOS_DEBUG, "Backing address range [%p:%p) with new page"
-	       " table @%p\n", frame_base, frame_base +
-	       (xlat_size << BITS_RESOLVED_PER_LVL), next_free_table);
-
-	if (!desc) {
-		memset(next_free_table, 0, GRANULE_SIZE);
-	} else {
-		/* Can reuse old parent entry, but may need to adjust type. */
-		if (xlat_size == L3_XLAT_SIZE)
-			desc |= PAGE_DESC;
-
-		int i = 0;
-		for (; i < GRANULE_SIZE/sizeof(*next_free_table); i++) {
-			next_free_table[i] = desc;
-			desc += xlat_size;
-		}
-	}
-
-	return next_free_table;
-}
-
-/* Func: get_next_level_table
- * Desc: Check if the table entry is a valid descriptor. If not, initialize new
- * table, update the entry and return the table addr. If valid, return the addr
- */
-static uint64_t *get_next_level_table(uint64_t *ptr, size_t xlat_size)
-{
-	uint64_t desc = *ptr;
-
-	if ((desc & DESC_MASK) != TABLE_DESC) {
-		uint64_t *new_table = setup_new_table(desc, xlat_size);
-		desc = ((uint64_t)new_table) | TABLE_DESC;
-		*ptr = desc;
-	}
-	return (uint64_t *)(desc & XLAT_ADDR_MASK);
-}
-
-/* Func : init_xlat_table
- * Desc : Given a base address and size, it identifies the indices within
- * different level XLAT tables which map the given base addr. Similar to table
- * walk, except that all invalid entries during the walk are updated
- * accordingly. On success, it returns the size of the block/page addressed by
- * the final table.
- */
-static uint64_t init_xlat_table(uint64_t base_addr,
-				uint64_t size,
-				uint64_t tag)
-{
-	uint64_t l0_index = (base_addr & L0_ADDR_MASK) >> L0_ADDR_SHIFT;
-	uint64_t l1_index = (base_addr & L1_ADDR_MASK) >> L1_ADDR_SHIFT;
-	uint64_t l2_index = (base_addr & L2_ADDR_MASK) >> L2_ADDR_SHIFT;
-	uint64_t l3_index = (base_addr & L3_ADDR_MASK) >> L3_ADDR_SHIFT;
-	uint64_t *table = (uint64_t *)_ttb;
-	uint64_t desc;
-	uint64_t attr = get_block_attr(tag);
-
-	/* L0 entry stores a table descriptor (doesn't support blocks) */
-	table = get_next_level_table(&table[l0_index], L1_XLAT_SIZE);
-
-	/* L1 table lookup */
-	if ((size >= L1_XLAT_SIZE) &&
-	    IS_ALIGNED(base_addr, (1UL << L1_ADDR_SHIFT))) {
-			/* If block address is aligned and size is greater than
-			 * or equal to size addressed by each L1 entry, we can
-			 * directly store a block desc */
-			desc = base_addr | BLOCK_DESC | attr;
-			table[l1_index] = desc;
-			/* L2 lookup is not required */
-			return L1_XLAT_SIZE;
-	}
-
-	/* L1 entry stores a table descriptor */
-	table = get_next_level_table(&table[l1_index], L2_XLAT_SIZE);
-
-	/* L2 table lookup */
-	if ((size >= L2_XLAT_SIZE) &&
-	    IS_ALIGNED(base_addr, (1UL << L2_ADDR_SHIFT))) {
-		/* If block address is aligned and size is greater than
-		 * or equal to size addressed by each L2 entry, we can
-		 * directly store a block desc */
-		desc = base_addr | BLOCK_DESC | attr;
-		table[l2_index] = desc;
-		/* L3 lookup is not required */
-		return L2_XLAT_SIZE;
-	}
-
-	/* L2 entry stores a table descriptor */
-	table = get_next_level_table(&table[l2_index], L3_XLAT_SIZE);
-
-	/* L3 table lookup */
-	desc = base_addr | PAGE_DESC | attr;
-	table[l3_index] = desc;
-	return L3_XLAT_SIZE;
-}
-
 /* Func : sanity_check
  * Desc : Check address/size alignment of a table or page.
  */
@@ -171,62 +38,78 @@ static void sanity_check(uint64_t addr, uint64_t size)
 	       size >= GRANULE_SIZE);
 }
 
-/* Func : get_pte
- * Desc : Returns the page table entry governing a specific address. */
-static uint64_t get_pte(void *addr)
-{
-	int shift = L0_ADDR_SHIFT;
-	uint64_t *pte = (uint64_t *)_ttb;
-
-	while (1) {
-		int index = ((uintptr_t)addr >> shift) &
-			    ((1UL << BITS_RESOLVED_PER_LVL) - 1);
-
-		if ((pte[index] & DESC_MASK) != TABLE_DESC ||
-		    shift <= GRANULE_SIZE_SHIFT)
-			return pte[index];
-
-		pte = (uint64_t *)(pte[index] & XLAT_ADDR_MASK);
-		shift -= BITS_RESOLVED_PER_LVL;
-	}
-}
-
 /* Func : assert_correct_ttb_mapping
  * Desc : Asserts that mapping for addr matches the access type used by the
  * page table walk (i.e. addr is correctly mapped to be part of the TTB). */
 static void assert_correct_ttb_mapping(void *addr)
 {
-	uint64_t pte = get_pte(addr);
+	uint64_t pte = xlat_get_pte((uintptr_t)addr);
 	assert(((pte >> BLOCK_INDEX_SHIFT) & BLOCK_INDEX_MASK)
 	       == BLOCK_INDEX_MEM_NORMAL && !(pte & BLOCK_NS));
 }
 
+/* Func : flush_tlb
+ * Desc : Make the table walker pick up all translation table changes. While
+ * the MMU is off this is left to mmu_enable().
+ */
+static void flush_tlb(void)
+{
+	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
+	dsb();
+	if (raw_read_sctlr_el3() & SCTLR_M) {
+		tlbiall_el3();
+		dsb();
+		isb();
+		tlb_flush_pending = false;
+	}
+
+	xlat_release_tables();
+}
+
+/* Func : xlat_tlb_invalidate
+ * Desc : Break-before-make step of live table updates in xlat_table.c.
+ */
+void xlat_tlb_invalidate(void)
+{
+	dsb();
+	tlbiall_el3();
+	dsb();
+	isb();
+}
+
 /* Func : mmu_config_range
- * Desc : This function repeatedly calls init_xlat_table with the base
- * address. Based on size returned from init_xlat_table, base_addr is updated
- * and subsequent calls are made for initializing the xlat table until the whole
- * region is initialized.
+ * Desc : Map the range with the largest possible blocks. While the MMU is
+ * off, it is also folded into adjacent mappings of the same type. The TLB
+ * invalidation is deferred to the end of the current batch, if any.
  */
 void mmu_config_range(void *start, size_t size, uint64_t tag)
 {
 	uint64_t base_addr = (uintptr_t)start;
-	uint64_t temp_size = size;
 
 	printk(BIOS_INFO, "Mapping address range [%p:%p) as ",
 	       start, start + size);
 	print_tag(BIOS_INFO, tag);
 
-	sanity_check(base_addr, temp_size);
+	sanity_check(base_addr, size);
 
-	while (temp_size)
-		temp_size -= init_xlat_table(base_addr + (size - temp_size),
-					     temp_size, tag);
+	xlat_map_range(base_addr, size, tag, raw_read_sctlr_el3() & SCTLR_M);
+	tlb_flush_pending = true;
 
-	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
-	dsb();
-	tlbiall_el3();
-	dsb();
-	isb();
+	if (!batch_depth)
+		flush_tlb();
+}
+
+void mmu_config_batch_begin(void)
+{
+	batch_depth++;
+}
+
+void mmu_config_batch_end(void)
+{
+	assert(batch_depth > 0);
+
+	if (--batch_depth == 0 && tlb_flush_pending)
+		flush_tlb();
 }
 
 /* Func : mmu_init
@@ -235,14 +118,7 @@ void mmu_config_range(void *start, size_t size, uint64_t tag)
  */
 void mmu_init(void)
 {
-	/* Initially mark all table slots unused (first PTE == UNUSED_DESC). */
-	uint64_t *table = (uint64_t *)_ttb;
-	for (; _ettb - (u8 *)table > 0; table += GRANULE_SIZE/sizeof(*table))
-		table[0] = UNUSED_DESC;
-
-	/* Initialize the root table (L0) to be completely unmapped. */
-	uint64_t *root = setup_new_table(INVALID_DESC, L0_XLAT_SIZE);
-	assert((u8 *)root == _ttb);
+	uint64_t *root = xlat_init_tables();
 
 	/* Initialize TTBR */
 	raw_write_ttbr0_el3((uintptr_t)root);
@@ -295,6 +171,11 @@ void mmu_enable(void)
 	assert_correct_ttb_mapping(_ttb);
 	assert_correct_ttb_mapping((void *)((uintptr_t)_ettb - 1));
 
+	if (tlb_flush_pending) {
+		tlb_invalidate_all();
+		tlb_flush_pending = false;
+	}
+
 	uint32_t sctlr = raw_read_sctlr_el3();
 	sctlr |= SCTLR_C | SCTLR_M | SCTLR_I;
 	raw_write_sctlr_el3(sctlr);
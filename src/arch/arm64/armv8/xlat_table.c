@@ -0,0 +1,337 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <assert.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <stdint.h>
+#include <string.h>
+#include <symbols.h>
+
+#include <arch/mmu.h>
+
+/*
+ * Translation table builder behind mmu_config_range(). This file must not
+ * touch any system registers so that it can be built and tested on the host.
+ *
+ * Merging tables into blocks and setting contiguous hints rewrites entries
+ * that are not part of the requested range, which needs break-before-make on
+ * live tables. Both are therefore only done while the MMU is off. With the MMU
+ * on, a change inside a contiguous group clears the hint of the whole group
+ * through break-before-make first (see break_contiguous_group()).
+ */
+
+#define XLAT_ENTRIES		(GRANULE_SIZE / sizeof(uint64_t))
+/* Descriptor bits that have to match for two entries to be merged. */
+#define XLAT_ATTR_MASK		(~(XLAT_ADDR_MASK | BLOCK_CONTIGUOUS))
+/* Tables whose parent entry has been replaced, waiting for the TLB flush. */
+#define MAX_RELEASED_TABLES	16
+
+/* This just caches the next free table slot. It will reset to its initial
+ * value on stage transition, so we still need to check it for UNUSED_DESC. */
+static uint64_t *next_free_table = (void *)_ttb;
+
+static uint64_t *released_tables[MAX_RELEASED_TABLES];
+static size_t released_count;
+
+/* Whether the tables being updated are in use by the MMU. */
+static bool mmu_on;
+
+static int level_shift(int level)
+{
+	return L0_ADDR_SHIFT - level * BITS_RESOLVED_PER_LVL;
+}
+
+static uint64_t leaf_desc(int level)
+{
+	return level == 3 ? PAGE_DESC : BLOCK_DESC;
+}
+
+static bool is_leaf(uint64_t desc, int level)
+{
+	return level > 0 && (desc & DESC_MASK) == leaf_desc(level);
+}
+
+static bool is_table(uint64_t desc, int level)
+{
+	return level < 3 && (desc & DESC_MASK) == TABLE_DESC;
+}
+
+/* Func : get_block_attr
+ * Desc : Get block descriptor attributes based on the value of tag in memrange
+ * region
+ */
+static uint64_t get_block_attr(unsigned long tag)
+{
+	uint64_t attr;
+
+	attr = (tag & MA_NS) ? BLOCK_NS : 0;
+	attr |= (tag & MA_RO) ? BLOCK_AP_RO : BLOCK_AP_RW;
+	attr |= BLOCK_ACCESS;
+
+	if (tag & MA_MEM) {
+		attr |= BLOCK_SH_INNER_SHAREABLE;
+		if (tag & MA_MEM_NC)
+			attr |= BLOCK_INDEX_MEM_NORMAL_NC << BLOCK_INDEX_SHIFT;
+		else
+			attr |= BLOCK_INDEX_MEM_NORMAL << BLOCK_INDEX_SHIFT;
+	} else {
+		attr |= BLOCK_INDEX_MEM_DEV_NGNRNE << BLOCK_INDEX_SHIFT;
+		attr |= BLOCK_XN;
+	}
+
+	return attr;
+}
+
+/* Func : setup_new_table
+ * Desc : Get next free table from TTB and set it up to match old parent entry.
+ */
+static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
+{
+	while (next_free_table[0] != UNUSED_DESC) {
+		next_free_table += XLAT_ENTRIES;
+		if (_ettb - (u8 *)next_free_table <= 0)
+			die("Ran out of page table space!");
+	}
+
+	void *frame_base = (void *)(uintptr_t)(desc & XLAT_ADDR_MASK);
+	printk(BIOS_DEBUG, "Backing address range [%p:%p) with new page"
+	       " table @%p\n", frame_base, frame_base +
+	       (xlat_size << BITS_RESOLVED_PER_LVL), next_free_table);
+
+	if (!desc) {
+		memset(next_free_table, 0, GRANULE_SIZE);
+	} else {
+		/* Can reuse old parent entry, but may need to adjust type. All
+		   entries of a split block qualify for the contiguous hint, but
+		   it is only set up while the MMU is off. */
+		desc &= ~BLOCK_CONTIGUOUS;
+		if (!mmu_on)
+			desc |= BLOCK_CONTIGUOUS;
+		if (xlat_size == L3_XLAT_SIZE)
+			desc |= PAGE_DESC;
+
+		for (size_t i = 0; i < XLAT_ENTRIES; i++) {
+			next_free_table[i] = desc;
+			desc += xlat_size;
+		}
+	}
+
+	return next_free_table;
+}
+
+/* Func : release_table
+ * Desc : Queue a table that is no longer referenced (together with all its
+ * subtables) for reuse. The table walker may still hold on to it until the
+ * next TLB invalidation, so it only becomes available in xlat_release_tables().
+ */
+static void release_table(uint64_t *table, int level)
+{
+	for (size_t i = 0; i < XLAT_ENTRIES; i++)
+		if (is_table(table[i], level))
+			release_table((uint64_t *)(uintptr_t)(table[i] & XLAT_ADDR_MASK),
+				      level + 1);
+
+	/* Should the queue ever overflow the table just stays allocated. */
+	if (released_count < ARRAY_SIZE(released_tables))
+		released_tables[released_count++] = table;
+}
+
+/* Func: get_next_level_table
+ * Desc: Check if the table entry is a valid descriptor. If not, initialize new
+ * table, update the entry and return the table addr. If valid, return the addr
+ */
+static uint64_t *get_next_level_table(uint64_t *ptr, size_t xlat_size)
+{
+	uint64_t desc = *ptr;
+
+	if ((desc & DESC_MASK) != TABLE_DESC) {
+		uint64_t *new_table = setup_new_table(desc, xlat_size);
+		desc = ((uintptr_t)new_table) | TABLE_DESC;
+		*ptr = desc;
+	}
+	return (uint64_t *)(uintptr_t)(desc & XLAT_ADDR_MASK);
+}
+
+/* Func : entries_are_contiguous
+ * Desc : Check whether count entries of a table at the given level map a
+ * physically contiguous, suitably aligned range with identical attributes.
+ */
+static bool entries_are_contiguous(const uint64_t *entry, size_t count, int level)
+{
+	const uint64_t xlat_size = 1UL << level_shift(level);
+	const uint64_t base = entry[0] & XLAT_ADDR_MASK;
+
+	if (!is_leaf(entry[0], level) || !IS_ALIGNED(base, count * xlat_size))
+		return false;
+
+	for (size_t i = 1; i < count; i++) {
+		if ((entry[i] & XLAT_ATTR_MASK) != (entry[0] & XLAT_ATTR_MASK) ||
+		    (entry[i] & XLAT_ADDR_MASK) != base + i * xlat_size)
+			return false;
+	}
+
+	return true;
+}
+
+/* Func : update_contiguous_hints
+ * Desc : Recompute the contiguous bit for all groups of XLAT_CONTIG_ENTRIES
+ * entries overlapping [first, last] of a table.
+ */
+static void update_contiguous_hints(uint64_t *table, int level, size_t first,
+				    size_t last)
+{
+	if (level == 0)
+		return;
+
+	first = ALIGN_DOWN(first, XLAT_CONTIG_ENTRIES);
+	for (size_t i = first; i <= last; i += XLAT_CONTIG_ENTRIES) {
+		const bool contig = entries_are_contiguous(&table[i],
+						XLAT_CONTIG_ENTRIES, level);
+
+		for (size_t j = i; j < i + XLAT_CONTIG_ENTRIES; j++) {
+			if (contig)
+				table[j] |= BLOCK_CONTIGUOUS;
+			else if (is_leaf(table[j], level))
+				table[j] &= ~BLOCK_CONTIGUOUS;
+		}
+	}
+}
+
+/* Func : break_contiguous_group
+ * Desc : Clear the contiguous hint of the group containing table[index] on
+ * live tables. The entries of a hinted group cannot be changed one by one, so
+ * the whole group is invalidated, the TLB is flushed and only then the entries
+ * are written back without the hint. The group must not map the code or stack
+ * doing this.
+ */
+static void break_contiguous_group(uint64_t *table, size_t index)
+{
+	uint64_t *group = &table[ALIGN_DOWN(index, XLAT_CONTIG_ENTRIES)];
+	uint64_t saved[XLAT_CONTIG_ENTRIES];
+
+	for (size_t i = 0; i < XLAT_CONTIG_ENTRIES; i++) {
+		saved[i] = group[i];
+		group[i] = INVALID_DESC;
+	}
+
+	xlat_tlb_invalidate();
+
+	for (size_t i = 0; i < XLAT_CONTIG_ENTRIES; i++)
+		group[i] = saved[i] & ~BLOCK_CONTIGUOUS;
+}
+
+/* Func : try_merge_table
+ * Desc : Replace a table descriptor by a single block if the whole table maps
+ * one contiguous range with identical attributes.
+ */
+static void try_merge_table(uint64_t *ptr, int level)
+{
+	uint64_t *table = (uint64_t *)(uintptr_t)(*ptr & XLAT_ADDR_MASK);
+
+	/* L0 entries cannot hold blocks. */
+	if (level == 0 || !entries_are_contiguous(table, XLAT_ENTRIES, level + 1))
+		return;
+
+	*ptr = (table[0] & ~(BLOCK_CONTIGUOUS | DESC_MASK)) | BLOCK_DESC;
+	release_table(table, level + 1);
+}
+
+/* Func : map_range
+ * Desc : Map [base, end) in a table at the given level. Every entry that is
+ * fully covered gets a block or page descriptor (replacing any subtable),
+ * partially covered entries recurse into a next level table. With the MMU
+ * off, tables that became uniform are folded back into blocks and the
+ * contiguous hints of all touched entries are updated afterwards.
+ */
+static void map_range(uint64_t *table, int level, uint64_t base, uint64_t end,
+		      uint64_t attr)
+{
+	const int shift = level_shift(level);
+	const uint64_t xlat_size = 1UL << shift;
+	const size_t first = (base >> shift) & (XLAT_ENTRIES - 1);
+	size_t index = first;
+
+	while (base < end) {
+		const uint64_t next = MIN(ALIGN_DOWN(base, xlat_size) + xlat_size, end);
+		uint64_t *ptr = &table[index];
+
+		if (is_leaf(*ptr, level) && (*ptr & XLAT_ATTR_MASK) ==
+		    ((leaf_desc(level) | attr) & XLAT_ATTR_MASK)) {
+			/* Already mapped like this, don't split it up. */
+		} else if (level > 0 && next - base == xlat_size) {
+			if (mmu_on && is_leaf(*ptr, level) && (*ptr & BLOCK_CONTIGUOUS))
+				break_contiguous_group(table, index);
+			if (is_table(*ptr, level))
+				release_table((uint64_t *)(uintptr_t)(*ptr & XLAT_ADDR_MASK),
+					      level + 1);
+			*ptr = base | leaf_desc(level) | attr;
+		} else {
+			if (mmu_on && is_leaf(*ptr, level) && (*ptr & BLOCK_CONTIGUOUS))
+				break_contiguous_group(table, index);
+			map_range(get_next_level_table(ptr, xlat_size >> BITS_RESOLVED_PER_LVL),
+				  level + 1, base, next, attr);
+			if (!mmu_on)
+				try_merge_table(ptr, level);
+		}
+
+		base = next;
+		index++;
+	}
+
+	if (!mmu_on)
+		update_contiguous_hints(table, level, first, index - 1);
+}
+
+void xlat_map_range(uint64_t base, uint64_t size, uint64_t tag, bool live)
+{
+	mmu_on = live;
+	map_range((uint64_t *)_ttb, 0, base, base + size, get_block_attr(tag));
+}
+
+void xlat_release_tables(void)
+{
+	for (size_t i = 0; i < released_count; i++) {
+		uint64_t *table = released_tables[i];
+
+		table[0] = UNUSED_DESC;
+		if (table < next_free_table)
+			next_free_table = table;
+	}
+	released_count = 0;
+}
+
+/* Func : xlat_get_pte
+ * Desc : Returns the page table entry governing a specific address. */
+uint64_t xlat_get_pte(uint64_t addr)
+{
+	int shift = L0_ADDR_SHIFT;
+	uint64_t *pte = (uint64_t *)_ttb;
+
+	while (1) {
+		int index = (addr >> shift) & ((1UL << BITS_RESOLVED_PER_LVL) - 1);
+
+		if ((pte[index] & DESC_MASK) != TABLE_DESC ||
+		    shift <= GRANULE_SIZE_SHIFT)
+			return pte[index];
+
+		pte = (uint64_t *)(uintptr_t)(pte[index] & XLAT_ADDR_MASK);
+		shift -= BITS_RESOLVED_PER_LVL;
+	}
+}
+
+uint64_t *xlat_init_tables(void)
+{
+	/* Initially mark all table slots unused (first PTE == UNUSED_DESC). */
+	uint64_t *table = (uint64_t *)_ttb;
+	for (; _ettb - (u8 *)table > 0; table += XLAT_ENTRIES)
+		table[0] = UNUSED_DESC;
+
+	next_free_table = (uint64_t *)_ttb;
+	released_count = 0;
+
+	/* Initialize the root table (L0) to be completely unmapped. */
+	uint64_t *root = setup_new_table(INVALID_DESC, L0_XLAT_SIZE);
+	assert((u8 *)root == _ttb);
+
+	return root;
+}
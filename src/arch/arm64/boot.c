@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbmem.h>
+#include <arch/cache.h>
 #include <arch/lib_helpers.h>
 #include <arch/stages.h>
 #include <arch/transition.h>
@@ -26,6 +27,8 @@ void arch_prog_run(struct prog *prog)
 {
 	void (*doit)(void *);
 
+	cache_sync_loaded_segments();
+
 	if (ENV_RAMSTAGE && prog_type(prog) == PROG_PAYLOAD) {
 		run_payload(prog);
 		return;
@@ -48,6 +48,13 @@ void dcache_clean_all(void);
 void dcache_invalidate_all(void);
 void dcache_clean_invalidate_all(void);
 
+/*
+ * Do the cache maintenance for all program segments loaded so far. This runs
+ * automatically after the final segment (SEG_FINAL) and before running a
+ * program.
+ */
+void cache_sync_loaded_segments(void);
+
 /* returns number of bytes per cache line */
 unsigned int dcache_line_bytes(void);
 
@@ -40,6 +40,7 @@
 
 #define BLOCK_ACCESS               (1 << 10)
 
+#define BLOCK_CONTIGUOUS           (1UL << 52)
 #define BLOCK_XN                   (1UL << 54)
 
 #define BLOCK_SH_SHIFT                 (8)
@@ -81,6 +82,9 @@
 #define L1_XLAT_SIZE               (1UL << L1_ADDR_SHIFT)
 #define L0_XLAT_SIZE               (1UL << L0_ADDR_SHIFT)
 
+/* Number of adjacent entries covered by one BLOCK_CONTIGUOUS hint */
+#define XLAT_CONTIG_ENTRIES        16
+
 /* Block indices required for MAIR */
 #define BLOCK_INDEX_MEM_DEV_NGNRNE 0
 #define BLOCK_INDEX_MEM_DEV_NGNRE  1
@@ -148,9 +152,22 @@ void mmu_save_context(struct mmu_context *mmu_context);
 void mmu_restore_context(const struct mmu_context *mmu_context);
 /* Change a memory type for a range of bytes at runtime. */
 void mmu_config_range(void *start, size_t size, uint64_t tag);
+/* Defer the TLB invalidation of mmu_config_range() calls to the batch end. */
+void mmu_config_batch_begin(void);
+void mmu_config_batch_end(void);
 /* Enable the MMU (need previous mmu_init() and configured ranges!). */
 void mmu_enable(void);
 /* Disable the MMU (which also disables dcache but not icache). */
 void mmu_disable(void);
 
+/* Translation table builder, free of system register accesses. */
+uint64_t *xlat_init_tables(void);
+/* live: the MMU is on and uses the tables, so no break-before-make shortcuts. */
+void xlat_map_range(uint64_t base, uint64_t size, uint64_t tag, bool live);
+/* Reuse tables unlinked by xlat_map_range(). Only safe after a TLB flush. */
+void xlat_release_tables(void);
+uint64_t xlat_get_pte(uint64_t addr);
+/* Provided by the user of xlat_map_range(): invalidate the whole TLB now. */
+void xlat_tlb_invalidate(void);
+
 #endif /* __ARCH_ARM64_MMU_H__ */
@@ -19,8 +19,10 @@
 #define CBMEM_ID_CB_EARLY_DRAM	0x4544524D
 #define CBMEM_ID_CONSOLE	0x434f4e53
 #define CBMEM_ID_CPU_CRASHLOG	0x4350555f
+#define CBMEM_ID_CRASHLOG	0x474f4c43
 #define CBMEM_ID_COVERAGE	0x47434f56
 #define CBMEM_ID_CSE_UPDATE	0x43534555
+#define CBMEM_ID_EFI_OPTION_INDEX	0x58444f45
 #define CBMEM_ID_EHCI_DEBUG	0xe4c1deb9
 #define CBMEM_ID_ELOG		0x454c4f47
 #define CBMEM_ID_FREESPACE	0x46524545
@@ -39,6 +41,7 @@
 #define CBMEM_ID_MMC_STATUS	0x4d4d4353
 #define CBMEM_ID_MPTABLE	0x534d5054
 #define CBMEM_ID_MRCDATA	0x4d524344
+#define CBMEM_ID_MTRR_SOLUTION	0x4d545253
 #define CBMEM_ID_PMC_CRASHLOG	0x504d435f
 #define CBMEM_ID_IOE_CRASHLOG	0x494f455f
 #define CBMEM_ID_VAR_MRCDATA	0x4d524345
@@ -71,6 +74,7 @@
 #define CBMEM_ID_VBOOT_SEL_REG	0x780074f1  /* deprecated */
 #define CBMEM_ID_VBOOT_WORKBUF	0x78007343
 #define CBMEM_ID_VPD		0x56504420
+#define CBMEM_ID_VPD_INDEX	0x56504449
 #define CBMEM_ID_WIFI_CALIBRATION 0x57494649
 #define CBMEM_ID_EC_HOSTEVENT	0x63ccbbc3  /* deprecated */
 #define CBMEM_ID_EXT_VBT	0x69866684
@@ -86,6 +90,7 @@
 #define CBMEM_ID_TYPE_C_INFO	0x54595045
 #define CBMEM_ID_MEM_CHIP_INFO	0x5048434D
 #define CBMEM_ID_AMD_STB	0x5f425453
+#define CBMEM_ID_AMD_STB_LOG	0x474f4c53
 #define CBMEM_ID_AMD_MP2	0x5f32504d
 #define CBMEM_ID_CSE_INFO	0x4553435F
 #define CBMEM_ID_CSE_BP_INFO	0x42455343
@@ -109,6 +114,8 @@
 	{ CBMEM_ID_CONSOLE,		"CONSOLE    " }, \
 	{ CBMEM_ID_COVERAGE,		"COVERAGE   " }, \
 	{ CBMEM_ID_CPU_CRASHLOG,	"CPU CRASHLOG (deprecated)"}, \
+	{ CBMEM_ID_CRASHLOG,		"CRASHLOG   " }, \
+	{ CBMEM_ID_EFI_OPTION_INDEX,	"EFI OPTIONS" }, \
 	{ CBMEM_ID_EHCI_DEBUG,		"USBDEBUG   " }, \
 	{ CBMEM_ID_ELOG,		"ELOG       " }, \
 	{ CBMEM_ID_FREESPACE,		"FREE SPACE " }, \
@@ -127,6 +134,7 @@
 	{ CBMEM_ID_MMC_STATUS,		"MMC STATUS " }, \
 	{ CBMEM_ID_MPTABLE,		"SMP TABLE  " }, \
 	{ CBMEM_ID_MRCDATA,		"MRC DATA   " }, \
+	{ CBMEM_ID_MTRR_SOLUTION,	"MTRR SOLVED" }, \
 	{ CBMEM_ID_PMC_CRASHLOG,	"PMC CRASHLOG (deprecated)"}, \
 	{ CBMEM_ID_VAR_MRCDATA,		"VARMRC DATA" }, \
 	{ CBMEM_ID_MTC,			"MTC        " }, \
@@ -154,6 +162,7 @@
 	{ CBMEM_ID_VBOOT_SEL_REG,	"VBOOT SEL  " }, \
 	{ CBMEM_ID_VBOOT_WORKBUF,	"VBOOT WORK " }, \
 	{ CBMEM_ID_VPD,			"VPD        " }, \
+	{ CBMEM_ID_VPD_INDEX,		"VPD INDEX  " }, \
 	{ CBMEM_ID_WIFI_CALIBRATION,	"WIFI CLBR  " }, \
 	{ CBMEM_ID_EC_HOSTEVENT,	"EC HOSTEVENT"}, \
 	{ CBMEM_ID_EXT_VBT,		"EXT VBT"}, \
@@ -169,6 +178,7 @@
 	{ CBMEM_ID_TYPE_C_INFO,		"TYPE_C INFO"},\
 	{ CBMEM_ID_MEM_CHIP_INFO,	"MEM CHIP INFO"},\
 	{ CBMEM_ID_AMD_STB,		"AMD STB"},\
+	{ CBMEM_ID_AMD_STB_LOG,		"AMD STB LOG"},\
 	{ CBMEM_ID_AMD_MP2,		"AMD MP2 BUFFER"},\
 	{ CBMEM_ID_CSE_INFO,		"CSE SPECIFIC INFO"},\
 	{ CBMEM_ID_CSE_BP_INFO,		"CSE BP INFO"}, \
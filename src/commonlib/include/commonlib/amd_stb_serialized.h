@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_AMD_STB_SERIALIZED_H
+#define COMMONLIB_AMD_STB_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+/*
+ * AMD Smart Trace Buffer entries drained into CBMEM_ID_AMD_STB_LOG.
+ *
+ * Before each drain, coreboot writes AMD_STB_COREBOOT_SYNC into the STB and
+ * adds a TS_AMD_STB_SYNC timestamp right after it. The n-th sync entry in the
+ * log and the n-th TS_AMD_STB_SYNC timestamp were taken at the same time, so
+ * they map STB time onto the coreboot timestamp timeline.
+ */
+#define AMD_STB_LOG_MAGIC		0x474f4c53	/* 'SLOG' */
+
+/* Values coreboot writes into the STB */
+#define AMD_STB_COREBOOT_POST_PREFIX	0xBA000000
+#define AMD_STB_COREBOOT_MARKER		0xBAADF00D
+#define AMD_STB_COREBOOT_SYNC		0xBA5EC10C
+
+struct amd_stb_log_entry {
+	uint32_t val;
+	uint32_t ts;
+} __packed;
+
+struct amd_stb_log {
+	uint32_t magic;
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t reserved;
+	struct amd_stb_log_entry entries[];
+} __packed;
+
+#endif /* COMMONLIB_AMD_STB_SERIALIZED_H */
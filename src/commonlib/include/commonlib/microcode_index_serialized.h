@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_MICROCODE_INDEX_SERIALIZED_H
+#define COMMONLIB_MICROCODE_INDEX_SERIALIZED_H
+
+#include <commonlib/bsd/compiler.h>
+#include <stdint.h>
+
+/*
+ * Index for the Intel microcode blob in CBFS, generated by `cbfstool add-microcode-index`
+ * and stored as a separate raw CBFS file. All fields are little endian.
+ *
+ * [struct microcode_index_header]
+ * [struct microcode_index_sig] * num_sigs
+ * [struct microcode_index_patch + hash digest] * num_patches
+ *
+ * There is one signature entry for the processor signature of every patch and for every
+ * entry of its extended signature table, in the order of the blob. So the first signature
+ * entry matching the CPU points to the same patch as a linear scan of the blob does.
+ * Every patch entry is followed by the digest of the patch (hash_algo being an
+ * enum vb2_hash_algorithm), which lets the firmware verify a single patch without hashing
+ * the whole blob. There are no digests if hash_algo is VB2_HASH_INVALID.
+ */
+#define MICROCODE_INDEX_MAGIC	0x58444355	/* 'UCDX' */
+#define MICROCODE_INDEX_VERSION	1
+
+struct microcode_index_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t num_sigs;
+	uint16_t num_patches;
+	uint8_t hash_algo;
+	uint8_t reserved;
+	uint32_t blob_size;	/* Size of the microcode blob the index was built for */
+} __packed;
+
+struct microcode_index_sig {
+	uint32_t sig;		/* Processor signature */
+	uint32_t pf;		/* Processor flags (platform ID mask) */
+	uint16_t patch;		/* Index into the patch entries */
+	uint16_t reserved;
+} __packed;
+
+struct microcode_index_patch {
+	uint32_t offset;	/* Offset of the patch in the blob */
+	uint32_t size;
+} __packed;
+
+#endif /* COMMONLIB_MICROCODE_INDEX_SERIALIZED_H */
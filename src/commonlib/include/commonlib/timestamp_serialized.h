@@ -59,6 +59,16 @@ enum timestamp_id {
 	TS_READ_UCODE_END = 113,
 	TS_ELOG_INIT_START = 114,
 	TS_ELOG_INIT_END = 115,
+	TS_PCIE_RETRAIN_START = 116,
+	TS_PCIE_LINK_TRAINED = 117,
+	TS_PCIE_RETRAIN_END = 118,
+	TS_MCU_LOAD_START = 119,
+	TS_MCU_LOAD_END = 120,
+	TS_MCU_RESET_END = 121,
+	TS_CRASHLOG_COLLECT_START = 122,
+	TS_CRASHLOG_COLLECT_END = 123,
+	TS_WARM_RAMSTAGE_START = 124,
+	TS_WARM_RAMSTAGE_END = 125,
 
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_COPYVER_START = 501,
@@ -110,6 +120,7 @@ enum timestamp_id {
 	TS_AMD_APOB_ERASE_START = 921,
 	TS_AMD_APOB_WRITE_START = 922,
 	TS_AMD_APOB_END = 923,
+	TS_AMD_STB_SYNC = 924,
 
 	/* 940-950 reserved for vendorcode extensions (940-950: Intel ME) */
 	TS_ME_INFORM_DRAM_START = 940,
@@ -140,12 +151,18 @@ enum timestamp_id {
 	TS_FSP_MULTI_PHASE_SI_INIT_END = 963,
 	TS_FSP_MULTI_PHASE_MEM_INIT_START = 964,
 	TS_FSP_MULTI_PHASE_MEM_INIT_END = 965,
+	TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START = 966,
+	TS_FSP_MULTI_PHASE_SI_INIT_PHASE_END = 967,
 	TS_FSP_MEMORY_INIT_LOAD = 970,
 	TS_FSP_SILICON_INIT_LOAD = 971,
 
 	/* 990+ reserved for vendorcode extensions (990-999: Intel ME continued) */
 	TS_ME_ROM_START = 990,
 	TS_ISSE_DMU_LOAD_END = 991,
+	TS_CSE_RW_UPDATE_START = 992,
+	TS_CSE_RW_UPDATE_END = 993,
+	TS_CSE_SUB_PART_UPDATE_START = 994,
+	TS_CSE_SUB_PART_UPDATE_END = 995,
 
 	/* 1000+ reserved for payloads */
 
@@ -236,6 +253,18 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_READ_UCODE_END, 0, "finished reading uCode"),
 	TS_NAME_DEF(TS_ELOG_INIT_START, TS_ELOG_INIT_END, "started elog init"),
 	TS_NAME_DEF(TS_ELOG_INIT_END, 0, "finished elog init"),
+	TS_NAME_DEF(TS_PCIE_RETRAIN_START, TS_PCIE_RETRAIN_END, "started PCIe link retraining"),
+	TS_NAME_DEF(TS_PCIE_LINK_TRAINED, 0, "PCIe link retrained"),
+	TS_NAME_DEF(TS_PCIE_RETRAIN_END, 0, "finished PCIe link retraining"),
+	TS_NAME_DEF(TS_MCU_LOAD_START, TS_MCU_LOAD_END, "started loading MCU firmware"),
+	TS_NAME_DEF(TS_MCU_LOAD_END, TS_MCU_RESET_END, "finished loading MCU firmware"),
+	TS_NAME_DEF(TS_MCU_RESET_END, 0, "finished MCU reset"),
+	TS_NAME_DEF(TS_CRASHLOG_COLLECT_START, TS_CRASHLOG_COLLECT_END,
+		    "starting crashlog collection"),
+	TS_NAME_DEF(TS_CRASHLOG_COLLECT_END, 0, "finished crashlog collection"),
+	TS_NAME_DEF(TS_WARM_RAMSTAGE_START, TS_WARM_RAMSTAGE_END,
+		    "starting to load ramstage from warm stage cache"),
+	TS_NAME_DEF(TS_WARM_RAMSTAGE_END, 0, "finished loading ramstage from warm stage cache"),
 
 	/* Google related timestamps */
 	TS_NAME_DEF(TS_COPYVER_START, TS_COPYVER_START, "starting to load verstage"),
@@ -294,6 +323,7 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_AMD_APOB_ERASE_START, TS_AMD_APOB_WRITE_START, "starting APOB erase"),
 	TS_NAME_DEF(TS_AMD_APOB_WRITE_START, TS_AMD_APOB_END, "starting APOB write"),
 	TS_NAME_DEF(TS_AMD_APOB_END, 0, "finished APOB"),
+	TS_NAME_DEF(TS_AMD_STB_SYNC, 0, "AMD STB sync marker"),
 
 	/* Intel ME related timestamps */
 	TS_NAME_DEF(TS_ME_INFORM_DRAM_START, TS_ME_INFORM_DRAM_END,
@@ -321,6 +351,11 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_START, TS_FSP_MULTI_PHASE_SI_INIT_END,
 		    "calling FspMultiPhaseSiInit"),
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_END, 0, "returning from FspMultiPhaseSiInit"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START,
+		    TS_FSP_MULTI_PHASE_SI_INIT_PHASE_END,
+		    "calling FspMultiPhaseSiInit(ExecutePhase)"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_END, 0,
+		    "returning from FspMultiPhaseSiInit(ExecutePhase)"),
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_START, TS_FSP_MULTI_PHASE_MEM_INIT_END,
 		    "calling FspMultiPhaseMemInit"),
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_END, 0, "returning from FspMultiPhaseMemInit"),
@@ -339,6 +374,11 @@ static const struct timestamp_id_to_name {
 	/* Intel ME continued */
 	TS_NAME_DEF(TS_ME_ROM_START, 0, "CSME ROM started execution"),
 	TS_NAME_DEF(TS_ISSE_DMU_LOAD_END, 0, "Die Management Unit (DMU) load completed"),
+	TS_NAME_DEF(TS_CSE_RW_UPDATE_START, TS_CSE_RW_UPDATE_END, "starting CSE RW update"),
+	TS_NAME_DEF(TS_CSE_RW_UPDATE_END, 0, "finished CSE RW update"),
+	TS_NAME_DEF(TS_CSE_SUB_PART_UPDATE_START, TS_CSE_SUB_PART_UPDATE_END,
+		    "starting CSE sub-partition update"),
+	TS_NAME_DEF(TS_CSE_SUB_PART_UPDATE_END, 0, "finished CSE sub-partition update"),
 
 	/* Depthcharge entry timestamp */
 	TS_NAME_DEF(TS_DC_START, 0, "depthcharge start"),
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_UX_LOCALES_SERIALIZED_H
+#define COMMONLIB_UX_LOCALES_SERIALIZED_H
+
+#include <commonlib/bsd/compiler.h>
+#include <stdint.h>
+
+/*
+ * Index for the preram_locales CBFS file, generated by `cbfstool add-locales-index`
+ * and stored as a separate raw CBFS file next to it. All fields are little endian.
+ *
+ * [struct ux_locales_index_header]
+ * [struct ux_locales_index_slot] * num_slots
+ * [struct ux_locales_index_lang] * num_langs
+ *
+ * The slots form an open addressing hash table (linear probing) over the
+ * string names, keyed by ux_locales_name_hash(). Every used slot points to
+ * the string name in the locales file and to a run of language entries,
+ * which in turn point to the language ID preceding each localized string.
+ * All offsets are relative to the start of the locales file, so that the
+ * firmware can check every entry against the file before using it.
+ */
+#define UX_LOCALES_INDEX_MAGIC		0x58444c55	/* 'ULDX' */
+#define UX_LOCALES_INDEX_VERSION	1
+
+struct ux_locales_index_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t num_slots;	/* Power of two */
+	uint32_t locales_size;	/* Size of the locales file the index was built for */
+	uint16_t num_langs;
+	uint16_t reserved;
+} __packed;
+
+struct ux_locales_index_slot {
+	uint32_t name_hash;
+	uint32_t name_offset;	/* 0 for unused slots */
+	uint16_t first_lang;
+	uint16_t num_langs;
+} __packed;
+
+struct ux_locales_index_lang {
+	uint32_t id_offset;
+	uint8_t id;
+	uint8_t reserved[3];
+} __packed;
+
+/* 32-bit FNV-1a hash of a string name. */
+static inline uint32_t ux_locales_name_hash(const char *name)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+#endif /* COMMONLIB_UX_LOCALES_SERIALIZED_H */
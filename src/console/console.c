@@ -64,6 +64,27 @@ void console_tx_byte(unsigned char byte)
 	console_stored_tx_byte(byte, NULL);
 }
 
+void console_interactive_tx_bytes(const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--)
+		console_interactive_tx_byte(*p++, NULL);
+}
+
+/* Stored consoles take whole spans, they only copy to their buffers. */
+void console_stored_tx_bytes(const void *data, size_t len)
+{
+	__flashconsole_tx_bytes(data, len);
+	__cbmemc_tx_bytes(data, len);
+}
+
+void console_tx_bytes(const void *data, size_t len)
+{
+	console_interactive_tx_bytes(data, len);
+	console_stored_tx_bytes(data, len);
+}
+
 void console_tx_flush(void)
 {
 	__uart_tx_flush();
@@ -82,8 +103,7 @@ void console_write_line(uint8_t *buffer, size_t number_of_bytes)
 	}
 
 	/* Output the console data */
-	while (number_of_bytes--)
-		console_tx_byte(*buffer++);
+	console_tx_bytes(buffer, number_of_bytes);
 }
 
 #if CONFIG(GDB_STUB) && (ENV_ROMSTAGE_OR_BEFORE || ENV_RAMSTAGE)
@@ -60,15 +60,21 @@ void do_putchar(unsigned char byte)
 	console_time_stop();
 }
 
-union log_state {
-	void *as_ptr;
-	struct {
-		uint8_t level;
-		uint8_t speed;
-	};
+/*
+ * Bytes of a printk() are collected into spans and handed to the consoles in
+ * one call, so the stored consoles can copy whole spans instead of being
+ * called for every byte. A span never crosses a line break.
+ */
+#define LOG_SPAN_SIZE 64
+
+struct log_state {
+	uint8_t level;
+	uint8_t speed;
+	size_t len;
+	unsigned char span[LOG_SPAN_SIZE];
 };
 
-#define LOG_FAST(state) (HAS_ONLY_FAST_CONSOLES || ((state).speed == CONSOLE_LOG_FAST))
+#define LOG_FAST(state) (HAS_ONLY_FAST_CONSOLES || ((state)->speed == CONSOLE_LOG_FAST))
 
 static void wrap_interactive_printf(const char *fmt, ...)
 {
@@ -78,15 +84,28 @@ static void wrap_interactive_printf(const char *fmt, ...)
 	va_end(args);
 }
 
-static void line_start(union log_state state)
+static void flush_span(struct log_state *state)
+{
+	if (!state->len)
+		return;
+
+	if (LOG_FAST(state))
+		__cbmemc_tx_bytes(state->span, state->len);
+	else
+		console_tx_bytes(state->span, state->len);
+
+	state->len = 0;
+}
+
+static void line_start(struct log_state *state)
 {
-	if (state.level > BIOS_LOG_PREFIX_MAX_LEVEL)
+	if (state->level > BIOS_LOG_PREFIX_MAX_LEVEL)
 		return;
 
 	/* Stored consoles just get a single control char marker to save space. If we are in
 	   LOG_FAST mode, just write the marker to CBMC and exit -- the rest of this function
 	   implements the LOG_ALL case. */
-	unsigned char marker = BIOS_LOG_LEVEL_TO_MARKER(state.level);
+	unsigned char marker = BIOS_LOG_LEVEL_TO_MARKER(state->level);
 	if (LOG_FAST(state)) {
 		__cbmemc_tx_byte(marker);
 		return;
@@ -96,12 +115,12 @@ static void line_start(union log_state state)
 	/* Interactive consoles get a `[DEBUG]  ` style readable prefix,
 	   and potentially an escape sequence for highlighting. */
 	if (CONFIG(CONSOLE_USE_ANSI_ESCAPES))
-		wrap_interactive_printf(BIOS_LOG_ESCAPE_PATTERN, bios_log_escape[state.level]);
+		wrap_interactive_printf(BIOS_LOG_ESCAPE_PATTERN, bios_log_escape[state->level]);
 	if (CONFIG(CONSOLE_USE_LOGLEVEL_PREFIX))
-		wrap_interactive_printf(BIOS_LOG_PREFIX_PATTERN, bios_log_prefix[state.level]);
+		wrap_interactive_printf(BIOS_LOG_PREFIX_PATTERN, bios_log_prefix[state->level]);
 }
 
-static void line_end(union log_state state)
+static void line_end(struct log_state *state)
 {
 	if (CONFIG(CONSOLE_USE_ANSI_ESCAPES) && !LOG_FAST(state))
 		wrap_interactive_printf(BIOS_LOG_ESCAPE_RESET);
@@ -109,26 +128,27 @@ static void line_end(union log_state state)
 
 static void wrap_putchar(unsigned char byte, void *data)
 {
-	union log_state state = { .as_ptr = data };
+	struct log_state *state = data;
 	static bool line_started = false;
 
 	if (byte == '\n') {
+		flush_span(state);
 		line_end(state);
 		line_started = false;
 	} else if (!line_started) {
+		flush_span(state);
 		line_start(state);
 		line_started = true;
 	}
 
-	if (LOG_FAST(state))
-		__cbmemc_tx_byte(byte);
-	else
-		console_tx_byte(byte);
+	state->span[state->len++] = byte;
+	if (byte == '\n' || state->len == sizeof(state->span))
+		flush_span(state);
 }
 
 int vprintk(int msg_level, const char *fmt, va_list args)
 {
-	union log_state state = { .level = msg_level };
+	struct log_state state = { .level = msg_level };
 	int i;
 
 	if (CONFIG(SQUELCH_EARLY_SMP) && ENV_ROMSTAGE_OR_BEFORE && !boot_cpu())
@@ -142,8 +162,9 @@ int vprintk(int msg_level, const char *fmt, va_list args)
 
 	console_time_run();
 
-	i = vtxprintf(wrap_putchar, fmt, args, state.as_ptr);
-	if (LOG_FAST(state))
+	i = vtxprintf(wrap_putchar, fmt, args, &state);
+	flush_span(&state);
+	if (LOG_FAST(&state))
 		console_tx_flush();
 
 	console_time_stop();
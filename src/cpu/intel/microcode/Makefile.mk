@@ -6,6 +6,14 @@ bootblock-$(CONFIG_SUPPORT_CPU_UCODE_IN_CBFS) += microcode.c
 ramstage-$(CONFIG_SUPPORT_CPU_UCODE_IN_CBFS) += microcode.c
 romstage-$(CONFIG_SUPPORT_CPU_UCODE_IN_CBFS) += microcode.c
 
+# Add the index for cpu_microcode_blob.bin next to it into every CBFS that has the blob.
+ifeq ($(CONFIG_CPU_INTEL_MICROCODE_CBFS_INDEX),y)
+$(call add_intermediate, add_mcu_index, $(CBFSTOOL) $$(cpu_microcode_blob.bin-file))
+	@printf "    CBFS       cpu_microcode_index.bin\n"
+	$(CBFSTOOL) $< add-microcode-index -f $(cpu_microcode_blob.bin-file) \
+		-n cpu_microcode_index.bin -r $(call regions-for-file,cpu_microcode_blob.bin)
+endif
+
 # Pack individual microcodes per CPUID from CONFIG_CPU_INTEL_UCODE_SPLIT_BINARIES directory into the CBFS.
 ifeq ($(CONFIG_CPU_INTEL_MICROCODE_CBFS_SPLIT_BINS),y)
 microcode-params-dir := $(call strip_quotes,$(CONFIG_CPU_INTEL_UCODE_SPLIT_BINARIES))/
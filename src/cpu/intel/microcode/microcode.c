@@ -3,13 +3,17 @@
 /* Microcode update for Intel PIII and later CPUs */
 
 #include <cbfs.h>
+#include <commonlib/microcode_index_serialized.h>
 #include <console/console.h>
 #include <cpu/cpu.h>
 #include <cpu/intel/microcode.h>
 #include <cpu/x86/msr.h>
+#include <security/vboot/misc.h>
 #include <smp/spinlock.h>
 #include <stdio.h>
+#include <string.h>
 #include <types.h>
+#include <vb2_api.h>
 
 DECLARE_SPIN_LOCK(microcode_lock)
 
@@ -161,6 +165,104 @@ static struct ext_sig_table *ucode_get_ext_sig_table(const struct microcode *uco
 	return ext_tbl;
 }
 
+#define MICROCODE_INDEX_CBFS_FILE "cpu_microcode_index.bin"
+
+static bool indexed_patch_hash_ok(const struct microcode_index_header *hdr,
+				  const struct microcode_index_patch *entry, const void *patch)
+{
+	struct vb2_hash hash = { .algo = hdr->hash_algo };
+	const size_t digest_size = vb2_digest_size(hdr->hash_algo);
+
+	if (!digest_size) {
+		printk(BIOS_ERR, "microcode: Index has no patch hashes\n");
+		return false;
+	}
+
+	memcpy(hash.raw, entry + 1, digest_size);
+	if (vb2_hash_verify(vboot_hwcrypto_allowed(), patch, entry->size, &hash) !=
+	    VB2_SUCCESS) {
+		printk(BIOS_ERR, "microcode: Patch hash mismatch\n");
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Look up the patch in the index generated by cbfstool, so that only the index and the
+ * matching patch are read from flash instead of the whole microcode blob. Returns CB_ERR if
+ * the index can't be used, in which case the blob needs to be scanned.
+ */
+static enum cb_err find_indexed_microcode(u32 sig, u32 pf, const void **patch)
+{
+	const struct microcode_index_header *hdr;
+	const struct microcode_index_sig *sigs;
+	const struct microcode_index_patch *entry = NULL;
+	enum cb_err ret = CB_ERR;
+	size_t index_len, patch_stride;
+
+	*patch = NULL;
+
+	hdr = cbfs_map(MICROCODE_INDEX_CBFS_FILE, &index_len);
+	if (!hdr)
+		return CB_ERR;
+
+	if (index_len < sizeof(*hdr) || hdr->magic != MICROCODE_INDEX_MAGIC ||
+	    hdr->version != MICROCODE_INDEX_VERSION) {
+		printk(BIOS_ERR, "microcode: Invalid index\n");
+		goto out;
+	}
+
+	patch_stride = sizeof(*entry) + vb2_digest_size(hdr->hash_algo);
+	if (index_len < sizeof(*hdr) + hdr->num_sigs * sizeof(*sigs) +
+			hdr->num_patches * patch_stride) {
+		printk(BIOS_ERR, "microcode: Index truncated\n");
+		goto out;
+	}
+
+	/* The index must belong to the blob in this CBFS. */
+	if (hdr->blob_size != cbfs_get_size(MICROCODE_CBFS_FILE)) {
+		printk(BIOS_ERR, "microcode: Index doesn't match %s\n", MICROCODE_CBFS_FILE);
+		goto out;
+	}
+
+	sigs = (const struct microcode_index_sig *)(hdr + 1);
+	for (size_t i = 0; i < hdr->num_sigs; i++) {
+		if (sigs[i].sig != sig || !(sigs[i].pf & pf))
+			continue;
+		if (sigs[i].patch >= hdr->num_patches)
+			goto out;
+		entry = (const void *)((uintptr_t)(sigs + hdr->num_sigs) +
+				       sigs[i].patch * patch_stride);
+		break;
+	}
+
+	/* Valid index without a patch for this CPU */
+	if (!entry) {
+		ret = CB_SUCCESS;
+		goto out;
+	}
+
+	if (entry->size < sizeof(struct microcode) || entry->offset > hdr->blob_size ||
+	    entry->size > hdr->blob_size - entry->offset)
+		goto out;
+
+	*patch = cbfs_unverified_map_range(MICROCODE_CBFS_FILE, entry->offset, entry->size);
+	if (!*patch)
+		goto out;
+
+	if (CONFIG(CBFS_VERIFICATION) && !indexed_patch_hash_ok(hdr, entry, *patch)) {
+		cbfs_unmap((void *)*patch);
+		*patch = NULL;
+		goto out;
+	}
+
+	ret = CB_SUCCESS;
+out:
+	cbfs_unmap((void *)hdr);
+	return ret;
+}
+
 static const void *find_cbfs_microcode(void)
 {
 	const struct microcode *ucode_updates;
@@ -185,6 +287,15 @@ static const void *find_cbfs_microcode(void)
 	printk(BIOS_DEBUG, "microcode: sig=0x%x pf=0x%x revision=0x%x\n",
 			sig, pf, rev);
 
+	if (CONFIG(CPU_INTEL_MICROCODE_CBFS_INDEX)) {
+		const void *patch;
+
+		if (find_indexed_microcode(sig, pf, &patch) == CB_SUCCESS)
+			return patch;
+		printk(BIOS_DEBUG, "microcode: Index not usable, scanning %s\n",
+		       MICROCODE_CBFS_FILE);
+	}
+
 	if (CONFIG(CPU_INTEL_MICROCODE_CBFS_SPLIT_BINS)) {
 		char cbfs_filename[25];
 		snprintf(cbfs_filename, sizeof(cbfs_filename), "cpu_microcode_%x.bin", sig);
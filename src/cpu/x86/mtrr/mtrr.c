@@ -10,6 +10,7 @@
 
 #include <assert.h>
 #include <bootstate.h>
+#include <cbmem.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
 #include <cpu/amd/mtrr.h>
@@ -23,6 +24,7 @@
 #include <memrange.h>
 #include <string.h>
 #include <types.h>
+#include <xxhash.h>
 
 #if CONFIG(X86_AMD_FIXED_MTRRS)
 #define MTRR_FIXED_WRBACK_BITS (MTRR_READ_MEM | MTRR_WRITE_MEM)
@@ -759,6 +761,518 @@ static void prepare_var_mtrrs(struct memranges *addr_space, int def_type,
 	sol->num_used = var_state.mtrr_index;
 }
 
+/*
+ * Exact variable MTRR solver
+ *
+ * Variable MTRRs describe naturally aligned power-of-two ranges, i.e. nodes
+ * of a binary trie over the physical address space. The effective type of
+ * an address follows from the MTRRs on its path from the root: UC wins over
+ * everything, WT wins over WB and any other overlap is undefined. For every
+ * trie node and every type the MTRRs above it may impose, the minimal number
+ * of MTRRs for its subtree is calculated bottom-up. A node that contains only
+ * a single required type is solved directly, so only nodes that straddle a
+ * type boundary are split and the work is bounded by the number of
+ * boundaries times the address width. The split nodes are kept in an array,
+ * so that emitting the solution is a single walk over them.
+ */
+
+/* Types that ranges may require, plus the ones only used by the solver. */
+#define SOLVER_NUM_TYPES	8
+#define SOLVER_NO_MTRR		7	/* no MTRR above, default type applies */
+#define SOLVER_DONT_CARE	8	/* covered by fixed MTRRs or unused */
+#define SOLVER_MIXED		9	/* node spans more than one type */
+#define SOLVER_INVALID		(-1)
+#define SOLVER_INFINITE		0x4000
+
+/* Plenty for the memory maps seen so far, the greedy code is used beyond. */
+#define SOLVER_MAX_SEGMENTS	128
+#define SOLVER_MAX_NODES	1024
+
+/* A trie node of SOLVER_MIXED type */
+struct solver_node {
+	int16_t cost[SOLVER_NUM_TYPES];	/* minimal MTRRs for each type above */
+	int8_t type[2];			/* required type of the lower/upper half */
+	uint16_t child[2];		/* node index of a SOLVER_MIXED half */
+};
+
+struct mtrr_solver {
+	int def_type;
+	int order;		/* log2 of the address space size in MTRR units */
+	unsigned int types;	/* bitmap of MTRR types that occur */
+	size_t num_segments;
+	struct {
+		uint64_t base;
+		int type;
+	} segments[SOLVER_MAX_SEGMENTS];
+	size_t num_nodes;
+	struct solver_node nodes[SOLVER_MAX_NODES];
+	struct var_mtrr_state *var_state;
+};
+
+static struct mtrr_solver mtrr_solver;
+
+static int solver_add_segment(struct mtrr_solver *solver, uint64_t base, int type)
+{
+	size_t n = solver->num_segments;
+
+	if (n && solver->segments[n - 1].base == base)
+		n--;
+	if (n && solver->segments[n - 1].type == type) {
+		solver->num_segments = n;
+		return 0;
+	}
+	if (n == ARRAY_SIZE(solver->segments))
+		return -1;
+
+	solver->segments[n].base = base;
+	solver->segments[n].type = type;
+	solver->num_segments = n + 1;
+	if (type != SOLVER_DONT_CARE)
+		solver->types |= 1 << type;
+
+	return 0;
+}
+
+/*
+ * Translate the address space into a sorted list of segments with the type
+ * each needs to end up with. This follows the rules of the greedy code: the
+ * first MiB is up to the fixed MTRRs, gaps have to get the default type and
+ * nothing above the last range matters if that starts above 4GiB.
+ */
+static int solver_init(struct mtrr_solver *solver, struct memranges *addr_space,
+		       int above4gb, int address_bits, int def_type)
+{
+	const uint64_t space_end = 1ULL << (address_bits - RANGE_SHIFT);
+	uint64_t cursor = RANGE_1MB;
+	uint64_t last_base = 0;
+	struct range_entry *r;
+
+	memset(solver, 0, sizeof(*solver));
+	solver->def_type = def_type;
+	solver->order = address_bits - RANGE_SHIFT;
+	solver->types = 1 << def_type;
+
+	solver_add_segment(solver, 0, SOLVER_DONT_CARE);
+
+	memranges_each_entry(r, addr_space) {
+		uint64_t base = MAX(range_entry_base_mtrr_addr(r), (uint64_t)RANGE_1MB);
+		uint64_t end = MIN(range_entry_end_mtrr_addr(r), space_end);
+
+		if (!above4gb)
+			end = MIN(end, RANGE_4GB);
+		if (base >= end)
+			continue;
+
+		if (base > cursor && solver_add_segment(solver, cursor, def_type) < 0)
+			return -1;
+		if (solver_add_segment(solver, base, range_entry_mtrr_type(r)) < 0)
+			return -1;
+		cursor = end;
+		last_base = base;
+	}
+
+	if (cursor < space_end) {
+		const bool dont_care = cursor >= RANGE_4GB &&
+				       (!above4gb || last_base >= RANGE_4GB);
+
+		if (solver_add_segment(solver, cursor,
+				       dont_care ? SOLVER_DONT_CARE : def_type) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Required type for [base, end): a single type, SOLVER_DONT_CARE or SOLVER_MIXED. */
+static int solver_required_type(const struct mtrr_solver *solver, uint64_t base,
+				uint64_t end)
+{
+	size_t lo = 0, hi = solver->num_segments;
+	int type = SOLVER_DONT_CARE;
+
+	/* Find the last segment starting at or below base. */
+	while (hi - lo > 1) {
+		const size_t mid = (lo + hi) / 2;
+
+		if (solver->segments[mid].base <= base)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	for (; lo < solver->num_segments && solver->segments[lo].base < end; lo++) {
+		const int t = solver->segments[lo].type;
+
+		if (t == SOLVER_DONT_CARE || t == type)
+			continue;
+		if (type != SOLVER_DONT_CARE)
+			return SOLVER_MIXED;
+		type = t;
+	}
+
+	return type;
+}
+
+/* Effective type of an MTRR of the given type below MTRRs of type `above`. */
+static int solver_combine(int above, int type)
+{
+	if (above == SOLVER_NO_MTRR || above == type)
+		return type;
+	if (above == MTRR_TYPE_UNCACHEABLE || type == MTRR_TYPE_UNCACHEABLE)
+		return MTRR_TYPE_UNCACHEABLE;
+	if ((above == MTRR_TYPE_WRBACK && type == MTRR_TYPE_WRTHROUGH) ||
+	    (above == MTRR_TYPE_WRTHROUGH && type == MTRR_TYPE_WRBACK))
+		return MTRR_TYPE_WRTHROUGH;
+	return SOLVER_INVALID;
+}
+
+/* MTRRs needed for a node of a single required type below `above`. */
+static int solver_uniform_cost(const struct mtrr_solver *solver, int above, int type)
+{
+	const int effective = above == SOLVER_NO_MTRR ? solver->def_type : above;
+
+	if (type == SOLVER_DONT_CARE || type == effective)
+		return 0;
+
+	return solver_combine(above, type) == type ? 1 : SOLVER_INFINITE;
+}
+
+/* MTRRs needed for the subtree of a node of the given type and node index. */
+static int solver_node_cost(const struct mtrr_solver *solver, int type, int node,
+			    int above)
+{
+	if (type != SOLVER_MIXED)
+		return solver_uniform_cost(solver, above, type);
+
+	return solver->nodes[node].cost[above];
+}
+
+/*
+ * Add the node for a SOLVER_MIXED trie node and its SOLVER_MIXED descendants
+ * and calculate the minimal number of MTRRs for its subtree for each type the
+ * MTRRs above it may impose. Returns the node index or -1 if out of nodes.
+ */
+static int solver_build(struct mtrr_solver *solver, uint64_t base, int order)
+{
+	const uint64_t half = 1ULL << (order - 1);
+	struct solver_node *node;
+	int lo[SOLVER_NUM_TYPES], hi[SOLVER_NUM_TYPES];
+	int index;
+
+	if (solver->num_nodes == ARRAY_SIZE(solver->nodes))
+		return -1;
+	index = solver->num_nodes++;
+	node = &solver->nodes[index];
+
+	for (int i = 0; i < 2; i++) {
+		const uint64_t child_base = base + i * half;
+
+		node->type[i] = solver_required_type(solver, child_base, child_base + half);
+		if (node->type[i] == SOLVER_MIXED) {
+			const int child = solver_build(solver, child_base, order - 1);
+
+			if (child < 0)
+				return -1;
+			node->child[i] = child;
+		}
+	}
+
+	for (int t = 0; t < SOLVER_NUM_TYPES; t++) {
+		lo[t] = solver_node_cost(solver, node->type[0], node->child[0], t);
+		hi[t] = solver_node_cost(solver, node->type[1], node->child[1], t);
+	}
+
+	for (int above = 0; above < SOLVER_NUM_TYPES; above++) {
+		int cost = MIN(lo[above] + hi[above], SOLVER_INFINITE);
+
+		for (int t = 0; t < SOLVER_NUM_TYPES; t++) {
+			const int below = solver_combine(above, t);
+
+			if (!(solver->types & (1 << t)) || below == SOLVER_INVALID)
+				continue;
+			cost = MIN(cost, 1 + lo[below] + hi[below]);
+		}
+		node->cost[above] = cost;
+	}
+
+	return index;
+}
+
+/*
+ * Solve the whole address space. Returns the required type of the root and
+ * stores its node index to `root`, or returns SOLVER_INVALID if out of nodes.
+ */
+static int solver_solve(struct mtrr_solver *solver, int *root)
+{
+	const int type = solver_required_type(solver, 0, 1ULL << solver->order);
+
+	*root = 0;
+	if (type == SOLVER_MIXED) {
+		*root = solver_build(solver, 0, solver->order);
+		if (*root < 0)
+			return SOLVER_INVALID;
+	}
+
+	return type;
+}
+
+/* Emit the MTRRs of an optimal solution for a node below MTRRs of type `above`. */
+static void solver_emit(struct mtrr_solver *solver, uint64_t base, int order,
+			int type, int index, int above)
+{
+	const struct solver_node *node = &solver->nodes[index];
+	int best = SOLVER_NO_MTRR;
+
+	if (type != SOLVER_MIXED) {
+		if (solver_uniform_cost(solver, above, type) == 1)
+			best = type;
+	} else if (solver_node_cost(solver, node->type[0], node->child[0], above) +
+		   solver_node_cost(solver, node->type[1], node->child[1], above) !=
+		   node->cost[above]) {
+		/* Find the choice that got us the optimal cost. */
+		for (best = 0; best < SOLVER_NUM_TYPES; best++) {
+			const int below = solver_combine(above, best);
+
+			if ((solver->types & (1 << best)) && below != SOLVER_INVALID &&
+			    1 + solver_node_cost(solver, node->type[0], node->child[0], below) +
+			    solver_node_cost(solver, node->type[1], node->child[1], below) ==
+			    node->cost[above])
+				break;
+		}
+	}
+
+	if (best != SOLVER_NO_MTRR) {
+		if (solver->var_state->prepare_msrs)
+			prep_var_mtrr(solver->var_state, base, 1ULL << order, best);
+		solver->var_state->mtrr_index++;
+		above = solver_combine(above, best);
+	}
+
+	if (type == SOLVER_MIXED) {
+		solver_emit(solver, base, order - 1, node->type[0], node->child[0], above);
+		solver_emit(solver, base + (1ULL << (order - 1)), order - 1, node->type[1],
+			    node->child[1], above);
+	}
+}
+
+/*
+ * Find the minimal set of variable MTRRs for the address space. Returns
+ * the number of MTRRs or -1 if the solver can't handle the address space.
+ */
+static int solve_var_mtrrs(struct memranges *addr_space, int above4gb, int address_bits,
+			   struct var_mtrr_solution *sol)
+{
+	struct mtrr_solver *solver = &mtrr_solver;
+	struct var_mtrr_state var_state = {
+		.addr_space = addr_space,
+		.above4gb = above4gb,
+		.address_bits = address_bits,
+		.regs = &sol->regs[0],
+	};
+	const int def_types[] = { MTRR_TYPE_UNCACHEABLE, MTRR_TYPE_WRBACK };
+	const int bios_mtrrs = total_mtrrs - get_os_reserved_mtrrs();
+	int best_count = SOLVER_INFINITE;
+	int best_type = MTRR_TYPE_UNCACHEABLE;
+	int type, root, count;
+
+	for (int i = 0; i < ARRAY_SIZE(def_types); i++) {
+		if (solver_init(solver, addr_space, above4gb, address_bits,
+				def_types[i]) < 0)
+			return -1;
+		type = solver_solve(solver, &root);
+		if (type == SOLVER_INVALID)
+			return -1;
+		count = solver_node_cost(solver, type, root, SOLVER_NO_MTRR);
+		printk(BIOS_DEBUG, "MTRR: Solver count with default type %d: %d\n",
+		       def_types[i], count);
+		/* Prefer UC as default type on a tie, like the greedy code. */
+		if (count < best_count) {
+			best_count = count;
+			best_type = def_types[i];
+		}
+	}
+
+	if (best_count > bios_mtrrs)
+		return best_count;
+
+	solver_init(solver, addr_space, above4gb, address_bits, best_type);
+	solver->var_state = &var_state;
+	var_state.prepare_msrs = 1;
+	var_state.def_mtrr_type = best_type;
+	type = solver_solve(solver, &root);
+	solver_emit(solver, 0, solver->order, type, root, SOLVER_NO_MTRR);
+
+	sol->mtrr_default_type = best_type;
+	sol->num_used = var_state.mtrr_index;
+
+	return sol->num_used;
+}
+
+/*
+ * Calculate the variable MTRR solution for an address space. The exact
+ * solver is tried first and the greedy heuristic, which can drop WC ranges
+ * to make things fit, serves as a fallback.
+ */
+static void calc_var_mtrr_solution(struct memranges *addr_space, int above4gb,
+				   int address_bits, struct var_mtrr_solution *sol)
+{
+	const int bios_mtrrs = total_mtrrs - get_os_reserved_mtrrs();
+	struct var_mtrr_solution exact;
+	int count;
+
+	count = solve_var_mtrrs(addr_space, above4gb, address_bits, &exact);
+	if (count >= 0 && count <= bios_mtrrs) {
+		printk(BIOS_DEBUG, "MTRR: %s selected as default type, %d MTRRs.\n",
+		       exact.mtrr_default_type == MTRR_TYPE_WRBACK ? "WB" : "UC", count);
+		*sol = exact;
+		return;
+	}
+
+	if (count < 0)
+		printk(BIOS_DEBUG, "MTRR: Address space too fragmented for the solver.\n");
+	else
+		printk(BIOS_DEBUG, "MTRR: Solver needs %d > %d MTRRs, trying greedy.\n",
+		       count, bios_mtrrs);
+	sol->mtrr_default_type = calc_var_mtrrs(addr_space, above4gb, address_bits);
+	prepare_var_mtrrs(addr_space, sol->mtrr_default_type, above4gb, address_bits,
+			  sol);
+
+	/* Dropping WC ranges may have made the exact solution fit again. */
+	count = solve_var_mtrrs(addr_space, above4gb, address_bits, &exact);
+	if (count >= 0 && count <= bios_mtrrs && count < sol->num_used)
+		*sol = exact;
+}
+
+struct var_mtrr_cache {
+	uint32_t hash;
+	struct var_mtrr_solution sol;
+};
+
+static uint32_t hash_var_mtrr_input(struct memranges *addr_space, int above4gb,
+				    int address_bits)
+{
+	const int params[] = { above4gb, address_bits, total_mtrrs,
+			       get_os_reserved_mtrrs() };
+	uint32_t hash = xxh32(params, sizeof(params), 0);
+	struct range_entry *r;
+
+	memranges_each_entry(r, addr_space) {
+		const uint64_t entry[] = { range_entry_base(r), range_entry_end(r),
+					   range_entry_tag(r) };
+		hash = xxh32(entry, sizeof(entry), hash);
+	}
+
+	return hash;
+}
+
+/*
+ * Check that a solution gives every part of the address space the type it
+ * requires. Only the variable MTRRs the solver or the greedy code would
+ * produce, i.e. valid naturally aligned power-of-two ranges, are accepted.
+ */
+static bool check_var_mtrr_solution(struct memranges *addr_space, int above4gb,
+				    int address_bits, const struct var_mtrr_solution *sol)
+{
+	const unsigned int valid_types = 1 << MTRR_TYPE_UNCACHEABLE |
+					 1 << MTRR_TYPE_WRCOMB | 1 << MTRR_TYPE_WRTHROUGH |
+					 1 << MTRR_TYPE_WRPROT | 1 << MTRR_TYPE_WRBACK;
+	struct mtrr_solver *solver = &mtrr_solver;
+	uint64_t start[NUM_MTRR_STATIC_STORAGE], end[NUM_MTRR_STATIC_STORAGE];
+	int type[NUM_MTRR_STATIC_STORAGE];
+	uint64_t space_end;
+
+	if (sol->num_used < 0 || sol->num_used > total_mtrrs ||
+	    (sol->mtrr_default_type != MTRR_TYPE_UNCACHEABLE &&
+	     sol->mtrr_default_type != MTRR_TYPE_WRBACK))
+		return false;
+
+	if (solver_init(solver, addr_space, above4gb, address_bits,
+			sol->mtrr_default_type) < 0)
+		return false;
+	space_end = 1ULL << solver->order;
+
+	for (int i = 0; i < sol->num_used; i++) {
+		const uint64_t base = PHYS_TO_RANGE_ADDR(((uint64_t)sol->regs[i].base.hi << 32 |
+							  sol->regs[i].base.lo) & ~0xfffULL);
+		const uint64_t mask = PHYS_TO_RANGE_ADDR((uint64_t)sol->regs[i].mask.hi << 32 |
+							 sol->regs[i].mask.lo);
+		const uint64_t size = mask & -mask;
+
+		type[i] = sol->regs[i].base.lo & 0xff;
+		if (!(sol->regs[i].mask.lo & MTRR_PHYS_MASK_VALID) || type[i] >= 32 ||
+		    !(valid_types & (1 << type[i])) || !size ||
+		    mask != ((space_end - 1) & ~(size - 1)) || (base & (size - 1)) ||
+		    base + size > space_end)
+			return false;
+		start[i] = base;
+		end[i] = base + size;
+	}
+
+	for (size_t seg = 0; seg < solver->num_segments; seg++) {
+		const uint64_t seg_end = seg + 1 < solver->num_segments ?
+					 solver->segments[seg + 1].base : space_end;
+		const int required = solver->segments[seg].type;
+		uint64_t cursor = solver->segments[seg].base;
+
+		/* Walk the pieces of the segment that the same MTRRs cover. */
+		while (cursor < seg_end) {
+			uint64_t next = seg_end;
+			int effective = SOLVER_NO_MTRR;
+
+			for (int i = 0; i < sol->num_used; i++) {
+				if (start[i] > cursor) {
+					next = MIN(next, start[i]);
+				} else if (end[i] > cursor) {
+					next = MIN(next, end[i]);
+					effective = solver_combine(effective, type[i]);
+					if (effective == SOLVER_INVALID)
+						return false;
+				}
+			}
+			if (effective == SOLVER_NO_MTRR)
+				effective = sol->mtrr_default_type;
+			if (required != SOLVER_DONT_CARE && required != effective)
+				return false;
+			cursor = next;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * The solution only depends on the address space and the CPU, so it is kept
+ * in CBMEM. On S3 resume the address space is usually identical and the
+ * solution from the previous boot can be used. The OS may have written to
+ * that memory though, so the cached MTRRs are checked against the address
+ * space before they are used.
+ */
+static void get_var_mtrr_solution(struct memranges *addr_space, int above4gb,
+				  int address_bits, struct var_mtrr_solution *sol)
+{
+	const uint32_t hash = hash_var_mtrr_input(addr_space, above4gb, address_bits);
+	struct var_mtrr_cache *cache = cbmem_find(CBMEM_ID_MTRR_SOLUTION);
+
+	if (cache && cache->hash == hash) {
+		if (check_var_mtrr_solution(addr_space, above4gb, address_bits,
+					    &cache->sol)) {
+			printk(BIOS_DEBUG, "MTRR: Using cached solution.\n");
+			*sol = cache->sol;
+			return;
+		}
+		printk(BIOS_WARNING, "MTRR: Cached solution doesn't match, recalculating.\n");
+	}
+
+	calc_var_mtrr_solution(addr_space, above4gb, address_bits, sol);
+
+	if (!cache)
+		cache = cbmem_add(CBMEM_ID_MTRR_SOLUTION, sizeof(*cache));
+	if (cache) {
+		cache->hash = hash;
+		cache->sol = *sol;
+	}
+}
+
 static int commit_var_mtrrs(const struct var_mtrr_solution *sol)
 {
 	int i;
@@ -793,10 +1307,7 @@ void x86_setup_var_mtrrs(unsigned int address_bits, unsigned int above4gb)
 
 	if (sol == NULL) {
 		sol = &mtrr_global_solution;
-		sol->mtrr_default_type =
-			calc_var_mtrrs(addr_space, !!above4gb, address_bits);
-		prepare_var_mtrrs(addr_space, sol->mtrr_default_type,
-				  !!above4gb, address_bits, sol);
+		get_var_mtrr_solution(addr_space, !!above4gb, address_bits, sol);
 	}
 
 	commit_var_mtrrs(sol);
@@ -922,10 +1433,7 @@ void mtrr_use_temp_range(uintptr_t begin, size_t size, int type)
 	/* Calculate a new solution with the updated address space. */
 	address_bits = cpu_phys_address_size();
 	memset(&sol, 0, sizeof(sol));
-	sol.mtrr_default_type =
-		calc_var_mtrrs(&addr_space, above4gb, address_bits);
-	prepare_var_mtrrs(&addr_space, sol.mtrr_default_type,
-				above4gb, address_bits, &sol);
+	calc_var_mtrr_solution(&addr_space, above4gb, address_bits, &sol);
 
 	if (commit_var_mtrrs(&sol) < 0)
 		printk(BIOS_WARNING, "Unable to insert temporary MTRR range: 0x%016llx - 0x%016llx size 0x%08llx type %d\n",
@@ -29,6 +29,7 @@ postcar-y += pci_early.c
 ramstage-y += pci_class.c
 ramstage-y += pci_device.c
 ramstage-y += pci_rom.c
+ramstage-$(CONFIG_PCI_OPROM_CACHE_IN_FMAP) += pci_rom_cache.c
 
 bootblock-y += pci_ops.c
 verstage-y += pci_ops.c
@@ -94,6 +94,9 @@ struct rom_header *pci_rom_probe(const struct device *dev)
 		printk(BIOS_DEBUG, "Option ROM address for %s = %lx\n",
 		       dev_path(dev), (unsigned long)rom_address);
 		rom_header = (struct rom_header *)rom_address;
+
+		if (CONFIG(PCI_OPROM_CACHE_IN_FMAP))
+			rom_header = pci_rom_cache(dev, rom_header);
 	} else {
 		printk(BIOS_DEBUG, "PCI Option ROM loading disabled for %s\n",
 		       dev_path(dev));
@@ -0,0 +1,318 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <commonlib/endian.h>
+#include <console/console.h>
+#include <crc_byte.h>
+#include <device/pci.h>
+#include <device/pci_ops.h>
+#include <device/pci_rom.h>
+#include <fmap.h>
+#include <security/vboot/vbios_cache_hash_tpm.h>
+#include <stdlib.h>
+#include <string.h>
+#include <types.h>
+#include <vb2_api.h>
+
+/*
+ * OPROM_CACHE layout
+ *    +==========+ offset 0x00
+ *    |  entry 1 |   struct oprom_cache_entry followed by the ROM data
+ *    +----------+
+ *         ...
+ *    +----------+
+ *    |  entry N |
+ *    +----------+
+ *    |  erased  |
+ *    +==========+
+ *
+ * New entries are appended to the erased space, so a miss doesn't rewrite the
+ * entries of the other devices. The region is only erased when it is full.
+ * The ROM data is the device's expansion ROM up to the end of its x86 image,
+ * which is all pci_rom_load() looks at.
+ *
+ * With PCI_OPROM_CACHE_HASH_TPM, the hash of all entry headers is kept in the
+ * TPM, and every header holds the SHA-256 of its ROM data.
+ */
+#define OPROM_CACHE_FMAP_NAME	(CONFIG_PCI_OPROM_CACHE_FMAP_NAME)
+#define OPROM_CACHE_SIGNATURE	0x4543524f	/* 'ORCE' */
+#define OPROM_CACHE_ENTRIES	16
+/* Size of the ROM header block the key checksum is calculated over */
+#define OPROM_KEY_SIZE		512
+
+struct oprom_cache_entry {
+	uint32_t signature;
+	uint16_t vendor;
+	uint16_t device;
+	uint8_t revision;
+	uint8_t reserved[3];
+	uint32_t key;		/* CRC32 of the first OPROM_KEY_SIZE bytes of the ROM */
+	uint32_t size;		/* of the ROM data following the entry */
+	uint8_t sha256[VB2_SHA256_DIGEST_SIZE];
+} __packed;
+
+static struct oprom_cache_entry entries[OPROM_CACHE_ENTRIES];
+static struct {
+	size_t offset;		/* of the ROM data in the region */
+	void *data;		/* mapped or, for new entries, allocated */
+	bool verified;
+	bool new;
+} roms[OPROM_CACHE_ENTRIES];
+static size_t num_entries;
+static size_t used;		/* bytes of the region in use */
+static bool erase_needed;
+static struct region_device cache_rdev;
+static enum { CACHE_UNREAD, CACHE_CLEAN, CACHE_DIRTY, CACHE_BROKEN } cache_state;
+
+static void load_cache(void)
+{
+	struct oprom_cache_entry entry;
+
+	if (cache_state != CACHE_UNREAD)
+		return;
+
+	if (fmap_locate_area_as_rdev(OPROM_CACHE_FMAP_NAME, &cache_rdev)) {
+		printk(BIOS_ERR, "OPROM_CACHE: Cannot find %s region\n", OPROM_CACHE_FMAP_NAME);
+		cache_state = CACHE_BROKEN;
+		return;
+	}
+	cache_state = CACHE_CLEAN;
+
+	while (num_entries < OPROM_CACHE_ENTRIES) {
+		if (rdev_readat(&cache_rdev, &entry, used, sizeof(entry)) != sizeof(entry) ||
+		    entry.signature != OPROM_CACHE_SIGNATURE ||
+		    entry.size > region_device_sz(&cache_rdev) - used - sizeof(entry))
+			break;
+
+		entries[num_entries] = entry;
+		roms[num_entries].offset = used + sizeof(entry);
+		num_entries++;
+		used += sizeof(entry) + entry.size;
+	}
+
+	/* Anything but erased flash after the last entry makes appending impossible. */
+	if (num_entries == OPROM_CACHE_ENTRIES || (used < region_device_sz(&cache_rdev) &&
+	    rdev_readat(&cache_rdev, &entry.signature, used, sizeof(entry.signature)) ==
+	    sizeof(entry.signature) && entry.signature != 0xffffffff))
+		erase_needed = true;
+
+	if (CONFIG(PCI_OPROM_CACHE_HASH_TPM) && num_entries &&
+	    vbios_cache_verify_hash((const uint8_t *)entries,
+				    num_entries * sizeof(entries[0])) != CB_SUCCESS) {
+		printk(BIOS_WARNING, "OPROM_CACHE: Hash mismatch, ignoring the cache\n");
+		num_entries = 0;
+		erase_needed = true;
+	}
+
+	printk(BIOS_DEBUG, "OPROM_CACHE: %zu entries, 0x%zx bytes used\n", num_entries, used);
+}
+
+/* Size of the ROM up to the end of the x86 image, 0 if there is none. */
+static size_t rom_x86_size(const struct rom_header *rom, size_t max_size)
+{
+	const struct rom_header *image;
+	const struct pci_data *rom_data;
+	size_t offset = 0;
+
+	while (offset + sizeof(*image) <= max_size) {
+		image = (const void *)rom + offset;
+		if (le16_to_cpu(image->signature) != PCI_ROM_HDR)
+			return 0;
+
+		rom_data = (const void *)image + le16_to_cpu(image->data);
+		if (le32_to_cpu(rom_data->signature) != PCI_DATA_HDR)
+			return 0;
+
+		if (rom_data->type == 0) {
+			offset += image->size * 512;
+			return offset <= max_size ? offset : 0;
+		}
+		if (rom_data->indicator & 0x80)
+			return 0;
+
+		offset += le16_to_cpu(rom_data->ilen) * 512;
+	}
+
+	return 0;
+}
+
+static bool rom_hash_ok(const void *data, const struct oprom_cache_entry *entry)
+{
+	struct vb2_hash hash;
+
+	return vb2_hash_calculate(false, data, entry->size, VB2_HASH_SHA256, &hash) ==
+	       VB2_SUCCESS && !memcmp(hash.sha256, entry->sha256, sizeof(entry->sha256));
+}
+
+static struct rom_header *lookup(uint16_t vendor, uint16_t device, uint8_t revision,
+				 uint32_t key)
+{
+	/* Search backwards, a stale entry of the same device may precede the current one. */
+	for (size_t i = num_entries; i-- > 0;) {
+		const struct oprom_cache_entry *entry = &entries[i];
+
+		if (entry->vendor != vendor || entry->device != device ||
+		    entry->revision != revision || entry->key != key)
+			continue;
+
+		if (!roms[i].data)
+			roms[i].data = rdev_mmap(&cache_rdev, roms[i].offset, entry->size);
+		if (!roms[i].data)
+			return NULL;
+
+		if (!roms[i].verified && !rom_hash_ok(roms[i].data, entry)) {
+			printk(BIOS_WARNING, "OPROM_CACHE: Entry %zu is corrupted\n", i);
+			return NULL;
+		}
+		roms[i].verified = true;
+
+		return roms[i].data;
+	}
+
+	return NULL;
+}
+
+static struct rom_header *add(uint16_t vendor, uint16_t device, uint8_t revision,
+			      uint32_t key, const struct rom_header *rom)
+{
+	const size_t max_size = region_device_sz(&cache_rdev) - sizeof(entries[0]);
+	struct oprom_cache_entry *entry;
+	struct vb2_hash hash;
+	size_t size;
+	void *data;
+
+	if (num_entries == OPROM_CACHE_ENTRIES)
+		return NULL;
+
+	size = rom_x86_size(rom, max_size);
+	if (!size)
+		return NULL;
+
+	data = malloc(size);
+	if (!data)
+		return NULL;
+
+	/* This is the one slow read of the expansion ROM. */
+	memcpy(data, rom, size);
+	if (vb2_hash_calculate(false, data, size, VB2_HASH_SHA256, &hash) != VB2_SUCCESS) {
+		free(data);
+		return NULL;
+	}
+
+	entry = &entries[num_entries];
+	memset(entry, 0, sizeof(*entry));
+	entry->signature = OPROM_CACHE_SIGNATURE;
+	entry->vendor = vendor;
+	entry->device = device;
+	entry->revision = revision;
+	entry->key = key;
+	entry->size = size;
+	memcpy(entry->sha256, hash.sha256, sizeof(entry->sha256));
+
+	roms[num_entries].data = data;
+	roms[num_entries].verified = true;
+	roms[num_entries].new = true;
+	num_entries++;
+
+	cache_state = CACHE_DIRTY;
+	return data;
+}
+
+struct rom_header *pci_rom_cache(const struct device *dev, struct rom_header *rom)
+{
+	const uint8_t revision = pci_read_config8(dev, PCI_REVISION_ID);
+	struct rom_header *cached;
+	uint32_t key = 0;
+
+	if (le16_to_cpu(rom->signature) != PCI_ROM_HDR)
+		return rom;
+
+	load_cache();
+	if (cache_state == CACHE_BROKEN)
+		return rom;
+
+	for (size_t i = 0; i < OPROM_KEY_SIZE; i++)
+		key = crc32_byte(key, ((const uint8_t *)rom)[i]);
+
+	cached = lookup(dev->vendor, dev->device, revision, key);
+	if (cached) {
+		printk(BIOS_DEBUG, "OPROM_CACHE: Using cached ROM for %s\n", dev_path(dev));
+		return cached;
+	}
+
+	cached = add(dev->vendor, dev->device, revision, key, rom);
+	if (!cached)
+		return rom;
+
+	printk(BIOS_DEBUG, "OPROM_CACHE: Caching ROM for %s\n", dev_path(dev));
+	return cached;
+}
+
+/*
+ * All option ROMs have been loaded during device init. Append the new entries
+ * in one go, so the region is erased at most once per boot.
+ */
+static void write_oprom_cache(void *unused)
+{
+	struct region_device rdev;
+	size_t needed = 0, first_new = 0, i;
+
+	if (cache_state != CACHE_DIRTY)
+		return;
+
+	if (fmap_locate_area_as_rdev_rw(OPROM_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "OPROM_CACHE: Cannot access %s region\n", OPROM_CACHE_FMAP_NAME);
+		return;
+	}
+
+	while (first_new < num_entries && !roms[first_new].new)
+		first_new++;
+	for (i = first_new; i < num_entries; i++)
+		needed += sizeof(entries[0]) + entries[i].size;
+
+	if (erase_needed || used + needed > region_device_sz(&cache_rdev)) {
+		if (rdev_eraseat(&rdev, 0, region_device_sz(&cache_rdev)) < 0) {
+			printk(BIOS_ERR, "OPROM_CACHE: Cannot erase %s region\n",
+			       OPROM_CACHE_FMAP_NAME);
+			return;
+		}
+		/* Only keep the entries that are still in memory. */
+		memmove(&entries[0], &entries[first_new],
+			(num_entries - first_new) * sizeof(entries[0]));
+		memmove(&roms[0], &roms[first_new], (num_entries - first_new) * sizeof(roms[0]));
+		num_entries -= first_new;
+		first_new = 0;
+		used = 0;
+		erase_needed = false;
+	}
+
+	for (i = first_new; i < num_entries; i++) {
+		if (used + sizeof(entries[0]) + entries[i].size > region_device_sz(&cache_rdev))
+			break;
+
+		if (rdev_writeat(&rdev, roms[i].data, used + sizeof(entries[0]),
+				 entries[i].size) != entries[i].size ||
+		    rdev_writeat(&rdev, &entries[i], used, sizeof(entries[0])) !=
+				 sizeof(entries[0])) {
+			printk(BIOS_ERR, "OPROM_CACHE: Cannot write %s region\n",
+			       OPROM_CACHE_FMAP_NAME);
+			erase_needed = true;
+			return;
+		}
+
+		roms[i].offset = used + sizeof(entries[0]);
+		roms[i].new = false;
+		used += sizeof(entries[0]) + entries[i].size;
+	}
+	/* Entries that didn't fit are not part of the hash. */
+	num_entries = i;
+
+	if (CONFIG(PCI_OPROM_CACHE_HASH_TPM))
+		vbios_cache_update_hash((const uint8_t *)entries,
+					num_entries * sizeof(entries[0]));
+
+	printk(BIOS_INFO, "OPROM_CACHE: Updated %s region\n", OPROM_CACHE_FMAP_NAME);
+	cache_state = CACHE_CLEAN;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, write_oprom_cache, NULL);
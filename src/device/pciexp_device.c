@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <bootstate.h>
 #include <console/console.h>
 #include <commonlib/helpers.h>
 #include <delay.h>
@@ -8,6 +9,8 @@
 #include <device/pci_ids.h>
 #include <device/pci_ops.h>
 #include <device/pciexp.h>
+#include <timer.h>
+#include <timestamp.h>
 
 static unsigned int ext_cap_id(unsigned int cap)
 {
@@ -217,6 +220,183 @@ static int pciexp_retrain_link(struct device *dev, unsigned int cap)
 	return -1;
 }
 
+/*
+ * Links waiting to be retrained. Retraining of all queued links is started
+ * first and their completion is polled together afterwards, so the training
+ * time of many ports overlaps instead of adding up. Links are handled in
+ * order of their depth in the tree, so that a link is never retrained while
+ * the link above it is still training.
+ *
+ * Common Clock Configuration changes the L0s and L1 exit latencies the link
+ * reports, so ASPM, L1 Sub-States and LTR of the devices below a queued link
+ * are only configured after the link has been retrained.
+ */
+#define PCIE_MAX_PENDING_RETRAIN 64
+
+struct pciexp_pending_retrain {
+	struct device *dev;
+	unsigned int cap;
+	unsigned int depth;
+	bool started;
+	bool done;
+	struct stopwatch sw;
+};
+
+static struct pciexp_pending_retrain pending_retrain[PCIE_MAX_PENDING_RETRAIN];
+static size_t num_pending_retrain;
+static bool pending_retrain_flushed;
+
+#define PCIE_MAX_DEFERRED_TUNE 128
+
+static struct device *deferred_tune[PCIE_MAX_DEFERRED_TUNE];
+static size_t num_deferred_tune;
+
+static unsigned int pciexp_dev_depth(const struct device *dev)
+{
+	unsigned int depth = 0;
+
+	while (dev->upstream && dev->upstream->dev != dev) {
+		dev = dev->upstream->dev;
+		depth++;
+	}
+
+	return depth;
+}
+
+/* Returns true if the link was queued, false if it was retrained right away. */
+static bool pciexp_queue_retrain(struct device *dev, unsigned int cap)
+{
+	struct pciexp_pending_retrain *link;
+
+	/* Too late or too many links to batch, retrain right away */
+	if (pending_retrain_flushed || num_pending_retrain == ARRAY_SIZE(pending_retrain) ||
+	    num_deferred_tune == ARRAY_SIZE(deferred_tune)) {
+		pciexp_retrain_link(dev, cap);
+		return false;
+	}
+
+	/* The other functions of a multi-function device share the link. */
+	for (link = pending_retrain; link < &pending_retrain[num_pending_retrain]; link++) {
+		if (link->dev == dev)
+			return true;
+	}
+
+	link = &pending_retrain[num_pending_retrain++];
+	link->dev = dev;
+	link->cap = cap;
+	link->depth = pciexp_dev_depth(dev);
+	link->started = false;
+	link->done = false;
+	return true;
+}
+
+static bool pciexp_link_training(struct pciexp_pending_retrain *link)
+{
+	return pci_read_config16(link->dev, link->cap + PCI_EXP_LNKSTA) & PCI_EXP_LNKSTA_LT;
+}
+
+/*
+ * Retrain all queued links of the given depth with a shared deadline.
+ * Returns the number of links handled.
+ */
+static size_t pciexp_retrain_links_at_depth(unsigned int depth)
+{
+	struct pciexp_pending_retrain *link;
+	struct stopwatch deadline;
+	size_t handled = 0, pending;
+	u16 lnkctl;
+
+	/*
+	 * As in pciexp_retrain_link(), wait for any ongoing training to
+	 * finish before setting the Retrain Link bit. Start every link as
+	 * soon as it is idle.
+	 */
+	stopwatch_init_usecs_expire(&deadline, PCIE_TRAIN_RETRY * 100);
+	do {
+		pending = 0;
+		for (link = pending_retrain; link < &pending_retrain[num_pending_retrain];
+		     link++) {
+			if (link->depth != depth || link->started)
+				continue;
+			if (pciexp_link_training(link)) {
+				pending++;
+				continue;
+			}
+			lnkctl = pci_read_config16(link->dev, link->cap + PCI_EXP_LNKCTL);
+			pci_write_config16(link->dev, link->cap + PCI_EXP_LNKCTL,
+					   lnkctl | PCI_EXP_LNKCTL_RL);
+			stopwatch_init(&link->sw);
+			link->started = true;
+		}
+		if (pending)
+			udelay(100);
+	} while (pending && !stopwatch_expired(&deadline));
+
+	/* Wait for all started links to finish training */
+	stopwatch_init_usecs_expire(&deadline, PCIE_TRAIN_RETRY * 100);
+	do {
+		pending = 0;
+		for (link = pending_retrain; link < &pending_retrain[num_pending_retrain];
+		     link++) {
+			if (link->depth != depth || !link->started || link->done)
+				continue;
+			if (pciexp_link_training(link)) {
+				pending++;
+				continue;
+			}
+			link->done = true;
+			/* The log line identifies the port of the timestamp. */
+			timestamp_add_now(TS_PCIE_LINK_TRAINED);
+			printk(BIOS_INFO, "%s: Link retrained in %lld us\n",
+			       dev_path(link->dev), stopwatch_duration_usecs(&link->sw));
+		}
+		if (pending)
+			udelay(100);
+	} while (pending && !stopwatch_expired(&deadline));
+
+	for (link = pending_retrain; link < &pending_retrain[num_pending_retrain]; link++) {
+		if (link->depth != depth)
+			continue;
+		handled++;
+		if (!link->done)
+			printk(BIOS_ERR, "%s: Link Retrain timeout\n", dev_path(link->dev));
+	}
+
+	return handled;
+}
+
+static void pciexp_tune_link_pm(struct device *dev);
+
+static void pciexp_retrain_pending_links(void *unused)
+{
+	size_t handled = 0;
+
+	pending_retrain_flushed = true;
+
+	if (!num_pending_retrain)
+		return;
+
+	timestamp_add_now(TS_PCIE_RETRAIN_START);
+
+	for (unsigned int depth = 0; handled < num_pending_retrain; depth++)
+		handled += pciexp_retrain_links_at_depth(depth);
+
+	timestamp_add_now(TS_PCIE_RETRAIN_END);
+
+	printk(BIOS_INFO, "PCIe: Retrained %zu links\n", num_pending_retrain);
+	num_pending_retrain = 0;
+
+	for (size_t i = 0; i < num_deferred_tune; i++)
+		pciexp_tune_link_pm(deferred_tune[i]);
+	num_deferred_tune = 0;
+}
+
+/*
+ * Common Clock Configuration only takes effect after retraining, so the
+ * retraining of all links is deferred until enumeration has finished.
+ */
+BOOT_STATE_INIT_ENTRY(BS_DEV_ENUMERATE, BS_ON_EXIT, pciexp_retrain_pending_links, NULL);
+
 static bool pciexp_is_ccc_active(struct device *root, unsigned int root_cap,
 				 struct device *endp, unsigned int endp_cap)
 {
@@ -234,16 +414,17 @@ static bool pciexp_is_ccc_active(struct device *root, unsigned int root_cap,
 /*
  * Check the Slot Clock Configuration for root port and endpoint
  * and enable Common Clock Configuration if possible.  If CCC is
- * enabled the link must be retrained.
+ * enabled the link must be retrained. Returns true if retraining
+ * the link was deferred.
  */
-static void pciexp_enable_common_clock(struct device *root, unsigned int root_cap,
+static bool pciexp_enable_common_clock(struct device *root, unsigned int root_cap,
 				       struct device *endp, unsigned int endp_cap)
 {
 	u16 root_scc, endp_scc, lnkctl;
 
 	/* No need to enable common clock if it is already active. */
 	if (pciexp_is_ccc_active(root, root_cap, endp, endp_cap))
-		return;
+		return false;
 
 	/* Get Slot Clock Configuration for root port */
 	root_scc = pci_read_config16(root, root_cap + PCI_EXP_LNKSTA);
@@ -268,8 +449,10 @@ static void pciexp_enable_common_clock(struct device *root, unsigned int root_ca
 		pci_write_config16(root, root_cap + PCI_EXP_LNKCTL, lnkctl);
 
 		/* Retrain link if CCC was enabled */
-		pciexp_retrain_link(root, root_cap);
+		return pciexp_queue_retrain(root, root_cap);
 	}
+
+	return false;
 }
 
 static void pciexp_enable_clock_power_pm(struct device *endp, unsigned int endp_cap)
@@ -661,6 +844,155 @@ static void pciexp_configure_max_payload_size(struct device *parent, struct devi
 	}
 }
 
+static void pciexp_dev_set_max_read_request_size(struct device *dev, unsigned int mrrs)
+{
+	unsigned int pcie_cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+
+	if (!pcie_cap)
+		return;
+
+	pci_update_config16(dev, pcie_cap + PCI_EXP_DEVCTL, ~PCI_EXP_DEVCTL_READRQ,
+			    mrrs << 12);
+}
+
+static bool pciexp_has_cap2(struct device *dev, unsigned int cap)
+{
+	return (pci_read_config16(dev, cap + PCI_EXP_FLAGS) & PCI_EXP_FLAGS_VERS) >= 2;
+}
+
+/*
+ * Walk from `dev` up to its root port and check that `allowed` holds for
+ * every PCIe device on the way.
+ */
+static bool pciexp_path_allows(struct device *dev,
+			       bool (*allowed)(struct device *dev, unsigned int cap))
+{
+	unsigned int cap;
+
+	while (dev && dev->path.type == DEVICE_PATH_PCI) {
+		cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+		if (!cap || !allowed(dev, cap))
+			return false;
+		if (pcie_is_root_port(dev))
+			break;
+		dev = dev->upstream ? dev->upstream->dev : NULL;
+	}
+
+	return true;
+}
+
+static bool pciexp_10bit_tag_allowed(struct device *dev, unsigned int cap)
+{
+	const unsigned int type =
+		(pci_read_config16(dev, cap + PCI_EXP_FLAGS) & PCI_EXP_FLAGS_TYPE) >> 4;
+
+	/* Only the ports forwarding the requests need to be 10-Bit Tag Completers */
+	if (type != PCI_EXP_TYPE_UPSTREAM && !pciexp_is_downstream_port(type))
+		return true;
+
+	return pciexp_has_cap2(dev, cap) &&
+	       (pci_read_config32(dev, cap + PCI_EXP_DEVCAP2) & PCI_EXP_DEVCAP2_10BIT_TAG_COMP);
+}
+
+/*
+ * There is no capability bit for ID-Based Ordering, functions that don't
+ * support it hardwire the enable bits to 0. Probe them and restore DEVCTL2.
+ */
+static bool pciexp_ido_supported(struct device *dev, unsigned int cap)
+{
+	const u16 ido = PCI_EXP_DEV2_IDO_REQ | PCI_EXP_DEV2_IDO_CMP;
+	u16 devctl2;
+	bool supported;
+
+	if (!cap || !pciexp_has_cap2(dev, cap))
+		return false;
+
+	devctl2 = pci_read_config16(dev, cap + PCI_EXP_DEVCTL2);
+	if ((devctl2 & ido) == ido)
+		return true;
+
+	pci_write_config16(dev, cap + PCI_EXP_DEVCTL2, devctl2 | ido);
+	supported = (pci_read_config16(dev, cap + PCI_EXP_DEVCTL2) & ido) == ido;
+	pci_write_config16(dev, cap + PCI_EXP_DEVCTL2, devctl2);
+
+	return supported;
+}
+
+/*
+ * Configure the Device Control fields that affect throughput: Extended and
+ * 10-Bit Tags, Relaxed Ordering, ID-Based Ordering and Max Read Request
+ * Size. Fields whose option is disabled are left as they are. ID-Based
+ * Ordering is enabled on `dev` and its upstream port `root` together, so
+ * it is skipped when `root` is NULL.
+ */
+static void pciexp_configure_throughput(struct device *root, unsigned int root_cap,
+					struct device *dev, unsigned int cap)
+{
+	const u32 devcap = pci_read_config32(dev, cap + PCI_EXP_DEVCAP);
+	const u16 old_devctl = pci_read_config16(dev, cap + PCI_EXP_DEVCTL);
+	u16 old_devctl2 = 0;
+	u32 devcap2 = 0;
+	u16 devctl = old_devctl;
+	u16 devctl2;
+
+	if (pciexp_has_cap2(dev, cap)) {
+		devcap2 = pci_read_config32(dev, cap + PCI_EXP_DEVCAP2);
+		old_devctl2 = pci_read_config16(dev, cap + PCI_EXP_DEVCTL2);
+	}
+	devctl2 = old_devctl2;
+
+	if (CONFIG(PCIEXP_EXTENDED_TAG)) {
+		if (devcap & PCI_EXP_DEVCAP_EXT_TAG)
+			devctl |= PCI_EXP_DEVCTL_EXT_TAG;
+		else
+			devctl &= ~PCI_EXP_DEVCTL_EXT_TAG;
+	}
+
+	if (CONFIG(PCIEXP_10BIT_TAG) && devcap2) {
+		if ((devctl & PCI_EXP_DEVCTL_EXT_TAG) &&
+		    (devcap2 & PCI_EXP_DEVCAP2_10BIT_TAG_REQ) &&
+		    pciexp_path_allows(dev, pciexp_10bit_tag_allowed))
+			devctl2 |= PCI_EXP_DEV2_10BIT_TAG_REQ;
+		else
+			devctl2 &= ~PCI_EXP_DEV2_10BIT_TAG_REQ;
+	}
+
+	if (CONFIG(PCIEXP_RELAXED_ORDERING))
+		devctl |= PCI_EXP_DEVCTL_RELAX_EN;
+
+	/* Both ends of the link have to support ID-Based Ordering */
+	if (CONFIG(PCIEXP_ID_BASED_ORDERING) && root && pciexp_ido_supported(dev, cap) &&
+	    pciexp_ido_supported(root, root_cap)) {
+		devctl2 |= PCI_EXP_DEV2_IDO_REQ | PCI_EXP_DEV2_IDO_CMP;
+		pci_or_config16(root, root_cap + PCI_EXP_DEVCTL2,
+				PCI_EXP_DEV2_IDO_REQ | PCI_EXP_DEV2_IDO_CMP);
+	}
+
+	if (CONFIG(PCIEXP_MRRS_MAX)) {
+		devctl &= ~PCI_EXP_DEVCTL_READRQ;
+		devctl |= 5 << 12;
+	} else if (CONFIG(PCIEXP_MRRS_MPS)) {
+		devctl &= ~PCI_EXP_DEVCTL_READRQ;
+		devctl |= (devctl & PCI_EXP_DEVCTL_PAYLOAD) << 7;
+	}
+
+	if (devctl == old_devctl && devctl2 == old_devctl2)
+		return;
+
+	if (devctl != old_devctl)
+		pci_write_config16(dev, cap + PCI_EXP_DEVCTL, devctl);
+	if (devctl2 != old_devctl2)
+		pci_write_config16(dev, cap + PCI_EXP_DEVCTL2, devctl2);
+
+	printk(BIOS_DEBUG, "%s: ExtTag %s, 10-bit Tag %s, RO %s, IDO %s, MRRS %d\n",
+	       dev_path(dev),
+	       devctl & PCI_EXP_DEVCTL_EXT_TAG ? "on" : "off",
+	       devctl2 & PCI_EXP_DEV2_10BIT_TAG_REQ ? "on" : "off",
+	       devctl & PCI_EXP_DEVCTL_RELAX_EN ? "on" : "off",
+	       devctl2 & PCI_EXP_DEV2_IDO_REQ ? "on" : "off",
+	       1 << (((devctl & PCI_EXP_DEVCTL_READRQ) >> 12) + 7));
+}
+
 /*
  * Clear Lane Error State at the end of PCIe link training.
  * Lane error status is cleared if PCIEXP_LANE_ERR_STAT_CLEAR is set.
@@ -685,10 +1017,25 @@ static void clear_lane_error_status(struct device *dev)
 	pci_write_config32(dev, pos + PCI_EXP_SEC_LANE_ERR_STATUS, reg32);
 }
 
+/* Configure the link power management that depends on the link's exit latencies. */
+static void pciexp_tune_link_pm(struct device *dev)
+{
+	struct device *root = dev->upstream->dev;
+	const unsigned int cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+	const unsigned int root_cap = pci_find_capability(root, PCI_CAP_ID_PCIE);
+
+	if (CONFIG(PCIEXP_L1_SUB_STATE))
+		pciexp_config_L1_sub_state(root, dev);
+
+	if (CONFIG(PCIEXP_ASPM))
+		pciexp_enable_aspm(root, root_cap, dev, cap);
+}
+
 static void pciexp_tune_dev(struct device *dev)
 {
 	struct device *root = dev->upstream->dev;
 	unsigned int root_cap, cap;
+	bool pm_deferred = false;
 
 	cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
 	if (!cap)
@@ -700,18 +1047,26 @@ static void pciexp_tune_dev(struct device *dev)
 
 	/* Check for and enable Common Clock */
 	if (CONFIG(PCIEXP_COMMON_CLOCK))
-		pciexp_enable_common_clock(root, root_cap, dev, cap);
+		pm_deferred = pciexp_enable_common_clock(root, root_cap, dev, cap);
 
 	/* Check if per port CLK req is supported by endpoint*/
 	if (CONFIG(PCIEXP_CLK_PM))
 		pciexp_enable_clock_power_pm(dev, cap);
 
+	/*
+	 * The exit latencies are only valid once the link has been retrained. LTR
+	 * doesn't depend on them and is still enabled below, as the devices further
+	 * down only get LTR enabled if their parent has it enabled.
+	 */
+	if (pm_deferred)
+		deferred_tune[num_deferred_tune++] = dev;
+
 	/* Enable L1 Sub-State when both root port and endpoint support */
-	if (CONFIG(PCIEXP_L1_SUB_STATE))
+	if (CONFIG(PCIEXP_L1_SUB_STATE) && !pm_deferred)
 		pciexp_config_L1_sub_state(root, dev);
 
 	/* Check for and enable ASPM */
-	if (CONFIG(PCIEXP_ASPM))
+	if (CONFIG(PCIEXP_ASPM) && !pm_deferred)
 		pciexp_enable_aspm(root, root_cap, dev, cap);
 
 	/* Clear PCIe Lane Error Status */
@@ -725,6 +1080,8 @@ static void pciexp_tune_dev(struct device *dev)
 	/* Limit the parent's Max Payload Size if needed */
 	pciexp_configure_max_payload_size(root, dev);
 
+	pciexp_configure_throughput(root, root_cap, dev, cap);
+
 	pciexp_configure_ltr(root, root_cap, dev, cap);
 }
 
@@ -738,6 +1095,8 @@ static void pciexp_sync_max_payload_size(struct bus *bus, unsigned int max_paylo
 			continue;
 
 		pciexp_dev_set_max_payload_size(child, max_payload);
+		if (CONFIG(PCIEXP_MRRS_MPS))
+			pciexp_dev_set_max_read_request_size(child, max_payload);
 
 		if (child->downstream)
 			pciexp_sync_max_payload_size(child->downstream, max_payload);
@@ -759,6 +1118,10 @@ void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 	max_payload = pciexp_dev_get_max_payload_size_cap(bus->dev);
 	pciexp_dev_set_max_payload_size(bus->dev, max_payload);
 
+	const unsigned int bridge_cap = pci_find_capability(bus->dev, PCI_CAP_ID_PCIE);
+	if (bridge_cap)
+		pciexp_configure_throughput(NULL, 0, bus->dev, bridge_cap);
+
 	pci_scan_bus(bus, min_devfn, max_devfn);
 
 	for (child = bus->children; child; child = child->sibling) {
@@ -786,6 +1149,8 @@ void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 				  " root port\n", dev_path(bus->dev), 1 << (max_payload + 7));
 
 		pciexp_sync_max_payload_size(bus, max_payload);
+		if (CONFIG(PCIEXP_MRRS_MPS))
+			pciexp_dev_set_max_read_request_size(bus->dev, max_payload);
 	}
 }
 
@@ -217,8 +217,7 @@ struct efi_find_args {
 	void *data;
 };
 
-static bool match(struct region_device *rdev, VARIABLE_HEADER *hdr, size_t hdr_size,
-		  const char *name, const EFI_GUID *guid)
+static bool is_valid(const VARIABLE_HEADER *hdr, const EFI_GUID *guid)
 {
 	/* Only search for valid or in transition to be deleted variables */
 	if ((hdr->State != VAR_ADDED) &&
@@ -230,6 +229,15 @@ static bool match(struct region_device *rdev, VARIABLE_HEADER *hdr, size_t hdr_s
 	    !hdr->DataSize)
 		return false;
 
+	return true;
+}
+
+static bool match(struct region_device *rdev, VARIABLE_HEADER *hdr, size_t hdr_size,
+		  const char *name, const EFI_GUID *guid)
+{
+	if (!is_valid(hdr, guid))
+		return false;
+
 	if (rdev_strcmp_wchar_ascii(rdev, hdr_size, name) != 0)
 		return false;
 
@@ -285,6 +293,41 @@ enum cb_err find_and_compare(struct region_device *rdev, VARIABLE_HEADER *hdr, s
 	return CB_SUCCESS;
 }
 
+struct efi_walk_options_args {
+	const EFI_GUID *guid;
+	efi_fv_option_walker walker;
+	void *arg;
+};
+
+static enum cb_err walk_option(struct region_device *rdev, VARIABLE_HEADER *hdr,
+			       size_t hdr_size, void *arg, bool *stop)
+{
+	struct efi_walk_options_args *wa = (struct efi_walk_options_args *)arg;
+	CHAR16 wname[EFI_FV_NAME_MAX];
+	char name[EFI_FV_NAME_MAX];
+	const char *ascii = NULL;
+	size_t i;
+
+	if (!is_valid(hdr, wa->guid))
+		return CB_SUCCESS;
+
+	/* Read the whole name at once, not one character at a time. */
+	if (hdr->NameSize <= sizeof(wname)) {
+		if (rdev_readat(rdev, wname, hdr_size, hdr->NameSize) != hdr->NameSize)
+			return CB_EFI_ACCESS_ERROR;
+
+		for (i = 0; i < hdr->NameSize / sizeof(CHAR16) && wname[i] < 0x80; i++) {
+			name[i] = wname[i];
+			if (!name[i]) {
+				ascii = name;
+				break;
+			}
+		}
+	}
+
+	return wa->walker(rdev, ascii, hdr_size + hdr->NameSize, hdr->DataSize, wa->arg);
+}
+
 static enum cb_err noop(struct region_device *rdev, VARIABLE_HEADER *hdr, size_t hdr_size,
 			void *arg, bool *stop)
 {
@@ -447,6 +490,30 @@ enum cb_err efi_fv_get_option(struct region_device *rdev,
 	return walk_variables(rdev, auth_format, find_and_copy, &args);
 }
 
+enum cb_err efi_fv_walk_options(struct region_device *rdev,
+				const EFI_GUID *guid,
+				efi_fv_option_walker walker,
+				void *arg)
+{
+	struct efi_walk_options_args args;
+	bool auth_format;
+	enum cb_err ret;
+
+	ret = efi_fv_init(rdev, &auth_format);
+	if (ret != CB_SUCCESS)
+		return ret;
+
+	args.guid = guid;
+	args.walker = walker;
+	args.arg = arg;
+
+	ret = walk_variables(rdev, auth_format, walk_option, &args);
+	if (ret == CB_EFI_OPTION_NOT_FOUND)
+		return CB_SUCCESS;
+
+	return ret;
+}
+
 static enum cb_err write_auth_hdr(struct region_device *rdev, const EFI_GUID *guid,
 				  const char *name, void *data, size_t size)
 {
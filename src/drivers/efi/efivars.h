@@ -44,4 +44,31 @@ enum cb_err efi_fv_set_option(struct region_device *rdev,
 
 enum cb_err efi_fv_print_options(struct region_device *rdev);
 
+/* Size of the longest variable name efi_fv_walk_options() passes on, including the NUL */
+#define EFI_FV_NAME_MAX	64
+
+typedef enum cb_err (*efi_fv_option_walker)(struct region_device *rdev,
+					    const char *name,
+					    size_t data_offset,
+					    uint32_t data_size,
+					    void *arg);
+
+/**
+ * efi_fv_walk_options
+ * Call the walker for every valid variable with the given vendor guid in a single pass
+ * over the variable store. Variables appear in the order of the store, so an older copy
+ * of a variable being updated comes first.
+ * The walker gets the region of the variable, its data offset and size within the
+ * region, and its name. The name is NULL if it isn't ASCII or longer than
+ * EFI_FV_NAME_MAX - 1 characters.
+ * @rdev: the readable region to operate on
+ * @guid: the vendor guid to look for
+ * @walker: the function to call for every variable
+ * @arg: passed on to the walker
+ */
+enum cb_err efi_fv_walk_options(struct region_device *rdev,
+				const EFI_GUID *guid,
+				efi_fv_option_walker walker,
+				void *arg);
+
 #endif /* _EDK2_OPTION_H_ */
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <cbmem.h>
+#include <console/console.h>
 #include <stdlib.h>
 #include <string.h>
 #include <option.h>
@@ -12,6 +14,165 @@
 static const EFI_GUID EficorebootNvDataGuid = {
 	0xceae4c1d, 0x335b, 0x4685, { 0xa4, 0xa0, 0xfc, 0x4a, 0x94, 0xee, 0xa0, 0x85 } };
 
+/*
+ * Index of the coreboot options in the variable store, built in a single pass over the
+ * store and kept in CBMEM for the later stages. Options are read as uint32_t, so the
+ * values are stored in the index and the store isn't accessed again on a hit.
+ * SMM doesn't use the index. It can't trust CBMEM, and at runtime the store is updated
+ * through SMMSTORE without going through this file.
+ */
+#define OPTION_INDEX_SIGNATURE	0x58444f45	/* 'EODX' */
+#define OPTION_INDEX_ENTRIES	32
+#define OPTION_NAME_SIZE	32
+
+struct option_index {
+	uint32_t signature;
+	uint32_t count;
+	uint32_t incomplete;	/* Not all options fit, so a miss isn't final */
+	struct {
+		char name[OPTION_NAME_SIZE];
+		uint32_t size;
+		uint32_t value;	/* Only valid if size <= sizeof(value) */
+	} entries[OPTION_INDEX_ENTRIES];
+};
+
+static struct option_index pre_cbmem_index;
+static struct option_index *opt_index;
+
+static int option_index_find(const struct option_index *idx, const char *name)
+{
+	for (uint32_t i = 0; i < idx->count; i++) {
+		if (!strcmp(idx->entries[i].name, name))
+			return i;
+	}
+
+	return -1;
+}
+
+static void option_index_set(struct option_index *idx, const char *name, const void *data,
+			     uint32_t size)
+{
+	int i = option_index_find(idx, name);
+
+	if (i < 0) {
+		if (strlen(name) >= OPTION_NAME_SIZE || idx->count == OPTION_INDEX_ENTRIES) {
+			idx->incomplete = 1;
+			return;
+		}
+		i = idx->count++;
+		strcpy(idx->entries[i].name, name);
+	}
+
+	idx->entries[i].size = size;
+	idx->entries[i].value = 0;
+	if (size <= sizeof(idx->entries[i].value))
+		memcpy(&idx->entries[i].value, data, size);
+}
+
+static enum cb_err index_option(struct region_device *rdev, const char *name,
+				size_t data_offset, uint32_t data_size, void *arg)
+{
+	struct option_index *idx = arg;
+	uint32_t value = 0;
+
+	if (!name) {
+		idx->incomplete = 1;
+		return CB_SUCCESS;
+	}
+
+	/* The first copy of an option wins, as in efi_fv_get_option(). */
+	if (option_index_find(idx, name) >= 0)
+		return CB_SUCCESS;
+
+	if (data_size <= sizeof(value) &&
+	    rdev_readat(rdev, &value, data_offset, data_size) != data_size)
+		return CB_EFI_ACCESS_ERROR;
+
+	option_index_set(idx, name, &value, data_size);
+	return CB_SUCCESS;
+}
+
+static struct option_index *option_index_get(const struct region_device *store)
+{
+	struct region_device rdev = *store;
+
+	if (ENV_SMM)
+		return NULL;
+
+	if (!opt_index && cbmem_online())
+		opt_index = cbmem_find(CBMEM_ID_EFI_OPTION_INDEX);
+	if (!opt_index)
+		opt_index = &pre_cbmem_index;
+
+	if (opt_index->signature == OPTION_INDEX_SIGNATURE)
+		return opt_index;
+
+	memset(opt_index, 0, sizeof(*opt_index));
+	if (efi_fv_walk_options(&rdev, &EficorebootNvDataGuid, index_option, opt_index) !=
+	    CB_SUCCESS)
+		return NULL;
+
+	printk(BIOS_DEBUG, "EFI options: Indexed %u options%s\n", opt_index->count,
+	       opt_index->incomplete ? ", index incomplete" : "");
+	opt_index->signature = OPTION_INDEX_SIGNATURE;
+	return opt_index;
+}
+
+/* Returns CB_ERR if the index doesn't know about the option. */
+static enum cb_err option_index_lookup(const struct region_device *store, const char *name,
+				       void *dest, uint32_t *size)
+{
+	const struct option_index *idx = option_index_get(store);
+	int i;
+
+	if (!idx)
+		return CB_ERR;
+
+	i = option_index_find(idx, name);
+	if (i < 0)
+		return idx->incomplete ? CB_ERR : CB_EFI_OPTION_NOT_FOUND;
+
+	if (*size < idx->entries[i].size)
+		return CB_EFI_BUFFER_TOO_SMALL;
+
+	memcpy(dest, &idx->entries[i].value, idx->entries[i].size);
+	*size = idx->entries[i].size;
+	return CB_SUCCESS;
+}
+
+static void option_index_update(const char *name, const void *data, uint32_t size,
+				enum cb_err ret)
+{
+	if (ENV_SMM || !opt_index || opt_index->signature != OPTION_INDEX_SIGNATURE)
+		return;
+
+	/* A failed write may have left the store in any state. */
+	if (ret != CB_SUCCESS)
+		opt_index->signature = 0;
+	else
+		option_index_set(opt_index, name, data, size);
+}
+
+/* Move the index to CBMEM, replacing the one of the previous boot after S3 resume. */
+static void option_index_to_cbmem(int is_recovery)
+{
+	struct option_index *idx;
+
+	if (!ENV_CREATES_CBMEM)
+		return;
+
+	idx = cbmem_add(CBMEM_ID_EFI_OPTION_INDEX, sizeof(*idx));
+	if (!idx)
+		return;
+
+	if (opt_index)
+		memcpy(idx, opt_index, sizeof(*idx));
+	else
+		idx->signature = 0;
+	opt_index = idx;
+}
+CBMEM_READY_HOOK(option_index_to_cbmem);
+
 unsigned int get_uint_option(const char *name, const unsigned int fallback)
 {
 	struct region_device rdev;
@@ -24,7 +185,9 @@ unsigned int get_uint_option(const char *name, const unsigned int fallback)
 
 	var = 0;
 	size = sizeof(var);
-	ret = efi_fv_get_option(&rdev, &EficorebootNvDataGuid, name, &var, &size);
+	ret = option_index_lookup(&rdev, name, &var, &size);
+	if (ret == CB_ERR)
+		ret = efi_fv_get_option(&rdev, &EficorebootNvDataGuid, name, &var, &size);
 	if (ret != CB_SUCCESS)
 		return fallback;
 
@@ -35,9 +198,13 @@ enum cb_err set_uint_option(const char *name, unsigned int value)
 {
 	struct region_device rdev;
 	uint32_t var = value;
+	enum cb_err ret;
 
 	if (smmstore_lookup_region(&rdev))
 		return CB_CMOS_OTABLE_DISABLED;
 
-	return efi_fv_set_option(&rdev, &EficorebootNvDataGuid, name, &var, sizeof(var));
+	ret = efi_fv_set_option(&rdev, &EficorebootNvDataGuid, name, &var, sizeof(var));
+	option_index_update(name, &var, sizeof(var), ret);
+
+	return ret;
 }
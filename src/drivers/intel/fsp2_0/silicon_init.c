@@ -190,7 +190,9 @@ static void do_silicon_init(struct fsp_header *hdr)
 		multi_phase_params.multi_phase_action = EXECUTE_PHASE;
 		multi_phase_params.phase_index = i;
 		multi_phase_params.multi_phase_param_ptr = NULL;
+		timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START);
 		status = multi_phase_si_init(&multi_phase_params);
+		timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_END);
 		if (CONFIG(FSP_MULTIPHASE_SI_INIT_RETURN_BROKEN))
 			status = fsp_get_pch_reset_status();
 		fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_EXECUTE_PHASE_API, status);
@@ -3,6 +3,7 @@
 #include <delay.h>
 #include <device/i2c_simple.h>
 #include <edid.h>
+#include <edid_cache.h>
 #include <console/console.h>
 #include <timer.h>
 #include <dp_aux.h>
@@ -14,9 +15,19 @@ int ps8640_get_edid(uint8_t bus, uint8_t chip, struct edid *out)
 	u8 edid[EDID_LENGTH * 2];
 	int edid_size = EDID_LENGTH;
 
+	const uint32_t connector = bus << 8 | chip;
+
 	i2c_writeb(bus, chip + 2, PAGE2_I2C_BYPASS,
 		   EDID_I2C_ADDR | I2C_BYPASS_EN);
-	ret = i2c_read_bytes(bus, EDID_I2C_ADDR, 0, edid, EDID_LENGTH);
+
+	/* Read the panel identity first, the rest is only needed on a cache miss. */
+	ret = i2c_read_bytes(bus, EDID_I2C_ADDR, 0, edid, EDID_CACHE_ID_LENGTH);
+	if (ret == 0 && edid_cache_lookup(connector, edid, out) == 0)
+		return 0;
+	if (ret == 0)
+		ret = i2c_read_bytes(bus, EDID_I2C_ADDR, EDID_CACHE_ID_LENGTH,
+				     &edid[EDID_CACHE_ID_LENGTH],
+				     EDID_LENGTH - EDID_CACHE_ID_LENGTH);
 
 	if (ret != 0) {
 		printk(BIOS_INFO, "Failed to read EDID.\n");
@@ -39,6 +50,7 @@ int ps8640_get_edid(uint8_t bus, uint8_t chip, struct edid *out)
 		return -1;
 	}
 
+	edid_cache_update(connector, edid, out);
 	return 0;
 }
 
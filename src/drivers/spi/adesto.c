@@ -92,6 +92,8 @@ const struct spi_flash_vendor_info spi_flash_adesto_vi = {
 	.id = VENDOR_ID_ADESTO,
 	.page_size_shift = 8,
 	.sector_size_kib_shift = 2,
+	.block_erase_32k = 1,
+	.block_erase_64k = 1,
 	.match_id_mask[0] = 0xffff,
 	.ids = flash_table,
 	.nr_part_ids = ARRAY_SIZE(flash_table),
@@ -5,6 +5,7 @@
 #include <fmap.h>
 #include <console/console.h>
 #include <console/flash.h>
+#include <string.h>
 #include <types.h>
 
 #define LINE_BUFFER_SIZE 128
@@ -83,6 +84,38 @@ void flashconsole_tx_byte(unsigned char c)
 	}
 }
 
+void flashconsole_tx_bytes(const void *data, size_t len)
+{
+	const uint8_t *src = data;
+
+	if (!rdev_ptr)
+		return;
+
+	size_t region_size = region_device_sz(rdev_ptr);
+
+	while (len) {
+		size_t chunk = MIN(len, LINE_BUFFER_SIZE - line_offset);
+		const uint8_t *newline = memchr(src, '\n', chunk);
+
+		/* Nothing left to do if a previous flush failed. */
+		if (!chunk)
+			return;
+
+		if (newline)
+			chunk = newline - src + 1;
+
+		memcpy(&line_buffer[line_offset], src, chunk);
+		line_offset += chunk;
+		src += chunk;
+		len -= chunk;
+
+		if (line_offset >= LINE_BUFFER_SIZE ||
+		    offset + line_offset >= region_size || newline) {
+			flashconsole_tx_flush();
+		}
+	}
+}
+
 void flashconsole_tx_flush(void)
 {
 	size_t len = line_offset;
@@ -20,6 +20,8 @@ const struct spi_flash_vendor_info spi_flash_issi_vi = {
 	.id = VENDOR_ID_ISSI,
 	.page_size_shift = 8,        // 256 byte page size
 	.sector_size_kib_shift = 2,  // 4 Kbyte sector size
+	.block_erase_32k = 1,
+	.block_erase_64k = 1,
 	.match_id_mask[0] = 0xffff,
 	.ids = flash_table,
 	.nr_part_ids = ARRAY_SIZE(flash_table),
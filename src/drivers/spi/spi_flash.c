@@ -241,9 +241,43 @@ int spi_flash_cmd_wait_ready(const struct spi_flash *flash,
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+/* Returns true if the range reads as erased. Stops at the first programmed byte. */
+static bool spi_flash_range_blank(const struct spi_flash *flash, u32 offset, size_t len)
+{
+	u8 buf[256];
+	size_t chunk, i;
+
+	while (len) {
+		chunk = MIN(len, sizeof(buf));
+		if (flash->ops->read(flash, offset, chunk, buf))
+			return false;
+		for (i = 0; i < chunk; i++) {
+			if (buf[i] != 0xff)
+				return false;
+		}
+		offset += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
 int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 {
+	/* Erase operations of the part, largest first */
+	const struct {
+		u32 size;
+		u8 cmd;
+	} erase_ops[] = {
+		{ 64 * KiB, flash->erase_cmd_64k },
+		{ 32 * KiB, flash->erase_cmd_32k },
+		{ flash->sector_size, flash->erase_cmd },
+	};
 	u32 start, end, erase_size;
+	unsigned int erased = 0, skipped = 0;
+	unsigned long timeout;
+	struct stopwatch sw;
+	size_t i;
 	int ret = -1;
 	u8 cmd[4 + ADDR_MOD];
 
@@ -257,11 +291,29 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		return -1;
 	}
 
-	cmd[0] = flash->erase_cmd;
 	start = offset;
 	end = start + len;
+	stopwatch_init(&sw);
 
 	while (offset < end) {
+		/* Cover the range with the fewest operations that stay inside it. */
+		for (i = 0; i < ARRAY_SIZE(erase_ops) - 1; i++) {
+			if (erase_ops[i].cmd && erase_ops[i].size > flash->sector_size &&
+			    offset % erase_ops[i].size == 0 && end - offset >= erase_ops[i].size)
+				break;
+		}
+		erase_size = erase_ops[i].size;
+		cmd[0] = erase_ops[i].cmd;
+		timeout = erase_size > flash->sector_size ? SPI_FLASH_BLOCK_ERASE_TIMEOUT_MS
+							   : SPI_FLASH_PAGE_ERASE_TIMEOUT_MS;
+
+		if (CONFIG(SPI_FLASH_ERASE_BLANK_CHECK) &&
+		    spi_flash_range_blank(flash, offset, erase_size)) {
+			offset += erase_size;
+			skipped++;
+			continue;
+		}
+
 		spi_flash_addr(offset, cmd);
 		offset += erase_size;
 
@@ -282,13 +334,16 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_wait_ready(flash,
-				SPI_FLASH_PAGE_ERASE_TIMEOUT_MS);
+		ret = spi_flash_cmd_wait_ready(flash, timeout);
 		if (ret)
 			goto out;
+		erased++;
 	}
+	ret = 0;
 
-	printk(BIOS_DEBUG, "SF: Successfully erased %zu bytes @ %#x\n", len, start);
+	printk(BIOS_DEBUG, "SF: Successfully erased %zu bytes @ %#x in %lld ms "
+	       "(%u erase commands, %u blank blocks skipped)\n", len, start,
+	       stopwatch_duration_msecs(&sw), erased, skipped);
 
 out:
 	return ret;
@@ -415,6 +470,10 @@ static int fill_spi_flash(const struct spi_slave *spi, struct spi_flash *flash,
 	flash->sector_size = (1U << vi->sector_size_kib_shift) * KiB;
 	flash->size = flash->sector_size * (1U << part->nr_sectors_shift);
 	flash->erase_cmd = vi->desc->erase_cmd;
+	if (vi->block_erase_32k && flash->sector_size < 32 * KiB)
+		flash->erase_cmd_32k = CMD_BLOCK_ERASE_32K;
+	if (vi->block_erase_64k && flash->sector_size < 64 * KiB)
+		flash->erase_cmd_64k = CMD_BLOCK_ERASE;
 	flash->status_cmd = vi->desc->status_cmd;
 	flash->pp_cmd = vi->desc->pp_cmd;
 	flash->wren_cmd = vi->desc->wren_cmd;
@@ -21,6 +21,7 @@
 #define CMD_WRITE_ENABLE		0x06
 
 #define CMD_BLOCK_ERASE			0xD8
+#define CMD_BLOCK_ERASE_32K		0x52
 
 #define CMD_EXIT_4BYTE_ADDR_MODE	0xe9
 
@@ -96,6 +97,9 @@ struct spi_flash_vendor_info {
 	uint8_t page_size_shift : 4; /* if page programming oriented. */
 	/* Log based 2 sector size */
 	uint8_t sector_size_kib_shift : 4;
+	/* Supports the 32 KiB (0x52) and 64 KiB (0xd8) block erase commands */
+	uint8_t block_erase_32k : 1;
+	uint8_t block_erase_64k : 1;
 	uint16_t nr_part_ids;
 	const struct spi_flash_part_id *ids;
 	uint16_t match_id_mask[2]; /* matching bytes of the id for this set*/
@@ -31,6 +31,39 @@ struct vpd_cbmem {
 	 */
 };
 
+/*
+ * Sorted key index over the VPD copy in CBMEM, built once when CBMEM comes
+ * up. RO entries come first, followed by RW entries. Within each region the
+ * entries are sorted by key; for duplicate keys only the first occurrence is
+ * kept, which is what a linear decode would return. Offsets are relative to
+ * vpd_cbmem.blob.
+ */
+enum {
+	CROSVPD_INDEX_MAGIC = 0x58444e49,
+	CROSVPD_INDEX_VERSION = 0x0001,
+};
+
+struct vpd_index_entry {
+	uint32_t key_offset;
+	uint32_t key_len;
+	uint32_t value_offset;
+	uint32_t value_len;
+};
+
+struct vpd_index {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ro_count;
+	uint32_t rw_count;
+	struct vpd_index_entry entries[];
+};
+
+struct vpd_index_arg {
+	const uint8_t *blob;
+	struct vpd_index_entry *entries;
+	uint32_t count;
+};
+
 struct vpd_gets_arg {
 	const uint8_t *key;
 	const uint8_t *value;
@@ -122,6 +155,115 @@ static void init_vpd_rdevs(void)
 	done = true;
 }
 
+static int vpd_count_callback(const uint8_t *key, uint32_t key_len,
+			      const uint8_t *value, uint32_t value_len,
+			      void *arg)
+{
+	(*(uint32_t *)arg)++;
+	return VPD_DECODE_OK;
+}
+
+static uint32_t vpd_count_entries(const uint8_t *blob, uint32_t size)
+{
+	uint32_t consumed = 0;
+	uint32_t count = 0;
+
+	while (vpd_decode_string(size, blob, &consumed, vpd_count_callback,
+		&count) == VPD_DECODE_OK) {
+	/* Count all entries. */
+	}
+
+	return count;
+}
+
+static int vpd_key_cmp(const uint8_t *blob, const struct vpd_index_entry *entry,
+		       const uint8_t *key, uint32_t key_len)
+{
+	int ret = memcmp(blob + entry->key_offset, key,
+			 MIN(entry->key_len, key_len));
+
+	if (ret)
+		return ret;
+
+	return (entry->key_len > key_len) - (entry->key_len < key_len);
+}
+
+static int vpd_index_callback(const uint8_t *key, uint32_t key_len,
+			      const uint8_t *value, uint32_t value_len,
+			      void *arg)
+{
+	struct vpd_index_arg *index = arg;
+	struct vpd_index_entry *entries = index->entries;
+	uint32_t lo = 0, hi = index->count;
+
+	/* Binary insertion; skip keys already seen to keep the first one. */
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		int ret = vpd_key_cmp(index->blob, &entries[mid], key, key_len);
+
+		if (ret == 0)
+			return VPD_DECODE_OK;
+		if (ret < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	memmove(&entries[lo + 1], &entries[lo],
+		(index->count - lo) * sizeof(*entries));
+	entries[lo].key_offset = key - index->blob;
+	entries[lo].key_len = key_len;
+	entries[lo].value_offset = value - index->blob;
+	entries[lo].value_len = value_len;
+	index->count++;
+
+	return VPD_DECODE_OK;
+}
+
+static uint32_t vpd_index_region(const uint8_t *blob, uint32_t offset,
+				 uint32_t size, struct vpd_index_entry *entries)
+{
+	struct vpd_index_arg arg = {
+		.blob = blob,
+		.entries = entries,
+	};
+	uint32_t consumed = 0;
+
+	while (vpd_decode_string(size, blob + offset, &consumed,
+		vpd_index_callback, &arg) == VPD_DECODE_OK) {
+	/* Index all entries. */
+	}
+
+	return arg.count;
+}
+
+static void cbmem_add_vpd_index(const struct vpd_cbmem *cbmem)
+{
+	struct vpd_index *index;
+	uint32_t ro_count, rw_count;
+
+	ro_count = vpd_count_entries(cbmem->blob, cbmem->ro_size);
+	rw_count = vpd_count_entries(cbmem->blob + cbmem->ro_size,
+				     cbmem->rw_size);
+
+	index = cbmem_add(CBMEM_ID_VPD_INDEX, sizeof(*index) +
+		(ro_count + rw_count) * sizeof(index->entries[0]));
+	if (!index) {
+		printk(BIOS_ERR, "%s: Failed to allocate CBMEM.\n", __func__);
+		return;
+	}
+
+	index->ro_count = vpd_index_region(cbmem->blob, 0, cbmem->ro_size,
+					   index->entries);
+	index->rw_count = vpd_index_region(cbmem->blob, cbmem->ro_size,
+		cbmem->rw_size, index->entries + index->ro_count);
+	index->version = CROSVPD_INDEX_VERSION;
+	index->magic = CROSVPD_INDEX_MAGIC;
+
+	printk(BIOS_DEBUG, "VPD: indexed %u RO and %u RW keys.\n",
+	       index->ro_count, index->rw_count);
+}
+
 static void cbmem_add_cros_vpd(int is_recovery)
 {
 	struct vpd_cbmem *cbmem;
@@ -167,6 +309,8 @@ static void cbmem_add_cros_vpd(int is_recovery)
 	}
 
 	init_vpd_rdevs_from_cbmem();
+
+	cbmem_add_vpd_index(cbmem);
 }
 
 static int vpd_gets_callback(const uint8_t *key, uint32_t key_len,
@@ -200,6 +344,74 @@ static void vpd_find_in(struct region_device *rdev, struct vpd_gets_arg *arg)
 	rdev_munmap(rdev, mapping);
 }
 
+static const struct vpd_index *vpd_find_index(const struct vpd_cbmem **cbmem)
+{
+	const struct vpd_index *index;
+
+	if (!ENV_HAS_CBMEM)
+		return NULL;
+
+	index = cbmem_find(CBMEM_ID_VPD_INDEX);
+	if (!index || index->magic != CROSVPD_INDEX_MAGIC ||
+	    index->version != CROSVPD_INDEX_VERSION)
+		return NULL;
+
+	*cbmem = cbmem_find(CBMEM_ID_VPD);
+	if (!*cbmem)
+		return NULL;
+
+	return index;
+}
+
+static void vpd_find_in_index(const struct vpd_cbmem *cbmem,
+			      const struct vpd_index_entry *entries,
+			      uint32_t count, struct vpd_gets_arg *arg)
+{
+	uint32_t lo = 0, hi = count;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		int ret = vpd_key_cmp(cbmem->blob, &entries[mid], arg->key,
+				      arg->key_len);
+
+		if (ret == 0) {
+			arg->matched = 1;
+			arg->value = cbmem->blob + entries[mid].value_offset;
+			arg->value_len = entries[mid].value_len;
+			return;
+		}
+		if (ret < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+}
+
+/* Same lookup order as below, with O(log n) lookups in the CBMEM index. */
+static bool vpd_find_indexed(enum vpd_region region, struct vpd_gets_arg *arg)
+{
+	const struct vpd_cbmem *cbmem;
+	const struct vpd_index *index = vpd_find_index(&cbmem);
+
+	if (!index)
+		return false;
+
+	const struct vpd_index_entry *ro = index->entries;
+	const struct vpd_index_entry *rw = index->entries + index->ro_count;
+
+	if (region == VPD_RW_THEN_RO)
+		vpd_find_in_index(cbmem, rw, index->rw_count, arg);
+
+	if (!arg->matched && (region == VPD_RO || region == VPD_RO_THEN_RW ||
+			region == VPD_RW_THEN_RO))
+		vpd_find_in_index(cbmem, ro, index->ro_count, arg);
+
+	if (!arg->matched && (region == VPD_RW || region == VPD_RO_THEN_RW))
+		vpd_find_in_index(cbmem, rw, index->rw_count, arg);
+
+	return true;
+}
+
 const void *vpd_find(const char *key, int *size, enum vpd_region region)
 {
 	struct vpd_gets_arg arg = {0};
@@ -207,17 +419,21 @@ const void *vpd_find(const char *key, int *size, enum vpd_region region)
 	arg.key = (const uint8_t *)key;
 	arg.key_len = strlen(key);
 
-	init_vpd_rdevs();
+	if (!vpd_find_indexed(region, &arg)) {
+		init_vpd_rdevs();
 
-	if (region == VPD_RW_THEN_RO)
-		vpd_find_in(&rw_vpd, &arg);
+		if (region == VPD_RW_THEN_RO)
+			vpd_find_in(&rw_vpd, &arg);
 
-	if (!arg.matched && (region == VPD_RO || region == VPD_RO_THEN_RW ||
-			region == VPD_RW_THEN_RO))
-		vpd_find_in(&ro_vpd, &arg);
+		if (!arg.matched && (region == VPD_RO ||
+				region == VPD_RO_THEN_RW ||
+				region == VPD_RW_THEN_RO))
+			vpd_find_in(&ro_vpd, &arg);
 
-	if (!arg.matched && (region == VPD_RW || region == VPD_RO_THEN_RW))
-		vpd_find_in(&rw_vpd, &arg);
+		if (!arg.matched && (region == VPD_RW ||
+				region == VPD_RO_THEN_RW))
+			vpd_find_in(&rw_vpd, &arg);
+	}
 
 	if (!arg.matched)
 		return NULL;
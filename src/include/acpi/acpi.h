@@ -373,6 +373,33 @@ typedef struct acpi_hmat_msci {
 	/* Followed by SMBIOS handlers*/
 } __packed acpi_hmat_msci_t;
 
+#define ACPI_HMAT_STRUCTURE_MPDA	0
+#define ACPI_HMAT_STRUCTURE_SLLBI	1
+#define ACPI_HMAT_STRUCTURE_MSCI	2
+
+/* HMAT SLLBI flags: memory hierarchy */
+#define ACPI_HMAT_SLLBI_MEMORY		0
+#define ACPI_HMAT_SLLBI_CACHE_LEVEL(x)	((x) & 0xf)
+
+/* HMAT SLLBI data types */
+#define ACPI_HMAT_ACCESS_LATENCY	0
+#define ACPI_HMAT_READ_LATENCY		1
+#define ACPI_HMAT_WRITE_LATENCY		2
+#define ACPI_HMAT_ACCESS_BANDWIDTH	3
+#define ACPI_HMAT_READ_BANDWIDTH	4
+#define ACPI_HMAT_WRITE_BANDWIDTH	5
+
+/* HMAT MSCI cache attributes */
+#define ACPI_HMAT_CACHE_ASSOC_NONE	0
+#define ACPI_HMAT_CACHE_ASSOC_DIRECT	1
+#define ACPI_HMAT_CACHE_ASSOC_COMPLEX	2
+#define ACPI_HMAT_CACHE_WRITE_NONE	0
+#define ACPI_HMAT_CACHE_WRITE_BACK	1
+#define ACPI_HMAT_CACHE_WRITE_THROUGH	2
+#define ACPI_HMAT_CACHE_ATTRIBUTES(levels, level, assoc, policy, line_size)	\
+	(((levels) & 0xf) | (((level) & 0xf) << 4) | (((assoc) & 0xf) << 8) |	\
+	 (((policy) & 0xf) << 12) | (((line_size) & 0xffff) << 16))
+
 /* SRAT (System Resource Affinity Table) */
 typedef struct acpi_srat {
 	acpi_header_t header;
@@ -1800,6 +1827,24 @@ void acpi_create_slit(acpi_slit_t *slit,
  * proximity domain for the memory.
  */
 int acpi_create_hmat_mpda(acpi_hmat_mpda_t *mpda, u32 initiator, u32 memory);
+/*
+ * Create a System Locality Latency and Bandwidth Information structure for
+ * HMAT. `entries` holds num_initiators * num_targets values in row-major
+ * order (one row per initiator), each multiplied by entry_base_unit to get
+ * picoseconds (latency) or MB/s (bandwidth). Returns the padded length.
+ */
+int acpi_create_hmat_sllbi(acpi_hmat_sllbi_t *sllbi, u8 flags, u8 data_type,
+			   u32 num_initiators, const u32 *initiators,
+			   u32 num_targets, const u32 *targets,
+			   u64 entry_base_unit, const u16 *entries);
+/*
+ * Create a Memory Side Cache Information structure for HMAT, given the
+ * memory proximity domain, the cache size in bytes and the attributes built
+ * with ACPI_HMAT_CACHE_ATTRIBUTES().
+ */
+int acpi_create_hmat_msci(acpi_hmat_msci_t *msci, u32 domain, u64 cache_size,
+			  u32 cache_attributes, u16 num_handles,
+			  const u16 *smbios_handles);
 /* Create Heterogeneous Memory Attribute Table */
 void acpi_create_hmat(acpi_hmat_t *hmat,
 		      unsigned long (*acpi_fill_hmat)(unsigned long current));
@@ -131,6 +131,14 @@ void cbfs_preload(const char *name);
    order where possible, since mapping backends often don't support more complicated cases. */
 void cbfs_unmap(void *mapping);
 
+/*
+ * Maps |size| bytes at |offset| of an uncompressed CBFS file without loading the rest of it.
+ * The data is NOT verified even with CONFIG(CBFS_VERIFICATION), so the caller must verify it
+ * against a trusted hash (e.g. one stored in another, verified CBFS file) before using it.
+ * Unmap with cbfs_unmap(). Returns NULL on error.
+ */
+void *cbfs_unverified_map_range(const char *name, size_t offset, size_t size);
+
 /* Load stage into memory filling in prog. Return 0 on success. < 0 on error. */
 enum cb_err cbfs_prog_stage_load(struct prog *prog);
 
@@ -148,6 +156,10 @@ static inline enum cbfs_type cbfs_ro_get_type(const char *name);
 static inline bool cbfs_file_exists(const char *name);
 static inline bool cbfs_ro_file_exists(const char *name);
 
+/* Look up the metadata of a CBFS file without loading it, e.g. to get its hash with
+   cbfs_file_hash(). */
+static inline enum cb_err cbfs_get_mdata(const char *name, union cbfs_mdata *mdata);
+
 
 /**********************************************************************************************
  *                                BOOT DEVICE HELPER APIs                                     *
@@ -396,4 +408,10 @@ static inline bool cbfs_ro_file_exists(const char *name)
 	return true;
 }
 
+static inline enum cb_err cbfs_get_mdata(const char *name, union cbfs_mdata *mdata)
+{
+	struct region_device rdev;
+	return _cbfs_boot_lookup(name, false, mdata, &rdev);
+}
+
 #endif
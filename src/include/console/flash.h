@@ -3,10 +3,12 @@
 #ifndef CONSOLE_FLASH_H
 #define CONSOLE_FLASH_H 1
 
+#include <stddef.h>
 #include <stdint.h>
 
 void flashconsole_init(void);
 void flashconsole_tx_byte(unsigned char c);
+void flashconsole_tx_bytes(const void *data, size_t len);
 void flashconsole_tx_flush(void);
 
 #define __CONSOLE_FLASH_ENABLE__	CONFIG(CONSOLE_SPI_FLASH)
@@ -17,6 +19,10 @@ static inline void __flashconsole_tx_byte(u8 data)
 {
 	flashconsole_tx_byte(data);
 }
+static inline void __flashconsole_tx_bytes(const void *data, size_t len)
+{
+	flashconsole_tx_bytes(data, len);
+}
 static inline void __flashconsole_tx_flush(void)
 {
 	flashconsole_tx_flush();
@@ -24,6 +30,7 @@ static inline void __flashconsole_tx_flush(void)
 #else
 static inline void __flashconsole_init(void)	{}
 static inline void __flashconsole_tx_byte(u8 data)	{}
+static inline void __flashconsole_tx_bytes(const void *data, size_t len)	{}
 static inline void __flashconsole_tx_flush(void)	{}
 #endif /* __CONSOLE_FLASH_ENABLE__ */
 
@@ -9,11 +9,15 @@
 void console_hw_init(void);
 void console_tx_byte(unsigned char byte);
 void console_tx_flush(void);
+/* Write a span of bytes to all consoles, same as console_tx_byte() on each. */
+void console_tx_bytes(const void *data, size_t len);
 
 /* Interactive consoles that are usually displayed in real time on a terminal. */
 void console_interactive_tx_byte(unsigned char byte, void *data_unused);
 /* Consoles that store logs on some medium for later retrieval. */
 void console_stored_tx_byte(unsigned char byte, void *data_unused);
+void console_interactive_tx_bytes(const void *data, size_t len);
+void console_stored_tx_bytes(const void *data, size_t len);
 
 /*
  * Write number_of_bytes data bytes from buffer to the serial device.
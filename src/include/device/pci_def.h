@@ -456,8 +456,13 @@
 #define PCI_EXP_RTSTA		32	/* Root Status */
 #define PCI_EXP_DEVCAP2		36	/* Device capabilities 2 */
 #define  PCI_EXP_DEVCAP2_LTR	0x0800	/* LTR supported */
+#define  PCI_EXP_DEVCAP2_10BIT_TAG_COMP	0x10000	/* 10-Bit Tag Completer Supported */
+#define  PCI_EXP_DEVCAP2_10BIT_TAG_REQ	0x20000	/* 10-Bit Tag Requester Supported */
 #define PCI_EXP_DEVCTL2		40	/* Device Control 2 */
+#define  PCI_EXP_DEV2_IDO_REQ	0x0100	/* ID-Based Ordering Request Enable */
+#define  PCI_EXP_DEV2_IDO_CMP	0x0200	/* ID-Based Ordering Completion Enable */
 #define  PCI_EXP_DEV2_LTR	0x0400	/* LTR enabled */
+#define  PCI_EXP_DEV2_10BIT_TAG_REQ	0x1000	/* 10-Bit Tag Requester Enable */
 
 /* Extended Capabilities (PCI-X 2.0 and Express) */
 #define PCI_EXT_CAP_ID(header)		(header & 0x0000ffff)
@@ -42,6 +42,8 @@ void vga_oprom_preload(void);
 struct rom_header *pci_rom_probe(const struct device *dev);
 struct rom_header *pci_rom_load(struct device *dev,
 	struct rom_header *rom_header);
+/* Returns a copy of the expansion ROM from PCI_OPROM_CACHE_IN_FMAP, or rom on failure. */
+struct rom_header *pci_rom_cache(const struct device *dev, struct rom_header *rom);
 
 static inline void pci_rom_free(struct rom_header *rom_header)
 {
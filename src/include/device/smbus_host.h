@@ -24,6 +24,12 @@ int do_smbus_process_call(uintptr_t base, u8 device, u8 cmd, u16 data, u16 *buf)
 int do_i2c_eeprom_read(uintptr_t base, u8 device, u8 offset, size_t bytes, u8 *buf);
 int do_i2c_block_write(uintptr_t base, u8 device, size_t bytes, u8 *buf);
 
+/*
+ * Read SPD bytes with a single I2C block read, or with SMBus byte reads if the
+ * controller can't do that. Returns the number of bytes read or an error.
+ */
+int do_smbus_spd_read(uintptr_t base, u8 device, u8 offset, size_t bytes, u8 *buf);
+
 /* Upstream API */
 
 uintptr_t smbus_base(void);
@@ -78,6 +84,12 @@ static inline int i2c_eeprom_read(u8 device, u8 offset, size_t bytes, u8 *buf)
 	uintptr_t base = smbus_base();
 	return do_i2c_eeprom_read(base, device, offset, bytes, buf);
 }
+
+static inline int smbus_spd_read(u8 device, u8 offset, size_t bytes, u8 *buf)
+{
+	uintptr_t base = smbus_base();
+	return do_smbus_spd_read(base, device, offset, bytes, buf);
+}
 #endif
 
 #endif
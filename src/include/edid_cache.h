@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __EDID_CACHE_H
+#define __EDID_CACHE_H
+
+#include <edid.h>
+#include <stdint.h>
+
+/*
+ * Reading the EDID over DDC or DP AUX takes many milliseconds on every boot.
+ * With EDID_CACHE_IN_FMAP, display drivers first read only the identity of the
+ * panel, i.e. the first EDID_CACHE_ID_LENGTH bytes of the EDID (header, vendor,
+ * product and serial number), and look up the decoded EDID in flash. Only on a
+ * miss they read and decode the whole EDID and hand the result to
+ * edid_cache_update().
+ *
+ * connector is a driver chosen value (e.g. I2C bus and address) that tells the
+ * displays of a board apart.
+ */
+#define EDID_CACHE_FMAP_NAME	(CONFIG_EDID_CACHE_FMAP_NAME)
+#define EDID_CACHE_ID_LENGTH	16
+
+#if CONFIG(EDID_CACHE_IN_FMAP)
+/* Returns 0 and fills out if the EDID for this identity is cached, -1 otherwise. */
+int edid_cache_lookup(uint32_t connector, const uint8_t *id, struct edid *out);
+/* Store a decoded EDID. The flash is only written once the display is up. */
+void edid_cache_update(uint32_t connector, const uint8_t *id, const struct edid *edid);
+#else
+static inline int edid_cache_lookup(uint32_t connector, const uint8_t *id,
+				    struct edid *out)
+{
+	return -1;
+}
+static inline void edid_cache_update(uint32_t connector, const uint8_t *id,
+				     const struct edid *edid) {}
+#endif
+
+#endif
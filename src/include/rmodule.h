@@ -47,6 +47,11 @@ struct rmod_stage_load {
 
 /* Both of the following functions return 0 on success, -1 on error. */
 int rmodule_stage_load(struct rmod_stage_load *rsl);
+/*
+ * Reserve the cbmem region rmodule_stage_load() would load the stage to and set it as
+ * the area of rsl->prog, without loading anything.
+ */
+int rmodule_stage_reserve(struct rmod_stage_load *rsl);
 
 struct rmodule {
 	void *location;
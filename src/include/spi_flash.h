@@ -107,6 +107,8 @@ struct spi_flash {
 	u32 sector_size;
 	u32 page_size;
 	u8 erase_cmd;
+	u8 erase_cmd_32k; /* 32 KiB block erase command, 0 if not supported. */
+	u8 erase_cmd_64k; /* 64 KiB block erase command, 0 if not supported. */
 	u8 status_cmd;
 	u8 pp_cmd; /* Page program command. */
 	u8 wren_cmd; /* Write Enable command. */
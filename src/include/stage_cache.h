@@ -7,6 +7,8 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <program_loading.h>
+#include <types.h>
+#include <vb2_sha.h>
 
 /* Types of stages that may be stored in stage cache */
 enum {
@@ -39,6 +41,20 @@ static inline void stage_cache_get_raw(int stage_id, void **base, size_t *size)
 
 #endif
 
+#if CONFIG(STAGE_CACHE_WARM_BOOT)
+/*
+ * Load a stage kept in the stage cache across a warm reset. The area of |stage| has to be
+ * reserved at the address the stage was cached from. Fails if there is no such stage or
+ * it doesn't match the CBFS file of the current boot anymore.
+ */
+enum cb_err stage_cache_load_warm(int stage_id, struct prog *stage);
+#else
+static inline enum cb_err stage_cache_load_warm(int stage_id, struct prog *stage)
+{
+	return CB_ERR;
+}
+#endif
+
 static inline int resume_from_stage_cache(void)
 {
 	if (CONFIG(NO_STAGE_CACHE))
@@ -56,6 +72,9 @@ struct stage_cache {
 	uint64_t load_addr;
 	uint64_t entry_addr;
 	uint64_t arg;
+	/* Only filled in with STAGE_CACHE_WARM_BOOT */
+	struct vb2_hash file_hash;	/* CBFS metadata hash of the stage file */
+	struct vb2_hash data_hash;	/* SHA-256 of the cached stage */
 };
 
 #endif /* _STAGE_CACHE_H_ */
@@ -154,6 +154,7 @@ ramstage-$(CONFIG_COLLECT_TIMESTAMPS) += timestamp.c
 ramstage-$(CONFIG_COVERAGE) += libgcov.c
 ramstage-y += dp_aux.c
 ramstage-y += edid.c
+ramstage-$(CONFIG_EDID_CACHE_IN_FMAP) += edid_cache.c
 ramstage-y += edid_fill_fb.c
 ramstage-y += memrange.c
 ramstage-$(CONFIG_GENERIC_GPIO_LIB) += gpio.c
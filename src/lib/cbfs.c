@@ -536,6 +536,25 @@ void *_cbfs_unverified_area_alloc(const char *area, const char *name,
 	return do_alloc(&mdata, &file_rdev, allocator, arg, size_out, true);
 }
 
+void *cbfs_unverified_map_range(const char *name, size_t offset, size_t size)
+{
+	struct region_device rdev;
+	union cbfs_mdata mdata;
+
+	DEBUG("%s(name='%s', offset=%#zx, size=%#zx)\n", __func__, name, offset, size);
+
+	if (_cbfs_boot_lookup(name, false, &mdata, &rdev))
+		return NULL;
+
+	if (cbfs_find_attr(&mdata, CBFS_FILE_ATTR_TAG_COMPRESSION,
+			   sizeof(struct cbfs_file_attr_compression))) {
+		ERROR("Cannot map a range of compressed file %s\n", mdata.h.filename);
+		return NULL;
+	}
+
+	return rdev_mmap(&rdev, offset, size);
+}
+
 void *_cbfs_default_allocator(void *arg, size_t size, const union cbfs_mdata *unused)
 {
 	struct _cbfs_default_allocator_arg *darg = arg;
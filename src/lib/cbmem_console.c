@@ -4,6 +4,7 @@
 #include <console/console.h>
 #include <console/uart.h>
 #include <cbmem.h>
+#include <string.h>
 #include <symbols.h>
 #include <types.h>
 
@@ -114,32 +115,56 @@ void cbmemc_tx_byte(unsigned char data)
 	current_console->cursor = flags | cursor;
 }
 
+void cbmemc_tx_bytes(const void *data, size_t len)
+{
+	const u8 *src = data;
+
+	if (!current_console || !current_console->size || console_paused)
+		return;
+
+	u32 flags = current_console->cursor & ~CURSOR_MASK;
+	u32 cursor = current_console->cursor & CURSOR_MASK;
+
+	while (len) {
+		size_t chunk = MIN(len, current_console->size - cursor);
+
+		memcpy(&current_console->body[cursor], src, chunk);
+		src += chunk;
+		len -= chunk;
+		cursor += chunk;
+		if (cursor >= current_console->size) {
+			cursor = 0;
+			flags |= OVERFLOW;
+		}
+	}
+
+	current_console->cursor = flags | cursor;
+}
+
 /*
  * Copy the current console buffer (either from the cache as RAM area or from
  * the static buffer, pointed at by src_cons_p) into the newly initialized CBMEM
- * console. The use of cbmemc_tx_byte() ensures that all special cases for the
+ * console. The use of cbmemc_tx_bytes() ensures that all special cases for the
  * target console (e.g. overflow) will be handled. If there had been an
  * overflow in the source console, log a message to that effect.
  */
 static void copy_console_buffer(struct cbmem_console *src_cons_p)
 {
-	u32 c;
+	u32 cursor;
 
 	if (!src_cons_p)
 		return;
 
+	cursor = src_cons_p->cursor & CURSOR_MASK;
+
 	if (src_cons_p->cursor & OVERFLOW) {
 		const char overflow_warning[] = "\n*** Pre-CBMEM " ENV_STRING
 			" console overflowed, log truncated! ***\n";
-		for (c = 0; c < sizeof(overflow_warning) - 1; c++)
-			cbmemc_tx_byte(overflow_warning[c]);
-		for (c = src_cons_p->cursor & CURSOR_MASK;
-		     c < src_cons_p->size; c++)
-			cbmemc_tx_byte(src_cons_p->body[c]);
+		cbmemc_tx_bytes(overflow_warning, sizeof(overflow_warning) - 1);
+		cbmemc_tx_bytes(&src_cons_p->body[cursor], src_cons_p->size - cursor);
 	}
 
-	for (c = 0; c < (src_cons_p->cursor & CURSOR_MASK); c++)
-		cbmemc_tx_byte(src_cons_p->body[c]);
+	cbmemc_tx_bytes(src_cons_p->body, cursor);
 
 	/* Invalidate the source console, so it will be reinitialized on the
 	   next reboot. Otherwise, we might copy the same bytes again. */
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <console/console.h>
+#include <crc_byte.h>
+#include <edid_cache.h>
+#include <fmap.h>
+#include <string.h>
+#include <types.h>
+
+/*
+ * EDID_CACHE layout
+ *    +==========+ offset 0x00
+ *    |  header  |   signature, version and the size of struct edid
+ *    +----------+
+ *    |  slot 1  |   connector, identity and decoded struct edid
+ *    +----------+
+ *         ...
+ *    +----------+
+ *    |  slot N  |   N = EDID_CACHE_SLOTS
+ *    +----------+
+ *    |  CRC 16  |   Use to verify the data correctness.
+ *    +==========+
+ *
+ * The decoded struct edid is stored as is, so the layout depends on the build.
+ * Bump EDID_CACHE_VERSION when struct edid changes without changing its size.
+ */
+#define EDID_CACHE_SIGNATURE	0x43444545	/* 'EEDC' */
+#define EDID_CACHE_VERSION	1
+#define EDID_CACHE_SLOTS	4
+
+struct edid_cache_slot {
+	uint32_t used;
+	uint32_t connector;
+	uint8_t id[EDID_CACHE_ID_LENGTH];
+	struct edid edid;
+};
+
+struct edid_cache {
+	uint32_t signature;
+	uint16_t version;
+	uint16_t edid_size;
+	struct edid_cache_slot slots[EDID_CACHE_SLOTS];
+	uint16_t crc;
+};
+
+_Static_assert(sizeof(struct edid_cache) <= 4 * KiB, "EDID cache exceeds one flash sector");
+
+static struct edid_cache cache;
+static enum { CACHE_UNREAD, CACHE_CLEAN, CACHE_DIRTY } cache_state;
+
+static uint16_t cache_crc(const struct edid_cache *c)
+{
+	const uint8_t *data = (const uint8_t *)c;
+	uint16_t crc = 0;
+
+	for (size_t i = 0; i < offsetof(struct edid_cache, crc); i++)
+		crc = crc16_byte(crc, data[i]);
+
+	return crc;
+}
+
+static void init_cache(struct edid_cache *c)
+{
+	memset(c, 0, sizeof(*c));
+	c->signature = EDID_CACHE_SIGNATURE;
+	c->version = EDID_CACHE_VERSION;
+	c->edid_size = sizeof(struct edid);
+}
+
+static void load_cache(void)
+{
+	struct region_device rdev;
+
+	if (cache_state != CACHE_UNREAD)
+		return;
+	cache_state = CACHE_CLEAN;
+
+	if (fmap_locate_area_as_rdev(EDID_CACHE_FMAP_NAME, &rdev) < 0) {
+		printk(BIOS_ERR, "EDID_CACHE: Cannot find %s region\n", EDID_CACHE_FMAP_NAME);
+		init_cache(&cache);
+		return;
+	}
+
+	if (rdev_readat(&rdev, &cache, 0, sizeof(cache)) != sizeof(cache) ||
+	    cache.signature != EDID_CACHE_SIGNATURE || cache.version != EDID_CACHE_VERSION ||
+	    cache.edid_size != sizeof(struct edid) || cache.crc != cache_crc(&cache)) {
+		printk(BIOS_INFO, "EDID_CACHE: No valid cache found\n");
+		init_cache(&cache);
+	}
+}
+
+static struct edid_cache_slot *find_slot(uint32_t connector)
+{
+	for (size_t i = 0; i < EDID_CACHE_SLOTS; i++)
+		if (cache.slots[i].used && cache.slots[i].connector == connector)
+			return &cache.slots[i];
+	return NULL;
+}
+
+int edid_cache_lookup(uint32_t connector, const uint8_t *id, struct edid *out)
+{
+	struct edid_cache_slot *slot;
+
+	load_cache();
+
+	slot = find_slot(connector);
+	if (!slot || memcmp(slot->id, id, EDID_CACHE_ID_LENGTH))
+		return -1;
+
+	memcpy(out, &slot->edid, sizeof(*out));
+	printk(BIOS_INFO, "EDID_CACHE: Using cached EDID for %s %s\n",
+	       out->manufacturer_name, out->ascii_string);
+
+	return 0;
+}
+
+void edid_cache_update(uint32_t connector, const uint8_t *id, const struct edid *edid)
+{
+	struct edid_cache_slot *slot;
+
+	load_cache();
+
+	slot = find_slot(connector);
+	for (size_t i = 0; !slot && i < EDID_CACHE_SLOTS; i++)
+		if (!cache.slots[i].used)
+			slot = &cache.slots[i];
+	/* All slots taken by other connectors, which means the board was reworked. */
+	if (!slot) {
+		init_cache(&cache);
+		slot = &cache.slots[0];
+	}
+
+	slot->used = 1;
+	slot->connector = connector;
+	memcpy(slot->id, id, EDID_CACHE_ID_LENGTH);
+	memcpy(&slot->edid, edid, sizeof(slot->edid));
+	/* Points into the ramstage image. */
+	slot->edid.mode.name = NULL;
+
+	cache_state = CACHE_DIRTY;
+}
+
+/* Write the cache late, so that the flash access doesn't delay the display. */
+static void write_edid_cache(void *unused)
+{
+	struct region_device rdev;
+
+	if (cache_state != CACHE_DIRTY)
+		return;
+
+	cache.crc = cache_crc(&cache);
+
+	if (fmap_locate_area_as_rdev_rw(EDID_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "EDID_CACHE: Cannot access %s region\n", EDID_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (rdev_eraseat(&rdev, 0, region_device_sz(&rdev)) < 0) {
+		printk(BIOS_ERR, "EDID_CACHE: Cannot erase %s region\n", EDID_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (rdev_writeat(&rdev, &cache, 0, sizeof(cache)) != sizeof(cache)) {
+		printk(BIOS_ERR, "EDID_CACHE: Cannot write %s region\n", EDID_CACHE_FMAP_NAME);
+		return;
+	}
+
+	printk(BIOS_INFO, "EDID_CACHE: Updated %s region\n", EDID_CACHE_FMAP_NAME);
+	cache_state = CACHE_CLEAN;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, write_edid_cache, NULL);
@@ -1,10 +1,12 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <cbfs.h>
 #include <cbmem.h>
 #include <console/console.h>
 #include <imd.h>
 #include <stage_cache.h>
 #include <string.h>
+#include <vb2_api.h>
 
 static struct imd imd_stage_cache;
 
@@ -37,6 +39,103 @@ static void stage_cache_recover(void)
 		printk(BIOS_DEBUG, "Unable to recover external stage cache.\n");
 }
 
+static void stage_cache_hash(struct stage_cache *meta, const struct prog *stage,
+			     const void *data, size_t size)
+{
+	union cbfs_mdata mdata;
+	const struct vb2_hash *file_hash;
+
+	memset(&meta->file_hash, 0, sizeof(meta->file_hash));
+	memset(&meta->data_hash, 0, sizeof(meta->data_hash));
+
+	if (cbfs_get_mdata(prog_name(stage), &mdata) != CB_SUCCESS)
+		return;
+	file_hash = cbfs_file_hash(&mdata);
+	if (!file_hash)
+		return;
+	memcpy(&meta->file_hash, file_hash,
+	       offsetof(struct vb2_hash, raw) + vb2_digest_size(file_hash->algo));
+
+	if (vb2_hash_calculate(false, data, size, VB2_HASH_SHA256, &meta->data_hash))
+		memset(&meta->file_hash, 0, sizeof(meta->file_hash));
+}
+
+/*
+ * Check whether the ramstage cached before a warm reset was loaded from the same CBFS file
+ * this boot would load it from.
+ */
+static bool stage_cache_warm_valid(const struct stage_cache *meta)
+{
+	union cbfs_mdata mdata;
+	const struct vb2_hash *file_hash;
+	struct vb2_hash hash = { 0 };
+
+	if (meta->file_hash.algo == VB2_HASH_INVALID)
+		return false;
+
+	if (cbfs_get_mdata(CONFIG_CBFS_PREFIX "/ramstage", &mdata) != CB_SUCCESS)
+		return false;
+	file_hash = cbfs_file_hash(&mdata);
+	if (!file_hash)
+		return false;
+	memcpy(&hash, file_hash, offsetof(struct vb2_hash, raw) +
+	       vb2_digest_size(file_hash->algo));
+
+	return !memcmp(&hash, &meta->file_hash, sizeof(hash));
+}
+
+/*
+ * After a warm reset, keep the ramstage of the previous boot in an otherwise empty stage
+ * cache if it still matches the CBFS. stage_cache_load_warm() verifies it before use.
+ */
+static void stage_cache_keep_warm(void)
+{
+	struct imd *imd;
+	const struct imd_entry *e;
+	struct stage_cache meta;
+	void *base, *c;
+	size_t size;
+
+	imd = &imd_stage_cache;
+	stage_cache_external_region(&base, &size);
+	imd_handle_init(imd, (void *)(size + (uintptr_t)base));
+	if (imd_recover(imd))
+		goto empty;
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_META + STAGE_RAMSTAGE);
+	if (e == NULL || imd_entry_size(e) != sizeof(meta))
+		goto empty;
+	memcpy(&meta, imd_entry_at(imd, e), sizeof(meta));
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_CACHE + STAGE_RAMSTAGE);
+	if (e == NULL || !stage_cache_warm_valid(&meta))
+		goto empty;
+	c = imd_entry_at(imd, e);
+	size = imd_entry_size(e);
+
+	/*
+	 * The new root is where the old one was, so the cached ramstage only moves up to the
+	 * first entry of the new stage cache. Anything that goes wrong here is caught by the
+	 * data hash.
+	 */
+	stage_cache_create_empty();
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + STAGE_RAMSTAGE, size);
+	if (e == NULL)
+		return;
+	memmove(imd_entry_at(imd, e), c, size);
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_META + STAGE_RAMSTAGE, sizeof(meta));
+	if (e == NULL)
+		return;
+	memcpy(imd_entry_at(imd, e), &meta, sizeof(meta));
+
+	printk(BIOS_DEBUG, "Kept ramstage in stage cache across warm reset.\n");
+	return;
+
+empty:
+	stage_cache_create_empty();
+}
+
 void stage_cache_add(int stage_id, const struct prog *stage)
 {
 	struct imd *imd;
@@ -45,7 +144,8 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 	void *c;
 
 	imd = &imd_stage_cache;
-	e = imd_entry_add(imd, CBMEM_ID_STAGEx_META + stage_id, sizeof(*meta));
+	/* The entries may have been kept from before a warm reset. */
+	e = imd_entry_find_or_add(imd, CBMEM_ID_STAGEx_META + stage_id, sizeof(*meta));
 
 	if (e == NULL) {
 		printk(BIOS_DEBUG, "Error: Can't add %x metadata to imd\n",
@@ -67,17 +167,22 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 		p_size -= CONFIG_HEAP_SIZE;
 	}
 
-	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, p_size);
+	e = imd_entry_find_or_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, p_size);
 
-	if (e == NULL) {
+	if (e == NULL || imd_entry_size(e) != p_size) {
 		printk(BIOS_DEBUG, "Error: Can't add stage_cache %x to imd\n",
 				CBMEM_ID_STAGEx_CACHE + stage_id);
+		/* Don't leave metadata pointing to a different stage behind. */
+		meta->entry_addr = 0;
 		return;
 	}
 
 	c = imd_entry_at(imd, e);
 
 	memcpy(c, prog_start(stage), p_size);
+
+	if (CONFIG(STAGE_CACHE_WARM_BOOT) && stage_id == STAGE_RAMSTAGE)
+		stage_cache_hash(meta, stage, c, p_size);
 }
 
 void stage_cache_add_raw(int stage_id, const void *base, const size_t size)
@@ -157,10 +262,55 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 			(void *)(uintptr_t)meta->arg);
 }
 
+#if CONFIG(STAGE_CACHE_WARM_BOOT)
+enum cb_err stage_cache_load_warm(int stage_id, struct prog *stage)
+{
+	struct imd *imd;
+	const struct stage_cache *meta;
+	const struct imd_entry *e;
+	struct vb2_hash hash;
+	void *c;
+	size_t size;
+
+	imd = &imd_stage_cache;
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_META + stage_id);
+	if (e == NULL)
+		return CB_ERR;
+	meta = imd_entry_at(imd, e);
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_CACHE + stage_id);
+	if (e == NULL || meta->entry_addr == 0)
+		return CB_ERR;
+	c = imd_entry_at(imd, e);
+	size = imd_entry_size(e);
+
+	if (meta->load_addr != (uintptr_t)prog_start(stage) || size > prog_size(stage)) {
+		printk(BIOS_INFO, "Warm stage cache %x: load address changed.\n", stage_id);
+		return CB_ERR;
+	}
+
+	if (vb2_hash_calculate(false, c, size, VB2_HASH_SHA256, &hash) ||
+	    memcmp(hash.sha256, meta->data_hash.sha256, sizeof(hash.sha256))) {
+		printk(BIOS_WARNING, "Warm stage cache %x: hash mismatch.\n", stage_id);
+		return CB_ERR;
+	}
+
+	memcpy((void *)(uintptr_t)meta->load_addr, c, size);
+
+	prog_set_area(stage, (void *)(uintptr_t)meta->load_addr, size);
+	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr,
+			(void *)(uintptr_t)meta->arg);
+
+	return CB_SUCCESS;
+}
+#endif
+
 static void stage_cache_setup(int is_recovery)
 {
 	if (is_recovery)
 		stage_cache_recover();
+	else if (CONFIG(STAGE_CACHE_WARM_BOOT))
+		stage_cache_keep_warm();
 	else
 		stage_cache_create_empty();
 }
@@ -10,6 +10,7 @@
 #include <reset.h>
 #include <rmodule.h>
 #include <romstage_common.h>
+#include <security/tpm/tspi/crtm.h>
 #include <security/vboot/vboot_common.h>
 #include <stage_cache.h>
 #include <symbols.h>
@@ -80,6 +81,62 @@ static int load_relocatable_ramstage(struct prog *ramstage)
 
 	return rmodule_stage_load(&rmod_ram);
 }
+
+static int load_ramstage_from_warm_cache(struct prog *ramstage)
+{
+	struct rmod_stage_load rmod_ram = {
+		.cbmem_id = CBMEM_ID_RAMSTAGE,
+		.prog = ramstage,
+	};
+
+	union cbfs_mdata mdata;
+	const struct vb2_hash *hash = NULL;
+
+	if (!CONFIG(STAGE_CACHE_WARM_BOOT))
+		return -1;
+
+	/*
+	 * The cached copy replaces the CBFS file, so the platform hook has to see it the
+	 * same way. Should the cache turn out to be unusable, it runs again for the
+	 * normal load.
+	 */
+	if (prog_locate_hook(ramstage))
+		return -1;
+
+	/*
+	 * The PCRs don't survive the warm reset, so measure the CBFS file hash like
+	 * cbfs.c does when loading the file. The cache is only used when its file hash
+	 * still matches the CBFS.
+	 */
+	if (CONFIG(TPM_MEASURED_BOOT)) {
+		if (cbfs_get_mdata(prog_name(ramstage), &mdata) == CB_SUCCESS)
+			hash = cbfs_file_hash(&mdata);
+		if (!hash || hash->algo != TPM_MEASURE_ALGO)
+			return -1;
+	}
+
+	timestamp_add_now(TS_WARM_RAMSTAGE_START);
+
+	/*
+	 * On failure the normal load finds the same cbmem region. Close the timestamp
+	 * pair so the failed attempt doesn't leave a dangling START in the table.
+	 */
+	if (rmodule_stage_reserve(&rmod_ram) ||
+	    stage_cache_load_warm(STAGE_RAMSTAGE, ramstage) != CB_SUCCESS) {
+		timestamp_add_now(TS_WARM_RAMSTAGE_END);
+		return -1;
+	}
+
+	if (CONFIG(TPM_MEASURED_BOOT) &&
+	    tspi_cbfs_measurement(prog_name(ramstage), CBFS_TYPE_STAGE, hash))
+		printk(BIOS_ERR, "Failed to measure '%s' into TPM log\n", prog_name(ramstage));
+
+	timestamp_add_now(TS_WARM_RAMSTAGE_END);
+
+	printk(BIOS_DEBUG, "Loaded ramstage from warm stage cache.\n");
+	return 0;
+}
+
 void preload_ramstage(void)
 {
 	if (!CONFIG(CBFS_PRELOAD))
@@ -109,6 +166,9 @@ void __noreturn run_ramstage(void)
 	if (ENV_X86 && resume_from_stage_cache())
 		run_ramstage_from_resume(&ramstage);
 
+	if (ENV_X86 && !load_ramstage_from_warm_cache(&ramstage))
+		goto run;
+
 	timestamp_add_now(TS_COPYRAM_START);
 
 	if (ENV_X86) {
@@ -123,6 +183,7 @@ void __noreturn run_ramstage(void)
 
 	timestamp_add_now(TS_COPYRAM_END);
 
+run:
 	console_time_report();
 
 	/* This overrides the arg fetched from the relocatable module */
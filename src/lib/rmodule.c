@@ -246,6 +246,30 @@ static void *rmodule_cbfs_allocator(void *rsl_arg, size_t unused,
 	return stage_region + region_alignment - sizeof(struct rmodule_header);
 }
 
+int rmodule_stage_reserve(struct rmod_stage_load *rsl)
+{
+	const struct cbmem_entry *entry;
+	union cbfs_mdata mdata;
+	uint8_t *rmod_loc;
+
+	if (rsl->prog == NULL || prog_name(rsl->prog) == NULL)
+		return -1;
+
+	if (cbfs_get_mdata(prog_name(rsl->prog), &mdata) != CB_SUCCESS)
+		return -1;
+
+	rmod_loc = rmodule_cbfs_allocator(rsl, 0, &mdata);
+	entry = cbmem_entry_find(rsl->cbmem_id);
+	if (!rmod_loc || !entry)
+		return -1;
+
+	/* The program starts right after the header, see rmodule_cbfs_allocator(). */
+	prog_set_area(rsl->prog, rmod_loc + sizeof(struct rmodule_header),
+		      cbmem_entry_size(entry) - region_alignment);
+
+	return 0;
+}
+
 int rmodule_stage_load(struct rmod_stage_load *rsl)
 {
 	struct rmodule rmod_stage;
@@ -1,7 +1,9 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbfs.h>
+#include <commonlib/ux_locales_serialized.h>
 #include <console/console.h>
+#include <endian.h>
 #include <security/vboot/misc.h>
 #include <stddef.h>
 #include <string.h>
@@ -13,6 +15,7 @@
 
 #define PRERAM_LOCALES_VERSION_BYTE 0x01
 #define PRERAM_LOCALES_NAME "preram_locales"
+#define PRERAM_LOCALES_INDEX_NAME "preram_locales.idx"
 
 /* We need different delimiters to deal with the case where 'string_name' is the same as
    'localized_string'. */
@@ -35,12 +38,18 @@
  *
  * This file contains tools to locate the file and search for localized strings
  * with specific language ID.
+ *
+ * If the optional preram_locales.idx file generated by `cbfstool add-locales-index`
+ * is present next to it, strings are looked up through this index. Older images
+ * without index, or an index that doesn't match the file, fall back to searching.
  */
 
 /* Cached state for map (locales_get_map) and unmap (ux_locales_unmap). */
 struct preram_locales_state {
 	void *data;
 	size_t size;
+	void *index;
+	size_t index_size;
 	bool initialized;
 };
 
@@ -51,9 +60,53 @@ void ux_locales_unmap(void)
 	if (cached_state.initialized) {
 		if (cached_state.data)
 			cbfs_unmap(cached_state.data);
+		if (cached_state.index)
+			cbfs_unmap(cached_state.index);
 		cached_state.initialized = false;
 		cached_state.size = 0;
 		cached_state.data = NULL;
+		cached_state.index_size = 0;
+		cached_state.index = NULL;
+	}
+}
+
+/* Check that the index was built for a preram_locales of this size and fits its file. */
+static bool index_is_valid(const void *index, size_t index_size, size_t size)
+{
+	const struct ux_locales_index_header *header = index;
+	size_t num_slots, num_langs;
+
+	if (index_size < sizeof(*header) ||
+	    le32toh(header->magic) != UX_LOCALES_INDEX_MAGIC ||
+	    le16toh(header->version) != UX_LOCALES_INDEX_VERSION ||
+	    le32toh(header->locales_size) != size)
+		return false;
+
+	num_slots = le16toh(header->num_slots);
+	num_langs = le16toh(header->num_langs);
+	if (!num_slots || !IS_POWER_OF_2(num_slots))
+		return false;
+
+	return index_size >= sizeof(*header) +
+			     num_slots * sizeof(struct ux_locales_index_slot) +
+			     num_langs * sizeof(struct ux_locales_index_lang);
+}
+
+/* Map the optional index of preram_locales. */
+static void locales_map_index(void)
+{
+	cached_state.index = cbfs_ro_map(PRERAM_LOCALES_INDEX_NAME,
+					 &cached_state.index_size);
+	if (!cached_state.index)
+		return;
+
+	if (!index_is_valid(cached_state.index, cached_state.index_size,
+			    cached_state.size)) {
+		printk(BIOS_WARNING, "%s: Ignoring stale or invalid %s.\n", __func__,
+		       PRERAM_LOCALES_INDEX_NAME);
+		cbfs_unmap(cached_state.index);
+		cached_state.index = NULL;
+		cached_state.index_size = 0;
 	}
 }
 
@@ -67,6 +120,8 @@ static void *locales_get_map(size_t *size_out, bool unmap)
 	cached_state.initialized = true;
 	cached_state.data = cbfs_ro_map(PRERAM_LOCALES_NAME,
 					&cached_state.size);
+	if (cached_state.data)
+		locales_map_index();
 	*size_out = cached_state.size;
 	return cached_state.data;
 }
@@ -112,6 +167,80 @@ static size_t search_for_id(const char *data, size_t offset, size_t size,
 	return search_for(data, offset, size, int_to_str, DELIM_STR);
 }
 
+/* Check that the string at offset is exactly str and starts right after delim. */
+static bool string_at(const char *data, size_t offset, size_t size, const char *str,
+		      char delim)
+{
+	const size_t len = strlen(str) + 1;
+
+	if (offset < 1 || offset >= size || len > size - offset)
+		return false;
+	if (data[offset - 1] != delim && offset != 1)
+		return false;
+	return !memcmp(data + offset, str, len);
+}
+
+/*
+ * Look up the localized string through the index, including the fallback to
+ * English. The name and language ID at the offsets taken from the index are
+ * checked against the data before they are used. Returns size if not found.
+ */
+static size_t index_search(const char *data, size_t size, const char *name,
+			   uint32_t lang_id)
+{
+	const struct ux_locales_index_header *header = cached_state.index;
+	const struct ux_locales_index_slot *slots = (const void *)(header + 1);
+	const size_t num_slots = le16toh(header->num_slots);
+	const struct ux_locales_index_lang *langs = (const void *)(slots + num_slots);
+	const uint32_t hash = ux_locales_name_hash(name);
+	const struct ux_locales_index_slot *slot = NULL;
+	size_t first, num, id_offset = 0, fallback_offset = 0, offset, next;
+	char int_to_str[LANG_ID_LEN] = {};
+	uint32_t id = lang_id;
+
+	for (size_t i = 0; i < num_slots; i++) {
+		const struct ux_locales_index_slot *s = &slots[(hash + i) & (num_slots - 1)];
+
+		if (!s->name_offset)
+			break;
+		if (le32toh(s->name_hash) == hash &&
+		    string_at(data, le32toh(s->name_offset), size, name, DELIM_NAME)) {
+			slot = s;
+			break;
+		}
+	}
+	if (!slot)
+		return size;
+
+	first = le16toh(slot->first_lang);
+	num = le16toh(slot->num_langs);
+	if (first + num > le16toh(header->num_langs))
+		return size;
+
+	for (size_t i = first; i < first + num; i++) {
+		if (langs[i].id == lang_id)
+			id_offset = le32toh(langs[i].id_offset);
+		if (langs[i].id == 0)
+			fallback_offset = le32toh(langs[i].id_offset);
+	}
+	if (!id_offset) {
+		id_offset = fallback_offset;
+		id = 0;
+	}
+
+	snprintf(int_to_str, LANG_ID_LEN, "%u", id);
+	if (!string_at(data, id_offset, size, int_to_str, DELIM_STR))
+		return size;
+
+	/* Validity check that the string is NULL terminated. */
+	offset = move_next(data, id_offset, size, DELIM_STR);
+	next = move_next(data, offset, size, DELIM_STR) - 1;
+	if (offset >= size || next >= size || data[next] != '\0')
+		return size;
+
+	return offset;
+}
+
 const char *ux_locales_get_text(const char *name)
 {
 	const char *data;
@@ -148,6 +277,14 @@ const char *ux_locales_get_text(const char *name)
 		return NULL;
 	}
 
+	if (cached_state.index) {
+		offset = index_search(data, size, name, lang_id);
+		if (offset < size)
+			return data + offset;
+		printk(BIOS_DEBUG, "%s: %s not found in %s, searching.\n", __func__,
+		       name, PRERAM_LOCALES_INDEX_NAME);
+	}
+
 	/* Search for name. Skip the version byte. */
 	offset = search_for_name(data, 1, size, name);
 	if (offset >= size) {
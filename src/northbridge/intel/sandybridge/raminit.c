@@ -138,16 +138,15 @@ static int verify_crc16_spds_ddr3(spd_raw_data *spd, ramctr_timing *ctrl)
 	return match;
 }
 
+/* With id_only, only read the bytes the CRC16 for the MRC cache is calculated over. */
 static void read_spd(spd_raw_data *spd, u8 addr, bool id_only)
 {
-	int j;
-	if (id_only) {
-		for (j = SPD_DIMM_MOD_ID1; j < 128; j++)
-			(*spd)[j] = smbus_read_byte(addr, j);
-	} else {
-		for (j = 0; j < SPD_SIZE_MAX_DDR3; j++)
-			(*spd)[j] = smbus_read_byte(addr, j);
-	}
+	const u8 offset = id_only ? SPD_DIMM_MOD_ID1 : 0;
+	const size_t len = id_only ? 128 - SPD_DIMM_MOD_ID1 : SPD_SIZE_MAX_DDR3;
+
+	/* Empty slots are left zeroed. */
+	if (smbus_spd_read(addr, offset, len, &(*spd)[offset]) != len)
+		memset(&(*spd)[offset], 0, len);
 }
 
 static void mainboard_get_spd(spd_raw_data *spd, bool id_only)
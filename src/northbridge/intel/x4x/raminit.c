@@ -22,15 +22,15 @@
 static u16 ddr2_get_crc(u8 device, u8 len)
 {
 	u8 raw_spd[128] = {};
-	i2c_eeprom_read(device, 64, 9, &raw_spd[64]);
-	i2c_eeprom_read(device, 93, 6, &raw_spd[93]);
+	smbus_spd_read(device, 64, 9, &raw_spd[64]);
+	smbus_spd_read(device, 93, 6, &raw_spd[93]);
 	return spd_ddr2_calc_unique_crc(raw_spd, len);
 }
 
 static u16 ddr3_get_crc(u8 device, u8 len)
 {
 	u8 raw_spd[256] = {};
-	i2c_eeprom_read(device, 117, 11, &raw_spd[117]);
+	smbus_spd_read(device, 117, 11, &raw_spd[117]);
 	return spd_ddr3_calc_unique_crc(raw_spd, len);
 }
 
@@ -436,7 +436,7 @@ static void decode_spd_select_timings(struct sysinfo *s)
 	u8 dram_type_mask = (1 << DDR2) | (1 << DDR3);
 	u8 dimm_mask = 0;
 	u8 raw_spd[256];
-	int i, j;
+	int i;
 	struct abs_timings saved_timings;
 	memset(&saved_timings, 0, sizeof(saved_timings));
 	saved_timings.cas_supported = UINT32_MAX;
@@ -465,11 +465,10 @@ static void decode_spd_select_timings(struct sysinfo *s)
 			die("Mixing up dimm types is not supported!\n");
 
 		printk(BIOS_DEBUG, "Decoding dimm %d\n", i);
-		if (i2c_eeprom_read(device, 0, 128, raw_spd) != 128) {
-			printk(BIOS_DEBUG,
-				"i2c block operation failed, trying smbus byte operation.\n");
-			for (j = 0; j < 128; j++)
-				raw_spd[j] = smbus_read_byte(device, j);
+		if (smbus_spd_read(device, 0, 128, raw_spd) != 128) {
+			printk(BIOS_WARNING, "Reading SPD failed, skipping this DIMM.\n");
+			s->dimms[i].card_type = RAW_CARD_UNPOPULATED;
+			continue;
 		}
 
 		if (s->spd_type == DDR2){
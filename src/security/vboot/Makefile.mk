@@ -131,6 +131,7 @@ romstage-$(CONFIG_MRC_SAVE_HASH_IN_TPM) += mrc_cache_hash_tpm.c
 ramstage-$(CONFIG_MRC_SAVE_HASH_IN_TPM) += mrc_cache_hash_tpm.c
 
 ramstage-$(CONFIG_SOC_AMD_GFX_CACHE_VBIOS_IN_FMAP) += vbios_cache_hash_tpm.c
+ramstage-$(CONFIG_PCI_OPROM_CACHE_HASH_TPM) += vbios_cache_hash_tpm.c
 
 ifeq ($(CONFIG_VBOOT_X86_RSA_ACCELERATION),y)
 CPPFLAGS_common += -DVB2_X86_RSA_ACCELERATION
@@ -3,19 +3,19 @@
 #ifndef AMD_BLOCK_STB_H
 #define AMD_BLOCK_STB_H
 
+#include <commonlib/amd_stb_serialized.h>
 #include <types.h>
 
 #define AMD_STB_PMI_0			0x30600
 
-#define AMD_STB_COREBOOT_POST_PREFIX	0xBA000000
-#define AMD_STB_COREBOOT_MARKER		0xBAADF00D
-
 struct stb_entry_struct {
 	uint32_t ts;
 	uint32_t val;
 };
 
 void write_stb_to_console(void);
+/* Drain the STB into the CBMEM_ID_AMD_STB_LOG entry, if there is one. */
+void write_stb_to_cbmem(void);
 void add_stb_to_timestamp_buffer(void);
 
 #endif /* AMD_BLOCK_STB_H */
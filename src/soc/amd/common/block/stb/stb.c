@@ -9,6 +9,7 @@
 #include <console/console.h>
 #include <soc/smu.h>
 #include <soc/stb.h>
+#include <timestamp.h>
 
 #define STB_ENTRIES_PER_ROW 4
 
@@ -66,6 +67,71 @@ void write_stb_to_console(void)
 	}
 }
 
+/*
+ * The log holds one full drain of the STB SRAM FIFO from romstage and one
+ * from ramstage.
+ */
+#define STB_LOG_MAX_ENTRIES	(2 * AMD_STB_SDRAM_FIFO_SIZE)
+
+static void stb_log_init(int is_recovery)
+{
+	struct amd_stb_log *log;
+
+	if (!CONFIG(WRITE_STB_BUFFER_TO_CBMEM))
+		return;
+
+	log = cbmem_add(CBMEM_ID_AMD_STB_LOG, sizeof(*log) +
+			STB_LOG_MAX_ENTRIES * sizeof(log->entries[0]));
+	if (!log) {
+		printk(BIOS_ERR, "Could not allocate cbmem buffer for STB log\n");
+		return;
+	}
+
+	/* The timestamps this log is correlated with start over on every boot. */
+	log->magic = AMD_STB_LOG_MAGIC;
+	log->max_entries = STB_LOG_MAX_ENTRIES;
+	log->num_entries = 0;
+	log->reserved = 0;
+
+	write_stb_to_cbmem();
+}
+
+void write_stb_to_cbmem(void)
+{
+	struct amd_stb_log *log;
+	int i;
+
+	if (!ENV_HAS_CBMEM)
+		return;
+
+	log = cbmem_find(CBMEM_ID_AMD_STB_LOG);
+	if (!log || log->magic != AMD_STB_LOG_MAGIC)
+		return;
+
+	/* Tie the STB time to the coreboot timeline, then mark the end. */
+	stb_write32(AMD_STB_PMI_0, AMD_STB_COREBOOT_SYNC);
+	timestamp_add_now(TS_AMD_STB_SYNC);
+	stb_write32(AMD_STB_PMI_0, AMD_STB_COREBOOT_MARKER);
+
+	for (i = 0; i < AMD_STB_SDRAM_FIFO_SIZE; i++) {
+		struct amd_stb_log_entry val;
+
+		/* Same value, then timestamp, ordering as write_stb_to_console() */
+		val.val = stb_read32(AMD_STB_PMI_0);
+		val.ts = stb_read32(AMD_STB_PMI_0);
+
+		if (val.val == AMD_STB_COREBOOT_MARKER)
+			break;
+
+		if (log->num_entries >= log->max_entries)
+			continue;
+
+		log->entries[log->num_entries++] = val;
+	}
+
+	printk(BIOS_DEBUG, "STB: %u entries in cbmem log\n", log->num_entries);
+}
+
 static void init_spill_buffer(void *unused)
 {
 	struct smu_payload smu_payload = {0};
@@ -100,7 +166,11 @@ static void final_stb_console(void *unused)
 {
 	if (CONFIG(WRITE_STB_BUFFER_TO_CONSOLE))
 		write_stb_to_console();
+	if (CONFIG(WRITE_STB_BUFFER_TO_CBMEM))
+		write_stb_to_cbmem();
 }
 
+CBMEM_CREATION_HOOK(stb_log_init);
+
 BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, init_spill_buffer, NULL);
 BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, final_stb_console, NULL);
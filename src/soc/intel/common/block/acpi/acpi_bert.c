@@ -7,33 +7,19 @@
 #include <intelblocks/acpi.h>
 #include <intelblocks/crashlog.h>
 
-static bool boot_error_src_present(cl_node_t *head)
-{
-	if (!discover_crashlog()) {
-		printk(BIOS_SPEW, "Crashlog discovery result: crashlog not found\n");
-		return false;
-	}
-
-	collect_pmc_and_cpu_crashlog_from_srams(head);
-
-	/* Discovery tables sizes can be larger than the actual valid collected data */
-	u32 crashlog_size = cl_get_total_data_size();
-
-	return (crashlog_size > 0);
-}
-
 static enum cb_err record_crashlog_into_bert(void **region, size_t *length)
 {
 	acpi_generic_error_status_t *status = NULL;
 	size_t gesb_header_size;
 	void *cl_acpi_data = NULL;
-	cl_node_t cl_list_head = {.size = 0, .data = NULL, .next = NULL};
+	const struct cl_records *records = cl_get_records();
+	const struct cl_record *rec;
 
-	if (!boot_error_src_present(&cl_list_head)) {
+	if (!records)
 		return CB_ERR;
-	}
 
-	if (!cl_get_total_data_size()) {
+	/* Discovery tables sizes can be larger than the actual valid collected data */
+	if (!cl_get_total_data_size() || !records->count) {
 		printk(BIOS_ERR, "No crashlog record present\n");
 		return CB_ERR;
 	}
@@ -46,19 +32,17 @@ static enum cb_err record_crashlog_into_bert(void **region, size_t *length)
 		return CB_ERR;
 	}
 
-	if (cl_get_total_data_size() > bert_storage_remaining()) {
+	if (records->used > bert_storage_remaining()) {
 		printk(BIOS_ERR, "Crashlog entry would exceed available region\n");
 		return CB_ERR;
 	}
 
 	bool multi_entry = false;
-	cl_node_t *cl_node = cl_list_head.next;
-	while (cl_node) {
+	rec = cl_first_record(records);
+	for (u32 i = 0; i < records->count; i++, rec = cl_next_record(rec)) {
 
-		if ((cl_node->size <= 0) || (!(cl_node->data))) {
-			cl_node = cl_node->next;
+		if (!rec->size)
 			continue;
-		}
 
 		if (multi_entry) {
 			if (!bert_append_fw_err(status)) {
@@ -67,17 +51,14 @@ static enum cb_err record_crashlog_into_bert(void **region, size_t *length)
 			}
 		}
 
-		cl_acpi_data = new_cper_fw_error_crashlog(status, cl_node->size);
+		cl_acpi_data = new_cper_fw_error_crashlog(status, rec->size);
 		if (!cl_acpi_data) {
 			printk(BIOS_ERR, "Crashlog entry(size 0x%x) would exceed available region\n",
-					cl_node->size);
+					rec->size);
 			return CB_ERR;
 		}
-		memcpy(cl_acpi_data, (void *) cl_node->data, cl_node->size);
+		memcpy(cl_acpi_data, rec->data, rec->size);
 
-		cl_node_t *temp = cl_node;
-		cl_node = cl_node->next;
-		free_cl_node(temp);
 		multi_entry = true;
 	}
 
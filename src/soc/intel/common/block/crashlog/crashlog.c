@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <acpi/acpi.h>
+#include <bootstate.h>
 #include <cbmem.h>
 #include <console/console.h>
 #include <delay.h>
@@ -7,6 +9,14 @@
 #include <intelblocks/crashlog.h>
 #include <intelblocks/pmc_ipc.h>
 #include <string.h>
+#include <thread.h>
+#include <timestamp.h>
+
+/* Number of DWORDs copied from SRAM before letting other threads run */
+#define CL_COPY_YIELD_DWORDS	128
+
+static struct cl_records *cl_records;
+static struct thread_handle cl_thread;
 
 int __weak cl_get_cpu_record_size(void)
 {
@@ -326,40 +336,41 @@ bool cl_copy_data_from_sram(u32 src_bar,
 		dest_addr++;
 		src_addr += 4;
 		copied++;
+		/* Large telemetry regions shouldn't hold up the main thread */
+		if (!(copied % CL_COPY_YIELD_DWORDS))
+			thread_yield();
 	}
 	return true;
 }
 
-cl_node_t *malloc_cl_node(size_t len)
+u32 *cl_reserve_record(size_t len)
 {
-	cl_node_t *node = malloc(sizeof(cl_node_t));
-	if (!node)
-		return NULL;
+	struct cl_record *rec;
+	const size_t size = len * sizeof(u32);
 
-	node->data = malloc(len * sizeof(u32));
-	if (!(node->data))
+	if (!cl_records || cl_records->capacity - cl_records->used < sizeof(*rec) + size) {
+		printk(BIOS_ERR, "No space for crashlog record of 0x%zx bytes\n", size);
 		return NULL;
+	}
 
-	node->size = len * sizeof(u32);
-	node->next = NULL;
+	rec = (struct cl_record *)&cl_records->data[cl_records->used];
+	rec->size = size;
 
-	return node;
+	return rec->data;
 }
 
-void free_cl_node(cl_node_t *node)
+void cl_commit_record(void)
 {
-	if (!node)
-		return;
-	if (node->data)
-		free(node->data);
-	free(node);
+	const struct cl_record *rec = (struct cl_record *)&cl_records->data[cl_records->used];
+
+	cl_records->used += sizeof(*rec) + rec->size;
+	cl_records->count++;
 }
 
-void __weak cl_get_pmc_sram_data(cl_node_t *head)
+void __weak cl_get_pmc_sram_data(void)
 {
 	u32 tmp_bar_addr = cl_get_cpu_tmp_bar();
 	u32 pmc_crashLog_size = cl_get_pmc_record_size();
-	cl_node_t *cl_cur = head;
 
 	if (!cl_pmc_sram_has_mmio_access() || !tmp_bar_addr)
 		return;
@@ -393,59 +404,44 @@ void __weak cl_get_pmc_sram_data(cl_node_t *head)
 	bool pmc_sram = true;
 	pmc_crashlog_desc_table_t descriptor_table = cl_get_pmc_descriptor_table();
 
-	/* goto tail node */
-	while (cl_cur && cl_cur->next) {
-		cl_cur = cl_cur->next;
-	}
-
 	if (discovery_buf.bits.discov_mechanism == 1) {
 		for (int i = 0; i < descriptor_table.numb_regions; i++) {
 
-			cl_node_t *cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
-			if (!cl_node) {
-				printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n", i);
+			u32 *record = cl_reserve_record(descriptor_table.regions[i].bits.size);
+			if (!record)
 				goto pmc_send_re_arm_after_reset;
-			}
 
 			if (cl_copy_data_from_sram(tmp_bar_addr,
 						descriptor_table.regions[i].bits.offset,
 						descriptor_table.regions[i].bits.size,
-						cl_node->data,
+						record,
 						i,
 						pmc_sram)) {
-				cl_cur->next = cl_node;
-				cl_cur = cl_cur->next;
+				cl_commit_record();
 			} else {
 				pmc_crashLog_size -= descriptor_table.regions[i].bits.size *
 							sizeof(u32);
 				printk(BIOS_DEBUG, "discover mode PMC crashlog size adjusted"
 						" to: 0x%x\n", pmc_crashLog_size);
-				/* free cl_node */
-				free_cl_node(cl_node);
 			}
 		}
 	} else {
 
-		cl_node_t *cl_node = malloc_cl_node(discovery_buf.bits.size);
-		if (!cl_node) {
-			printk(BIOS_DEBUG, "failed to allocate cl_node\n");
+		u32 *record = cl_reserve_record(discovery_buf.bits.size);
+		if (!record)
 			goto pmc_send_re_arm_after_reset;
-		}
 
 		if (cl_copy_data_from_sram(tmp_bar_addr,
 					discovery_buf.bits.base_offset,
 					discovery_buf.bits.size,
-					cl_node->data,
+					record,
 					0,
 					pmc_sram)) {
-			cl_cur->next = cl_node;
-			cl_cur = cl_cur->next;
+			cl_commit_record();
 		} else {
 			pmc_crashLog_size -= discovery_buf.bits.size * sizeof(u32);
 			printk(BIOS_DEBUG, "legacy mode PMC crashlog size adjusted to: 0x%x\n",
 					pmc_crashLog_size);
-			/* free cl_node */
-			free_cl_node(cl_node);
 		}
 	}
 
@@ -461,9 +457,8 @@ pmc_send_re_arm_after_reset:
 
 }
 
-void cl_get_cpu_sram_data(cl_node_t *head)
+void cl_get_cpu_sram_data(void)
 {
-	cl_node_t *cl_cur = head;
 	u32 m_cpu_crashLog_size = cl_get_cpu_record_size();
 	cpu_crashlog_discovery_table_t cpu_cl_disc_tab = cl_get_cpu_discovery_table();
 
@@ -475,11 +470,6 @@ void cl_get_cpu_sram_data(cl_node_t *head)
 	printk(BIOS_DEBUG, "CPU crash data size: 0x%X bytes in 0x%X region(s).\n",
 			m_cpu_crashLog_size, cpu_cl_disc_tab.header.fields.count);
 
-	/* goto tail node */
-	while (cl_cur && cl_cur->next) {
-		cl_cur = cl_cur->next;
-	}
-
 	for (int i = 0 ; i < cpu_cl_disc_tab.header.fields.count ; i++) {
 
 		u32 cpu_bar_addr = cl_get_cpu_bar_addr();
@@ -489,25 +479,21 @@ void cl_get_cpu_sram_data(cl_node_t *head)
 			continue;
 		}
 
-		cl_node_t *cl_node = malloc_cl_node(cpu_cl_disc_tab.buffers[i].fields.size);
-		if (!cl_node) {
-			printk(BIOS_DEBUG, "failed to allocate cl_node [buffer = %d]\n", i);
+		u32 *record = cl_reserve_record(cpu_cl_disc_tab.buffers[i].fields.size);
+		if (!record)
 			return;
-		}
 
 		if (cl_copy_data_from_sram(cpu_bar_addr,
 					cpu_cl_disc_tab.buffers[i].fields.offset,
 					cpu_cl_disc_tab.buffers[i].fields.size,
-					cl_node->data,
+					record,
 					i,
 					pmc_sram)) {
-			cl_cur->next = cl_node;
-			cl_cur = cl_cur->next;
+			cl_commit_record();
 
 		} else {
 			m_cpu_crashLog_size -= cpu_cl_disc_tab.buffers[i].fields.size
 				* sizeof(u32);
-			free_cl_node(cl_node);
 			/* for CPU skip all buffers if the 1st one is not valid */
 			if (i == 0) {
 				m_cpu_crashLog_size = 0;
@@ -526,7 +512,7 @@ void cl_get_cpu_sram_data(cl_node_t *head)
 	cpu_cl_rearm();
 }
 
-void collect_pmc_and_cpu_crashlog_from_srams(cl_node_t *head)
+void collect_pmc_and_cpu_crashlog_from_srams(void)
 {
 	if (pmc_crashlog_support() && cl_pmc_data_present()
 		&& (cl_get_pmc_record_size() > 0)) {
@@ -534,7 +520,7 @@ void collect_pmc_and_cpu_crashlog_from_srams(cl_node_t *head)
 			cl_pmc_en_gen_on_all_reboot();
 			printk(BIOS_DEBUG, "Crashlog collection enabled on every reboot.\n");
 		}
-		cl_get_pmc_sram_data(head);
+		cl_get_pmc_sram_data();
 	} else {
 		printk(BIOS_DEBUG, "Skipping PMC crashLog collection. Data not present.\n");
 	}
@@ -544,8 +530,89 @@ void collect_pmc_and_cpu_crashlog_from_srams(cl_node_t *head)
 	if (cpu_crashlog_support() && cl_cpu_data_present()
 		&& (cl_get_cpu_record_size() > 0)) {
 		printk(BIOS_DEBUG, "CPU crashLog present.\n");
-		cl_get_cpu_sram_data(head);
+		cl_get_cpu_sram_data();
 	} else {
 		printk(BIOS_DEBUG, "Skipping CPU crashLog collection. Data not present.\n");
 	}
 }
+
+/* Allocate the CBMEM area for the records, sized by the discovery results. */
+static bool cl_records_init(void)
+{
+	const pmc_crashlog_desc_table_t pmc_table = cl_get_pmc_descriptor_table();
+	const cpu_crashlog_discovery_table_t cpu_table = cl_get_cpu_discovery_table();
+	/* One record per PMC region (plus one for the legacy mode) and per CPU buffer */
+	const size_t max_records = pmc_table.numb_regions + 1 + cpu_table.header.fields.count;
+	const size_t capacity = cl_get_total_data_size() +
+				max_records * sizeof(struct cl_record);
+
+	cl_records = cbmem_add(CBMEM_ID_CRASHLOG, sizeof(*cl_records) + capacity);
+	if (!cl_records) {
+		printk(BIOS_ERR, "Failed to allocate crashlog records\n");
+		return false;
+	}
+
+	cl_records->count = 0;
+	cl_records->used = 0;
+	cl_records->capacity = capacity;
+
+	return true;
+}
+
+static enum cb_err cl_collect(void *unused)
+{
+	enum cb_err ret = CB_ERR;
+
+	timestamp_add_now(TS_CRASHLOG_COLLECT_START);
+
+	if (!discover_crashlog()) {
+		printk(BIOS_SPEW, "Crashlog discovery result: crashlog not found\n");
+		goto out;
+	}
+
+	if (!cl_records_init())
+		goto out;
+
+	collect_pmc_and_cpu_crashlog_from_srams();
+	ret = CB_SUCCESS;
+
+out:
+	timestamp_add_now(TS_CRASHLOG_COLLECT_END);
+	return ret;
+}
+
+/*
+ * Collect the crashlog in the background once the SRAM and telemetry BARs are enabled, so
+ * that the MMIO reads overlap with device initialization.
+ */
+static void cl_start_collection(void *unused)
+{
+	if (!CONFIG(COOP_MULTITASKING) || !CONFIG(SOC_INTEL_CRASHLOG))
+		return;
+
+	/* BERT isn't generated on S3 resume, so leave the records for the next boot. */
+	if (acpi_is_wakeup_s3())
+		return;
+
+	printk(BIOS_DEBUG, "Starting crashlog collection\n");
+	if (thread_run(&cl_thread, cl_collect, NULL))
+		printk(BIOS_ERR, "Failed to start crashlog collection thread\n");
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_ENABLE, BS_ON_EXIT, cl_start_collection, NULL);
+
+const struct cl_records *cl_get_records(void)
+{
+	static enum cb_err ret;
+	static bool collected;
+
+	if (!collected) {
+		if (CONFIG(COOP_MULTITASKING) && cl_thread.state != THREAD_UNINITIALIZED)
+			ret = thread_join(&cl_thread);
+		else
+			ret = cl_collect(NULL);
+		collected = true;
+	}
+
+	return ret == CB_SUCCESS ? cl_records : NULL;
+}
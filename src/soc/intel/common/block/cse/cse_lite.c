@@ -16,6 +16,7 @@
 #include <security/vboot/misc.h>
 #include <security/vboot/vboot_common.h>
 #include <soc/intel/common/reset.h>
+#include <string.h>
 #include <timestamp.h>
 
 #include "cse_lite_cmos.h"
@@ -35,6 +36,30 @@
 /* CSE RW boot partition signature size */
 #define CSE_RW_SIGN_SIZE	sizeof(uint32_t)
 
+/* CSE firmware is updated in SPI flash erase block granularity */
+#define CSE_UPDATE_BLOCK_SIZE	(4 * KiB)
+
+/* Chunk size used to compare the flash contents with the new image */
+#define CSE_UPDATE_CMP_SIZE	256
+
+/*
+ * While the RW boot partition is updated, its first erase block holds this record instead
+ * of the boot partition signature. The bit of every block written is cleared in `done`,
+ * which doesn't need an erase, so an interrupted update resumes where it stopped.
+ */
+#define CSE_RW_UPDATE_SIGNATURE		0x55455343	/* 'CSEU' */
+#define CSE_RW_UPDATE_MAX_BLOCKS	(8 * 1024)
+
+struct cse_rw_update_record {
+	uint32_t signature;
+	struct fw_version version;
+	uint32_t image_size;
+	uint8_t done[CSE_RW_UPDATE_MAX_BLOCKS / 8];
+} __packed;
+
+_Static_assert(sizeof(struct cse_rw_update_record) <= CSE_UPDATE_BLOCK_SIZE,
+	       "CSE RW update record exceeds the first block");
+
 /*
  * CSE Firmware supports 3 boot partitions. For CSE Lite SKU, only 2 boot partitions are
  * used and 3rd boot partition is set to BP_STATUS_PARTITION_NOT_PRESENT.
@@ -804,9 +829,10 @@ static int cse_compare_sub_part_version(const struct fw_version *a, const struct
 		return a->build - b->build;
 }
 
-static enum cb_err cse_erase_rw_region(const struct region_device *target_rdev)
+static enum cb_err cse_erase_rw_region(const struct region_device *target_rdev,
+		size_t offset, size_t size)
 {
-	if (rdev_eraseat(target_rdev, 0, region_device_sz(target_rdev)) < 0) {
+	if (rdev_eraseat(target_rdev, offset, size) < 0) {
 		printk(BIOS_ERR, "cse_lite: CSE RW partition could not be erased\n");
 		return CB_ERR;
 	}
@@ -824,12 +850,138 @@ static enum cb_err cse_copy_rw(const struct region_device *target_rdev, const vo
 	return CB_SUCCESS;
 }
 
+/*
+ * Check if the flash holds the image contents in the given range. The flash past the end
+ * of the image is expected to be erased.
+ */
+static bool cse_flash_matches(const struct region_device *target_rdev, const uint8_t *image,
+		size_t image_sz, size_t offset, size_t size)
+{
+	uint8_t flash[CSE_UPDATE_CMP_SIZE];
+	size_t pos, len, image_len;
+
+	for (pos = offset; pos < offset + size; pos += len) {
+		len = MIN(sizeof(flash), offset + size - pos);
+		image_len = pos < image_sz ? MIN(len, image_sz - pos) : 0;
+
+		if (rdev_readat(target_rdev, flash, pos, len) != len)
+			return false;
+
+		if (memcmp(flash, image + pos, image_len))
+			return false;
+
+		for (size_t i = image_len; i < len; i++)
+			if (flash[i] != 0xff)
+				return false;
+	}
+
+	return true;
+}
+
+static enum cb_err cse_rw_update_mark_done(const struct region_device *target_rdev,
+		size_t block)
+{
+	/* Blocks are written in order, so all lower bits of the byte are cleared already. */
+	const uint8_t done = 0xff << (block % 8 + 1);
+
+	if (block >= CSE_RW_UPDATE_MAX_BLOCKS)
+		return CB_SUCCESS;
+
+	return cse_copy_rw(target_rdev, &done,
+			   offsetof(struct cse_rw_update_record, done) + block / 8, 1);
+}
+
+/*
+ * Update the flash from block `first` on. Blocks that already hold the new contents are
+ * neither erased nor programmed, so only the changed parts of the image cost flash cycles.
+ */
+static enum cb_err cse_diff_update(const struct region_device *target_rdev,
+		const void *image, size_t image_sz, size_t first, bool track_progress)
+{
+	const size_t region_sz = region_device_sz(target_rdev);
+	size_t offset, size, block, written = 0;
+
+	for (block = first; block * CSE_UPDATE_BLOCK_SIZE < region_sz; block++) {
+		offset = block * CSE_UPDATE_BLOCK_SIZE;
+		size = MIN(CSE_UPDATE_BLOCK_SIZE, region_sz - offset);
+
+		if (!cse_flash_matches(target_rdev, image, image_sz, offset, size)) {
+			if (cse_erase_rw_region(target_rdev, offset, size) != CB_SUCCESS)
+				return CB_ERR;
+
+			if (offset < image_sz && cse_copy_rw(target_rdev,
+					(const uint8_t *)image + offset, offset,
+					MIN(size, image_sz - offset)) != CB_SUCCESS)
+				return CB_ERR;
+
+			written++;
+		}
+
+		if (track_progress && cse_rw_update_mark_done(target_rdev, block) != CB_SUCCESS)
+			return CB_ERR;
+	}
+
+	printk(BIOS_INFO, "cse_lite: Wrote %zu of %zu blocks\n", written,
+	       DIV_ROUND_UP(region_sz, CSE_UPDATE_BLOCK_SIZE) - first);
+
+	return CB_SUCCESS;
+}
+
+/* Check if the RW boot partition holds the record of an update to `version`. */
+static bool cse_read_rw_update_record(const struct region_device *target_rdev,
+		const struct fw_version *version, struct cse_rw_update_record *record)
+{
+	if (rdev_readat(target_rdev, record, 0, sizeof(*record)) != sizeof(*record))
+		return false;
+
+	return record->signature == CSE_RW_UPDATE_SIGNATURE &&
+	       !memcmp(&record->version, version, sizeof(*version));
+}
+
+/* Returns the first block an interrupted update still has to write, 0 if there is none. */
+static size_t cse_rw_update_resume_block(const struct region_device *target_rdev,
+		const struct fw_version *version, size_t image_sz)
+{
+	struct cse_rw_update_record record;
+	size_t block;
+
+	if (!cse_read_rw_update_record(target_rdev, version, &record) ||
+	    record.image_size != image_sz)
+		return 0;
+
+	/* Block 0 holds the record itself and is written last. */
+	for (block = 1; block < CSE_RW_UPDATE_MAX_BLOCKS; block++)
+		if (record.done[block / 8] & BIT(block % 8))
+			break;
+
+	return block;
+}
+
+/* Invalidate the RW boot partition by replacing its first block with the update record. */
+static enum cb_err cse_rw_update_start(const struct region_device *target_rdev,
+		const struct fw_version *version, size_t image_sz)
+{
+	struct cse_rw_update_record record;
+
+	memset(&record, 0xff, sizeof(record));
+	record.signature = CSE_RW_UPDATE_SIGNATURE;
+	record.version = *version;
+	record.image_size = image_sz;
+
+	if (cse_erase_rw_region(target_rdev, 0,
+			MIN(CSE_UPDATE_BLOCK_SIZE, region_device_sz(target_rdev))) != CB_SUCCESS)
+		return CB_ERR;
+
+	return cse_copy_rw(target_rdev, &record, 0, sizeof(record));
+}
+
 enum cse_update_status {
 	CSE_UPDATE_NOT_REQUIRED,
 	CSE_UPDATE_UPGRADE,
 	CSE_UPDATE_DOWNGRADE,
 	CSE_UPDATE_CORRUPTED,
 	CSE_UPDATE_METADATA_ERROR,
+	CSE_UPDATE_RESUME,
 };
 
 static bool read_ver_field(const char *start, char **curr, size_t size, uint16_t *ver_field)
@@ -876,9 +1028,15 @@ static enum cse_update_status cse_check_update_status(struct region_device *targ
 {
 	int ret;
 	struct fw_version cbfs_rw_version;
+	struct cse_rw_update_record record;
 
-	if (!cse_is_rw_bp_sign_valid(target_rdev))
+	if (!cse_is_rw_bp_sign_valid(target_rdev)) {
+		/* The update to the same CBFS RW version was interrupted. */
+		if (get_cse_ver_from_cbfs(&cbfs_rw_version) == CB_SUCCESS &&
+		    cse_read_rw_update_record(target_rdev, &cbfs_rw_version, &record))
+			return CSE_UPDATE_RESUME;
 		return CSE_UPDATE_CORRUPTED;
+	}
 
 	if (get_cse_ver_from_cbfs(&cbfs_rw_version) == CB_ERR)
 		return CSE_UPDATE_METADATA_ERROR;
@@ -898,14 +1056,20 @@ static enum cse_update_status cse_check_update_status(struct region_device *targ
 		return CSE_UPDATE_UPGRADE;
 }
 
+/* Replace the update record with the first block of the image, the signature goes last. */
 static enum cb_err cse_write_rw_region(const struct region_device *target_rdev,
 		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz)
 {
+	const size_t block_sz = MIN(CSE_UPDATE_BLOCK_SIZE, region_device_sz(target_rdev));
+
 	/* Points to CSE CBFS RW image after boot partition signature */
 	uint8_t *cse_cbfs_rw_wo_sign = (uint8_t *)cse_cbfs_rw + CSE_RW_SIGN_SIZE;
 
-	/* Size of CSE CBFS RW image without boot partition signature */
-	uint32_t cse_cbfs_rw_wo_sign_sz = cse_cbfs_rw_sz - CSE_RW_SIGN_SIZE;
+	/* Size of the first block of CSE CBFS RW image without boot partition signature */
+	uint32_t cse_cbfs_rw_wo_sign_sz = MIN(block_sz, cse_cbfs_rw_sz) - CSE_RW_SIGN_SIZE;
+
+	if (cse_erase_rw_region(target_rdev, 0, block_sz) != CB_SUCCESS)
+		return CB_ERR;
 
 	/* Update except CSE RW signature */
 	if (cse_copy_rw(target_rdev, cse_cbfs_rw_wo_sign, CSE_RW_SIGN_SIZE,
@@ -931,16 +1095,36 @@ static bool is_cse_fw_update_enabled(void)
 	return true;
 }
 
+/*
+ * The RW boot partition is updated in three steps: its first block is replaced with the
+ * update record, which invalidates the partition. Then all other blocks are updated, skipping
+ * the ones that already match. Last, the first block of the image is written.
+ */
 static enum csme_failure_reason cse_update_rw(const void *cse_cbfs_rw, const size_t cse_blob_sz,
 		struct region_device *target_rdev)
 {
-	if (region_device_sz(target_rdev) < cse_blob_sz) {
+	struct fw_version cbfs_rw_version;
+	size_t first;
+
+	if (region_device_sz(target_rdev) < cse_blob_sz || cse_blob_sz < CSE_RW_SIGN_SIZE) {
 		printk(BIOS_ERR, "RW update does not fit. CSE RW flash region size: %zx,"
 			"Update blob size:%zx\n", region_device_sz(target_rdev), cse_blob_sz);
 		return CSE_LITE_SKU_LAYOUT_MISMATCH_ERROR;
 	}
 
-	if (cse_erase_rw_region(target_rdev) != CB_SUCCESS)
+	if (get_cse_ver_from_cbfs(&cbfs_rw_version) != CB_SUCCESS)
+		return CSE_LITE_SKU_RW_METADATA_NOT_FOUND;
+
+	first = cse_rw_update_resume_block(target_rdev, &cbfs_rw_version, cse_blob_sz);
+	if (first) {
+		printk(BIOS_INFO, "cse_lite: Resuming CSE RW update at block %zu\n", first);
+	} else {
+		if (cse_rw_update_start(target_rdev, &cbfs_rw_version, cse_blob_sz) != CB_SUCCESS)
+			return CSE_LITE_SKU_FW_UPDATE_ERROR;
+		first = 1;
+	}
+
+	if (cse_diff_update(target_rdev, cse_cbfs_rw, cse_blob_sz, first, true) != CB_SUCCESS)
 		return CSE_LITE_SKU_FW_UPDATE_ERROR;
 
 	if (cse_write_rw_region(target_rdev, cse_cbfs_rw, cse_blob_sz) != CB_SUCCESS)
@@ -1150,6 +1334,7 @@ static uint8_t cse_fw_update(void)
 {
 	struct region_device target_rdev;
 	enum cse_update_status status;
+	uint8_t rv;
 
 	if (cse_get_target_rdev(&target_rdev) != CB_SUCCESS) {
 		printk(BIOS_ERR, "cse_lite: Failed to get CSE RW Partition\n");
@@ -1165,7 +1350,11 @@ static uint8_t cse_fw_update(void)
 		initiate_psr_data_backup();
 
 	printk(BIOS_DEBUG, "cse_lite: CSE RW update is initiated\n");
-	return cse_trigger_fw_update(status, &target_rdev);
+	timestamp_add_now(TS_CSE_RW_UPDATE_START);
+	rv = cse_trigger_fw_update(status, &target_rdev);
+	timestamp_add_now(TS_CSE_RW_UPDATE_END);
+
+	return rv;
 }
 
 static const char *cse_sub_part_str(enum bpdt_entry_type type)
@@ -1224,6 +1413,12 @@ static enum cb_err cse_sub_part_get_target_rdev(struct region_device *target_rde
 		return CB_ERR;
 	}
 
+	/* An erased or partially updated boot partition has no valid BPDT. */
+	if (bpdt_hdr.descriptor_count > MAX_SUBPARTS) {
+		printk(BIOS_ERR, "cse_lite: Invalid BPDT in CSE %s\n", cse_regions[bp]);
+		return CB_ERR;
+	}
+
 	if ((rdev_readat(&cse_rdev, bpdt_entries, BPDT_HEADER_SZ,
 		(bpdt_hdr.descriptor_count * BPDT_ENTRY_SZ))) !=
 		(bpdt_hdr.descriptor_count * BPDT_ENTRY_SZ)) {
@@ -1318,12 +1513,8 @@ static enum csme_failure_reason cse_sub_part_trigger_update(enum bpdt_entry_type
 		return CSE_LITE_SKU_SUB_PART_LAYOUT_MISMATCH_ERROR;
 	}
 
-	/* Erase CSE Lite sub-partition */
-	if (cse_erase_rw_region(target_rdev) != CB_SUCCESS)
-		return CSE_LITE_SKU_SUB_PART_UPDATE_FAIL;
-
-	/* Update CSE Lite sub-partition */
-	if (cse_copy_rw(target_rdev, (void *)subpart_cbfs_rw, 0, blob_sz) != CB_SUCCESS)
+	/* Update the changed blocks of the CSE Lite sub-partition */
+	if (cse_diff_update(target_rdev, subpart_cbfs_rw, blob_sz, 0, false) != CB_SUCCESS)
 		return CSE_LITE_SKU_SUB_PART_UPDATE_FAIL;
 
 	printk(BIOS_INFO, "cse_lite: CSE %s %s Update successful\n", GET_BP_STR(bp),
@@ -1396,8 +1587,10 @@ static enum csme_failure_reason cse_sub_part_fw_component_update(enum bpdt_entry
 			goto error_exit;
 		}
 
+		timestamp_add_now(TS_CSE_SUB_PART_UPDATE_START);
 		rv = cse_sub_part_trigger_update(type, bp, subpart_cbfs_rw,
 				size, &target_rdev);
+		timestamp_add_now(TS_CSE_SUB_PART_UPDATE_END);
 
 		if (rv != CSE_LITE_SKU_PART_UPDATE_SUCCESS)
 			goto error_exit;
@@ -3,6 +3,7 @@
 #include <device/mmio.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
+#include <cpu/x86/cache.h>
 #include <fast_spi_def.h>
 #include <intelblocks/fast_spi.h>
 #include <soc/pci_devs.h>
@@ -189,6 +190,86 @@ static size_t get_xfer_len(const struct spi_flash *flash, uint32_t addr,
 	return xfer_len;
 }
 
+/*
+ * Memory-mapped windows of the BIOS region. The top 16MiB are decoded just below 4GiB, the
+ * rest in the extended BIOS window if the platform has one. See mmap_boot.c.
+ */
+static struct fast_spi_mmap_window {
+	uint32_t flash_base;
+	uintptr_t host_base;
+	size_t size;
+} mmap_windows[2];
+static bool mmap_windows_done;
+
+static void fast_spi_flash_mmap_init(void)
+{
+	size_t bios_start, bios_size, fixed_size;
+
+	if (mmap_windows_done)
+		return;
+	mmap_windows_done = true;
+
+	bios_start = fast_spi_get_bios_region(&bios_size);
+	fixed_size = MIN(16 * MiB, bios_size);
+	mmap_windows[0].flash_base = bios_start + bios_size - fixed_size;
+	mmap_windows[0].host_base = 4ULL * GiB - fixed_size;
+	mmap_windows[0].size = fixed_size;
+
+	if (CONFIG(FAST_SPI_SUPPORTS_EXT_BIOS_WINDOW)) {
+		fast_spi_get_ext_bios_window(&mmap_windows[1].host_base, &mmap_windows[1].size);
+		mmap_windows[1].flash_base = mmap_windows[0].flash_base - mmap_windows[1].size;
+	}
+}
+
+/* Return the host address of [addr, addr + len) if it's decoded in one window, else 0. */
+static uintptr_t fast_spi_flash_mmap_addr(uint32_t addr, size_t len)
+{
+	/*
+	 * The CPU cache is kept across all stages running from CAR and can't be flushed
+	 * without losing CAR, so a direct read could still return what was there before a
+	 * write in an earlier stage. Only read directly once DRAM is up.
+	 */
+	if (!CONFIG(FAST_SPI_MMAP_READ) || ENV_CACHE_AS_RAM)
+		return 0;
+
+	fast_spi_flash_mmap_init();
+
+	for (size_t i = 0; i < ARRAY_SIZE(mmap_windows); i++) {
+		const struct fast_spi_mmap_window *win = &mmap_windows[i];
+
+		if (addr >= win->flash_base && len <= win->size &&
+		    addr - win->flash_base <= win->size - len)
+			return win->host_base + addr - win->flash_base;
+	}
+
+	return 0;
+}
+
+/*
+ * The hardware sequencer bypasses the CPU caches, which may still hold the old contents of
+ * the memory-mapped flash. Flush them after a write or an erase.
+ */
+static void fast_spi_flash_mmap_invalidate(uint32_t addr, size_t len)
+{
+	const uintptr_t host = fast_spi_flash_mmap_addr(addr, len);
+
+	if (!host)
+		return;
+
+	for (uintptr_t line = ALIGN_DOWN(host, 64); line < host + len; line += 64)
+		clflush((void *)line);
+}
+
+static void fast_spi_flash_report(const char *path, uint32_t addr, size_t len,
+				  struct stopwatch *sw)
+{
+	const int64_t usecs = MAX(stopwatch_duration_usecs(sw), 1);
+
+	/* One byte per microsecond is one MB/s. */
+	printk(BIOS_DEBUG, "FAST_SPI: Read 0x%zx bytes at 0x%x via %s in %lld us, %lld MB/s\n",
+	       len, addr, path, usecs, len / usecs);
+}
+
 static int fast_spi_flash_erase(const struct spi_flash *flash,
 				uint32_t offset, size_t len)
 {
@@ -215,6 +296,7 @@ static int fast_spi_flash_erase(const struct spi_flash *flash,
 		       offset, erase_size / KiB);
 
 		ret = exec_sync_hwseq_xfer(ctx, erase_cycle, offset, 0);
+		fast_spi_flash_mmap_invalidate(offset, erase_size);
 		if (ret != SUCCESS)
 			return ret;
 
@@ -231,6 +313,21 @@ static int fast_spi_flash_read(const struct spi_flash *flash,
 	int ret;
 	size_t xfer_len;
 	uint8_t *data = buf;
+	const uint32_t start = addr;
+	const size_t size = len;
+	const uintptr_t host = fast_spi_flash_mmap_addr(addr, len);
+	struct stopwatch sw;
+
+	if (CONFIG(DEBUG_SPI_FLASH))
+		stopwatch_init(&sw);
+
+	/* Direct reads are much faster than 64 bytes per hardware sequencer cycle. */
+	if (host) {
+		memcpy(buf, (void *)host, len);
+		if (CONFIG(DEBUG_SPI_FLASH))
+			fast_spi_flash_report("mmap", start, size, &sw);
+		return SUCCESS;
+	}
 
 	BOILERPLATE_CREATE_CTX(ctx);
 
@@ -249,6 +346,9 @@ static int fast_spi_flash_read(const struct spi_flash *flash,
 		len -= xfer_len;
 	}
 
+	if (CONFIG(DEBUG_SPI_FLASH))
+		fast_spi_flash_report("HWSEQ", start, size, &sw);
+
 	return SUCCESS;
 }
 
@@ -267,6 +367,7 @@ static int fast_spi_flash_write(const struct spi_flash *flash,
 
 		ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
 						addr, xfer_len);
+		fast_spi_flash_mmap_invalidate(addr, xfer_len);
 		if (ret != SUCCESS)
 			return ret;
 
@@ -13,10 +13,12 @@
 #include <intelblocks/itss.h>
 #include <intelblocks/p2sb.h>
 #include <intelblocks/pcr.h>
+#include <lib.h>
 #include <security/vboot/vboot_common.h>
 #include <soc/pci_devs.h>
 #include <soc/pm.h>
 #include <stdlib.h>
+#include <timer.h>
 #include <types.h>
 
 #define GPIO_DWx_SIZE(x)	(sizeof(uint32_t) * (x))
@@ -139,104 +141,128 @@ static const struct pad_community *gpio_get_community(gpio_t pad)
 	return NULL;
 }
 
-static void gpio_configure_owner(const struct pad_config *cfg,
-				const struct pad_community *comm)
-{
-	uint32_t hostsw_own;
-	uint16_t hostsw_own_offset;
-	int pin;
-
-	pin = relative_pad_in_comm(comm, cfg->pad);
-
-	/* Based on the gpio pin number configure the corresponding bit in
-	 * HOSTSW_OWN register. Value of 0x1 indicates GPIO Driver onwership.
-	 */
-	hostsw_own_offset = comm->host_own_reg_0;
-	hostsw_own_offset += gpio_group_index_scaled(comm, pin,
-		sizeof(uint32_t));
+/*
+ * Pads are configured in batches. The configuration registers of a pad are
+ * written right away, while the changes to the registers the pads of a group
+ * share (host ownership, SMI, NMI and GPE enables, pad locks) are collected
+ * and written once per group when the batch is flushed.
+ */
+#define GPIO_BATCH_GROUPS	16
 
-	hostsw_own = pcr_read32(comm->port, hostsw_own_offset);
+struct gpio_group_batch {
+	const struct pad_community *comm;
+	size_t group;
+	uint32_t own_set;
+	uint32_t own_clear;
+	uint32_t smi_en;
+	uint32_t nmi_en;
+	uint32_t gpe_en;
+	uint32_t lock_config;
+	uint32_t lock_tx;
+};
 
-	/* The 4th bit in pad_config 1 (RO) is used to indicate if the pad
-	 * needs GPIO driver ownership.  Set the bit if GPIO driver ownership
-	 * requested, otherwise clear the bit.
-	 */
-	if (cfg->pad_config[1] & PAD_CFG_OWN_GPIO_DRIVER)
-		hostsw_own |= gpio_bitmask_within_group(comm, pin);
-	else
-		hostsw_own &= ~gpio_bitmask_within_group(comm, pin);
+static struct gpio_group_batch gpio_batch[GPIO_BATCH_GROUPS];
+static size_t gpio_batch_groups;
 
-	pcr_write32(comm->port, hostsw_own_offset, hostsw_own);
-}
+static void gpio_lock_group(const struct pad_community *comm, size_t group,
+			    uint32_t lock_config, uint32_t lock_tx);
 
-static void gpi_enable_gpe(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
+static void gpio_flush_group(const struct gpio_group_batch *b)
 {
-	uint16_t en_reg;
-	uint32_t en_value;
-
-	/* Do not configure GPE_EN if PAD is not configured for SCI/wake */
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_SCI) != PAD_CFG0_ROUTE_SCI)
-		return;
+	const struct pad_community *comm = b->comm;
+	const size_t group = b->group;
 
-	/* Get comm offset and bit mask to be set as per pin */
-	en_reg = GPI_GPE_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
+	/* A set bit in HOSTSW_OWN indicates GPIO driver ownership. */
+	pcr_rmw32(comm->port, comm->host_own_reg_0 + group * sizeof(uint32_t),
+		  ~b->own_clear, b->own_set);
 
-	/* Set enable bits */
-	pcr_or32(comm->port, en_reg, en_value);
+	if (b->smi_en) {
+		/* Write back 1 to reset the sts bits */
+		pcr_rmw32(comm->port, GPI_SMI_STS_OFFSET(comm, group), b->smi_en, 0);
+		pcr_or32(comm->port, GPI_SMI_EN_OFFSET(comm, group), b->smi_en);
+	}
 
-	if (CONFIG(DEBUG_GPIO)) {
-		printk(BIOS_DEBUG, "GPE_EN[0x%02x, %02zd]: Reg: 0x%x, Value = 0x%x\n",
-			comm->port, relative_pad_in_comm(comm, cfg->pad), en_reg,
-			pcr_read32(comm->port, en_reg));
+	/* Do not configure NMI if the platform doesn't support it */
+	if (b->nmi_en && comm->gpi_nmi_sts_reg_0 && comm->gpi_nmi_en_reg_0) {
+		pcr_rmw32(comm->port, GPI_NMI_STS_OFFSET(comm, group), b->nmi_en, 0);
+		pcr_or32(comm->port, GPI_NMI_EN_OFFSET(comm, group), b->nmi_en);
 	}
-}
 
-static void gpi_enable_smi(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
-{
-	uint16_t sts_reg;
-	uint16_t en_reg;
-	uint32_t en_value;
+	if (b->gpe_en) {
+		pcr_or32(comm->port, GPI_GPE_EN_OFFSET(comm, group), b->gpe_en);
 
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_SMI) != PAD_CFG0_ROUTE_SMI)
-		return;
+		if (CONFIG(DEBUG_GPIO)) {
+			printk(BIOS_DEBUG, "GPE_EN[0x%02x, %02zd]: Reg: 0x%x, Value = 0x%x\n",
+				comm->port, group, GPI_GPE_EN_OFFSET(comm, group),
+				pcr_read32(comm->port, GPI_GPE_EN_OFFSET(comm, group)));
+		}
+	}
 
-	sts_reg = GPI_SMI_STS_OFFSET(comm, group);
-	en_reg = GPI_SMI_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
+	if (b->lock_config || b->lock_tx)
+		gpio_lock_group(comm, group, b->lock_config, b->lock_tx);
+}
 
-	/* Write back 1 to reset the sts bit */
-	pcr_rmw32(comm->port, sts_reg, en_value, 0);
+static void gpio_flush_batch(void)
+{
+	size_t i;
 
-	/* Set enable bits */
-	pcr_or32(comm->port, en_reg, en_value);
+	for (i = 0; i < gpio_batch_groups; i++)
+		gpio_flush_group(&gpio_batch[i]);
+	gpio_batch_groups = 0;
 }
 
-static void gpi_enable_nmi(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
+static struct gpio_group_batch *gpio_batch_get(const struct pad_community *comm,
+					       size_t group)
 {
-	uint16_t sts_reg;
-	uint16_t en_reg;
-	uint32_t en_value;
+	struct gpio_group_batch *b;
+	size_t i;
 
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_NMI) != PAD_CFG0_ROUTE_NMI)
-		return;
+	/* Pad tables are mostly sorted, so look at the latest group first. */
+	for (i = gpio_batch_groups; i-- > 0;) {
+		b = &gpio_batch[i];
+		if (b->comm == comm && b->group == group)
+			return b;
+	}
 
-	/* Do not configure NMI if the platform doesn't support it */
-	if (!comm->gpi_nmi_sts_reg_0 || !comm->gpi_nmi_en_reg_0)
-		return;
+	if (gpio_batch_groups == ARRAY_SIZE(gpio_batch))
+		gpio_flush_batch();
 
-	sts_reg = GPI_NMI_STS_OFFSET(comm, group);
-	en_reg = GPI_NMI_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
+	b = &gpio_batch[gpio_batch_groups++];
+	memset(b, 0, sizeof(*b));
+	b->comm = comm;
+	b->group = group;
+	return b;
+}
 
-	/* Write back 1 to reset the sts bit */
-	pcr_rmw32(comm->port, sts_reg, en_value, 0);
+static void gpio_batch_add(const struct pad_config *cfg,
+			   const struct pad_community *comm, size_t group, uint32_t bit)
+{
+	struct gpio_group_batch *b = gpio_batch_get(comm, group);
 
-	/* Set enable bits */
-	pcr_or32(comm->port, en_reg, en_value);
+	/*
+	 * The 4th bit in pad_config 1 (RO) is used to indicate if the pad
+	 * needs GPIO driver ownership. A later entry for the same pad wins.
+	 */
+	if (cfg->pad_config[1] & PAD_CFG_OWN_GPIO_DRIVER) {
+		b->own_set |= bit;
+		b->own_clear &= ~bit;
+	} else {
+		b->own_set &= ~bit;
+		b->own_clear |= bit;
+	}
+
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_SMI) == PAD_CFG0_ROUTE_SMI)
+		b->smi_en |= bit;
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_NMI) == PAD_CFG0_ROUTE_NMI)
+		b->nmi_en |= bit;
+	/* Only configure GPE_EN if the pad is configured for SCI/wake */
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_SCI) == PAD_CFG0_ROUTE_SCI)
+		b->gpe_en |= bit;
+
+	if ((cfg->lock_action & GPIO_LOCK_CONFIG) == GPIO_LOCK_CONFIG)
+		b->lock_config |= bit;
+	if ((cfg->lock_action & GPIO_LOCK_TX) == GPIO_LOCK_TX)
+		b->lock_tx |= bit;
 }
 
 /* 120 GSIs is the default for IOxAPIC */
@@ -257,8 +283,7 @@ bool gpio_routes_ioapic_irq(uint32_t irq)
 	return (gpio_ioapic_irqs_used[word_offset] & BIT(bit_offset)) != 0;
 }
 
-static void gpio_configure_itss(const struct pad_config *cfg, uint16_t port,
-	uint16_t  pad_cfg_offset)
+static void gpio_configure_itss(const struct pad_config *cfg, uint32_t pad_cfg1)
 {
 	/* No ITSS configuration in SMM. */
 	if (ENV_SMM)
@@ -280,8 +305,7 @@ static void gpio_configure_itss(const struct pad_config *cfg, uint16_t port,
 	    !(cfg->pad_config[0] & PAD_CFG0_ROUTE_IOAPIC))
 		return;
 
-	irq = pcr_read32(port, PAD_CFG1_OFFSET(pad_cfg_offset));
-	irq &= PAD_CFG1_IRQ_MASK;
+	irq = pad_cfg1 & PAD_CFG1_IRQ_MASK;
 	if (!irq) {
 		printk(BIOS_ERR, "GPIO %u doesn't support APIC routing,\n",
 			cfg->pad);
@@ -331,23 +355,37 @@ static const int mask[4] = {
 	PAD_DW0_MASK, PAD_DW1_MASK, PAD_DW2_MASK, PAD_DW3_MASK
 };
 
-static void gpio_configure_pad(const struct pad_config *cfg)
+static const struct pad_community *gpio_find_community(gpio_t pad,
+					const struct pad_community *last)
+{
+	if (last && pad >= last->first_pad && pad <= last->last_pad)
+		return last;
+
+	return gpio_get_community(pad);
+}
+
+/*
+ * Write the configuration registers of the pad and add the rest of its
+ * configuration to the batch. Returns the community of the pad.
+ */
+static const struct pad_community *gpio_configure_pad_batched(const struct pad_config *cfg,
+					const struct pad_community *last)
 {
 	const struct pad_community *comm;
 	uint16_t config_offset;
-	uint32_t pad_conf, soc_pad_conf;
+	uint32_t pad_conf, soc_pad_conf, pad_cfg1 = 0;
 	int i, pin, group;
 
 	if (!cfg) {
 		printk(BIOS_ERR, "%s: cfg value is NULL\n", __func__);
-		return;
+		return last;
 	}
 
-	comm = gpio_get_community(cfg->pad);
+	comm = gpio_find_community(cfg->pad, last);
 	if (!comm) {
 		printk(BIOS_ERR, "%s: Could not find community for pad: 0x%x\n",
 				__func__, cfg->pad);
-		return;
+		return last;
 	}
 
 	config_offset = pad_config_offset(comm, cfg->pad);
@@ -376,25 +414,50 @@ static void gpio_configure_pad(const struct pad_config *cfg)
 			pad_conf,/* old value */
 			cfg->pad_config[i],/* value passed from gpio table */
 			soc_pad_conf);/*new value*/
-		pcr_write32(comm->port, PAD_CFG_OFFSET(config_offset, i),
-			soc_pad_conf);
+		if (soc_pad_conf != pad_conf)
+			pcr_write32(comm->port, PAD_CFG_OFFSET(config_offset, i),
+				soc_pad_conf);
+		if (i == 1)
+			pad_cfg1 = soc_pad_conf;
 	}
 
-	gpio_configure_itss(cfg, comm->port, config_offset);
-	gpio_configure_owner(cfg, comm);
-	gpi_enable_smi(cfg, comm, group, pin);
-	gpi_enable_nmi(cfg, comm, group, pin);
-	gpi_enable_gpe(cfg, comm, group, pin);
-	if (cfg->lock_action)
-		gpio_lock_pad(cfg->pad, cfg->lock_action);
+	gpio_configure_itss(cfg, pad_cfg1);
+	gpio_batch_add(cfg, comm, group, 1U << (pin - comm->groups[group].first_pad));
+
+	return comm;
+}
+
+static void gpio_configure_pad(const struct pad_config *cfg)
+{
+	gpio_configure_pad_batched(cfg, NULL);
+	gpio_flush_batch();
+}
+
+static void gpio_report_time(size_t num_pads, struct stopwatch *sw)
+{
+	static size_t stage_pads;
+	static int64_t stage_usecs;
+	const int64_t usecs = stopwatch_duration_usecs(sw);
+
+	stage_pads += num_pads;
+	stage_usecs += usecs;
+	printk(BIOS_SPEW, "GPIO: Configured %zu pads in %lld us (%s total: %zu pads, %lld us)\n",
+	       num_pads, usecs, ENV_STRING, stage_pads, stage_usecs);
 }
 
 void gpio_configure_pads(const struct pad_config *cfg, size_t num_pads)
 {
+	const struct pad_community *comm = NULL;
+	struct stopwatch sw;
 	size_t i;
 
+	stopwatch_init(&sw);
+
 	for (i = 0; i < num_pads; i++)
-		gpio_configure_pad(cfg + i);
+		comm = gpio_configure_pad_batched(cfg + i, comm);
+	gpio_flush_batch();
+
+	gpio_report_time(num_pads, &sw);
 }
 
 /*
@@ -424,14 +487,21 @@ void gpio_configure_pads_with_override(const struct pad_config *base_cfg,
 					const struct pad_config *override_cfg,
 					size_t override_num_pads)
 {
+	const struct pad_community *comm = NULL;
+	struct stopwatch sw;
 	size_t i;
 	const struct pad_config *c;
 
+	stopwatch_init(&sw);
+
 	for (i = 0; i < base_num_pads; i++) {
 		c = gpio_get_config(base_cfg + i, override_cfg,
 				override_num_pads);
-		gpio_configure_pad(c);
+		comm = gpio_configure_pad_batched(c, comm);
 	}
+	gpio_flush_batch();
+
+	gpio_report_time(base_num_pads, &sw);
 }
 
 struct pad_config *new_padbased_table(void)
@@ -456,14 +526,23 @@ void gpio_padbased_override(struct pad_config *padbased_table,
 
 void gpio_configure_pads_with_padbased(struct pad_config *padbased_table)
 {
-	size_t i;
+	const struct pad_community *comm = NULL;
+	struct stopwatch sw;
+	size_t i, num_pads = 0;
 	const struct pad_config *cfg = padbased_table;
+
+	stopwatch_init(&sw);
+
 	for (i = 0; i < TOTAL_PADS; i++) {
 		/* Consider unmapped pin as default setting, skip */
 		if (cfg[i].pad == 0 && cfg[i].pad_config[0] == 0)
 			continue;
-		gpio_configure_pad(&cfg[i]);
+		comm = gpio_configure_pad_batched(&cfg[i], comm);
+		num_pads++;
 	}
+	gpio_flush_batch();
+
+	gpio_report_time(num_pads, &sw);
 }
 
 void *gpio_dwx_address(const gpio_t pad)
@@ -653,16 +732,11 @@ gpio_pad_config_lock_using_pcr(const struct gpio_lock_config *pad_info,
 	}
 }
 
-static int gpio_non_smm_lock_pad(const struct gpio_lock_config *pad_info)
+static int gpio_non_smm_lock(const struct gpio_lock_config *pad_info,
+			     const struct pad_community *comm, size_t group,
+			     const uint32_t bit_mask)
 {
-	const struct pad_community *comm = gpio_get_community(pad_info->pad);
 	uint16_t offset;
-	size_t rel_pad;
-
-	if (!pad_info) {
-		printk(BIOS_ERR, "%s: Error: pad_info is null!\n", __func__);
-		return -1;
-	}
 
 	if (cpu_soc_is_in_untrusted_mode()) {
 		printk(BIOS_ERR, "%s: Error: IA Untrusted Mode enabled, can't lock pad!\n",
@@ -670,7 +744,6 @@ static int gpio_non_smm_lock_pad(const struct gpio_lock_config *pad_info)
 		return -1;
 	}
 
-	rel_pad = relative_pad_in_comm(comm, pad_info->pad);
 	offset = comm->pad_cfg_lock_offset;
 	if (!offset) {
 		printk(BIOS_ERR, "%s: Error: offset not defined for pad %d!\n",
@@ -679,8 +752,7 @@ static int gpio_non_smm_lock_pad(const struct gpio_lock_config *pad_info)
 	}
 
 	/* PADCFGLOCK and PADCFGLOCKTX registers for each community are contiguous */
-	offset += gpio_group_index_scaled(comm, rel_pad, 2 * sizeof(uint32_t));
-	const uint32_t bit_mask = gpio_bitmask_within_group(comm, rel_pad);
+	offset += group * 2 * sizeof(uint32_t);
 
 	if (CONFIG(SOC_INTEL_COMMON_BLOCK_GPIO_LOCK_USING_PCR)) {
 		if (CONFIG(DEBUG_GPIO))
@@ -698,6 +770,69 @@ static int gpio_non_smm_lock_pad(const struct gpio_lock_config *pad_info)
 	return 0;
 }
 
+static int gpio_non_smm_lock_pad(const struct gpio_lock_config *pad_info)
+{
+	const struct pad_community *comm;
+	size_t rel_pad;
+
+	if (!pad_info) {
+		printk(BIOS_ERR, "%s: Error: pad_info is null!\n", __func__);
+		return -1;
+	}
+
+	comm = gpio_get_community(pad_info->pad);
+	rel_pad = relative_pad_in_comm(comm, pad_info->pad);
+
+	return gpio_non_smm_lock(pad_info, comm, gpio_group_index(comm, rel_pad),
+				 gpio_bitmask_within_group(comm, rel_pad));
+}
+
+/* Lock the pads of a group with one register access per lock register. */
+static void gpio_lock_group(const struct pad_community *comm, size_t group,
+			    uint32_t lock_config, uint32_t lock_tx)
+{
+	const gpio_t first_pad = comm->first_pad + comm->groups[group].first_pad;
+	struct gpio_lock_config pads[32];
+	size_t i, count = 0;
+
+	/* Skip locking GPIO PAD in early stages or in recovery mode */
+	if (ENV_ROMSTAGE_OR_BEFORE || vboot_recovery_mode_enabled())
+		return;
+
+	if (!ENV_SMM && !CONFIG(SOC_INTEL_COMMON_BLOCK_SMM_LOCK_GPIO_PADS)) {
+		struct gpio_lock_config pad_info = {
+			.pad = first_pad + __ffs(lock_config | lock_tx),
+		};
+
+		/* Both are set for most pads, so lock them with one call. */
+		if (lock_config == lock_tx) {
+			pad_info.lock_action = GPIO_LOCK_FULL;
+			gpio_non_smm_lock(&pad_info, comm, group, lock_config);
+			return;
+		}
+		if (lock_config) {
+			pad_info.lock_action = GPIO_LOCK_CONFIG;
+			gpio_non_smm_lock(&pad_info, comm, group, lock_config);
+		}
+		if (lock_tx) {
+			pad_info.lock_action = GPIO_LOCK_TX;
+			gpio_non_smm_lock(&pad_info, comm, group, lock_tx);
+		}
+		return;
+	}
+
+	for (i = 0; i < comm->groups[group].size && i < ARRAY_SIZE(pads); i++) {
+		if (!((lock_config | lock_tx) & BIT(i)))
+			continue;
+		pads[count].pad = first_pad + i;
+		pads[count].lock_action = (lock_config & BIT(i) ? GPIO_LOCK_CONFIG : 0) |
+					  (lock_tx & BIT(i) ? GPIO_LOCK_TX : 0);
+		count++;
+	}
+
+	gpio_lock_pads(pads, count);
+}
+
 int gpio_lock_pad(const gpio_t pad, enum gpio_lock_action lock_action)
 {
 	/* Skip locking GPIO PAD in early stages or in recovery mode */
@@ -170,14 +170,46 @@ typedef struct {
 	cpu_crashlog_buffer_info_t buffers[256];
 } __packed cpu_crashlog_discovery_table_t;
 
-typedef struct cl_node_t {
-	u32 size;
-	void *data;
-	struct cl_node_t *next;
-} cl_node_t;
-
-cl_node_t *malloc_cl_node(size_t len);
-void free_cl_node(cl_node_t *node);
+/*
+ * The collected crashlog records are stored back to back in CBMEM_ID_CRASHLOG, instead of
+ * allocating every record from the heap. Each one is a struct cl_record followed by its data.
+ */
+struct cl_record {
+	u32 size;	/* Size of data in bytes */
+	u32 data[];
+};
+
+struct cl_records {
+	u32 count;	/* Number of records */
+	u32 used;	/* Bytes of data[] used by the records */
+	u32 capacity;	/* Bytes available in data[] */
+	u8 data[];
+};
+
+static inline const struct cl_record *cl_first_record(const struct cl_records *records)
+{
+	return (const struct cl_record *)records->data;
+}
+
+static inline const struct cl_record *cl_next_record(const struct cl_record *rec)
+{
+	return (const struct cl_record *)&rec->data[rec->size / sizeof(u32)];
+}
+
+/*
+ * Reserve a record of len DWORDs after the last record and return its data, or NULL if
+ * there is no space left. The record is only added by cl_commit_record(), so a record that
+ * turns out to be invalid is simply not committed.
+ */
+u32 *cl_reserve_record(size_t len);
+void cl_commit_record(void);
+
+/*
+ * Return the crashlog records, or NULL if there is no crashlog. Collection is started in
+ * the background with COOP_MULTITASKING, in which case this waits for it to complete.
+ */
+const struct cl_records *cl_get_records(void);
+
 int cl_get_cpu_record_size(void);
 int cl_get_pmc_record_size(void);
 int cl_get_ioe_record_size(void);
@@ -192,8 +224,8 @@ bool pmc_crashlog_support(void);
 bool cl_cpu_data_present(void);
 bool cl_pmc_data_present(void);
 bool cl_ioe_data_present(void);
-void cl_get_cpu_sram_data(cl_node_t *head);
-void cl_get_pmc_sram_data(cl_node_t *head);
+void cl_get_cpu_sram_data(void);
+void cl_get_pmc_sram_data(void);
 void reset_discovery_buffers(void);
 void update_new_pmc_crashlog_size(u32 *pmc_crash_size);
 void update_new_cpu_crashlog_size(u32 *cpu_crash_size);
@@ -221,7 +253,7 @@ bool cl_copy_data_from_sram(u32 src_bar,
 			u32 *dest_addr,
 			u32 buffer_index,
 			bool pmc_sram);
-void collect_pmc_and_cpu_crashlog_from_srams(cl_node_t *head);
+void collect_pmc_and_cpu_crashlog_from_srams(void);
 static const EFI_GUID FW_ERR_SECTION_GUID = {
 	0x81212a96, 0x09ed, 0x4996,
 	{ 0x94, 0x71, 0x8d, 0x72, 0x9c, 0x8e, 0x69, 0xed }
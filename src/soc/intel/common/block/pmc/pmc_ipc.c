@@ -8,6 +8,7 @@
 #include <intelblocks/pmc_ipc.h>
 #include <soc/pci_devs.h>
 #include <stdint.h>
+#include <thread.h>
 #include <timer.h>
 
 /*
@@ -78,9 +79,16 @@ static int check_ipc_sts(void)
 	return PMC_IPC_TIMEOUT;
 }
 
+/* Serializes IPC commands from different threads, check_ipc_sts() may yield. */
+static struct thread_mutex pmc_ipc_mutex;
+
 enum cb_err pmc_send_ipc_cmd(uint32_t cmd, const struct pmc_ipc_buffer *wbuf,
 			     struct pmc_ipc_buffer *rbuf)
 {
+	enum cb_err ret = CB_SUCCESS;
+
+	thread_mutex_lock(&pmc_ipc_mutex);
+
 	for (int i = 0; i < PMC_IPC_BUF_COUNT; ++i)
 		write32(pmc_wbuf(i), wbuf->buf[i]);
 
@@ -88,13 +96,16 @@ enum cb_err pmc_send_ipc_cmd(uint32_t cmd, const struct pmc_ipc_buffer *wbuf,
 
 	if (check_ipc_sts()) {
 		printk(BIOS_ERR, "PMC IPC command 0x%x failed\n", cmd);
-		return CB_ERR;
+		ret = CB_ERR;
+		goto out;
 	}
 
 	for (int i = 0; i < PMC_IPC_BUF_COUNT; ++i)
 		rbuf->buf[i] = read32(pmc_rbuf(i));
 
-	return CB_SUCCESS;
+out:
+	thread_mutex_unlock(&pmc_ipc_mutex);
+	return ret;
 }
 
 void pmc_ipc_acpi_fill_ssdt(void)
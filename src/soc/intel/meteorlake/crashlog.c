@@ -71,12 +71,11 @@ static void configure_sram(const struct device *sram_dev, u32 base_addr)
 	pci_or_config16(sram_dev, PCI_COMMAND, PCI_COMMAND_MEMORY);
 }
 
-void cl_get_pmc_sram_data(cl_node_t *head)
+void cl_get_pmc_sram_data(void)
 {
 	u32 pmc_sram_base = cl_get_cpu_tmp_bar();
 	u32 ioe_sram_base = get_sram_bar(PCI_DEVFN_IOE_SRAM);
 	u32 pmc_crashLog_size = cl_get_pmc_record_size();
-	cl_node_t *cl_cur = head;
 
 	if (!pmc_crashLog_size) {
 		printk(BIOS_ERR, "No PMC crashlog records\n");
@@ -103,11 +102,6 @@ void cl_get_pmc_sram_data(cl_node_t *head)
 
 	printk(BIOS_DEBUG, "PMC crashLog size : 0x%x\n", pmc_crashLog_size);
 
-	/* goto tail node */
-	while (cl_cur && cl_cur->next) {
-		cl_cur = cl_cur->next;
-	}
-
 	/* process crashlog records */
 	for (int i = 0; i < descriptor_table.numb_regions + 1; i++) {
 
@@ -145,29 +139,24 @@ void cl_get_pmc_sram_data(cl_node_t *head)
 			else
 				continue;
 
-			cl_node_t *cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
+			u32 *record = cl_reserve_record(descriptor_table.regions[i].bits.size);
 
-			if (!cl_node) {
-				printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n", i);
+			if (!record)
 				goto pmc_send_re_arm_after_reset;
-			}
 
 			if (cl_copy_data_from_sram(sram_base,
 						descriptor_table.regions[i].bits.offset,
 						descriptor_table.regions[i].bits.size,
-						cl_node->data,
+						record,
 						i,
 						pmc_sram)) {
-				cl_cur->next = cl_node;
-				cl_cur = cl_cur->next;
+				cl_commit_record();
 			} else {
 				/* coping data from sram failed */
 				pmc_crashLog_size -= descriptor_table.regions[i].bits.size *
 									sizeof(u32);
 				printk(BIOS_DEBUG, "PMC crashlog size adjusted to: 0x%x\n",
 							pmc_crashLog_size);
-				/* free cl_node */
-				free_cl_node(cl_node);
 			}
 		}
 	}
@@ -18,6 +18,12 @@ enum proximity_domain_type {
 	PD_TYPE_GENERIC_INITIATOR,
 };
 
+/* Memory access performance of a proximity domain's memory */
+struct pd_perf {
+	uint32_t read_latency;		/* in picoseconds */
+	uint32_t read_bandwidth;	/* in MB/s */
+};
+
 /*
  * This proximity domain structure records all data related to
  * a proximity doamin needed for following purpose:
@@ -38,6 +44,14 @@ struct proximity_domain {
 	uint8_t socket_bitmap;
 	/* Relative distances (memory latency) from all domains */
 	uint8_t *distances;
+	/*
+	 * Access performance to this domain's memory. For processor domains,
+	 * `local` is seen from a thread on the same socket and `remote` from a
+	 * thread on another socket. For generic initiator domains, `local` is
+	 * seen from the attached socket and `remote` from any other socket.
+	 */
+	struct pd_perf local;
+	struct pd_perf remote;
 	/*
 	 * Below fields are set to 0 for processor domains.
 	 */
@@ -55,6 +69,11 @@ extern struct proximity_domains pds;
 
 void dump_pds(void);
 void fill_pds(void);
+/*
+ * Fill in the access performance of all proximity domains from the FSP CXL
+ * node data, where valid, or from typical values. Call after fill_pds().
+ */
+void fill_pds_perf(void);
 
 /*
  * Return the total size of memory regions in generic initiator affinity
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <commonlib/helpers.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci_ops.h>
@@ -8,6 +9,7 @@
 #include <soc/numa.h>
 #include <soc/soc_util.h>
 #include <soc/util.h>
+#include <stdlib.h>
 #include <types.h>
 
 void dump_pds(void)
@@ -83,6 +85,16 @@ void fill_pds(void)
 			pds.pds[i].socket_bitmap = node.SocketBitmap;
 			pds.pds[i].base = node.Address;
 			pds.pds[i].size = node.Size;
+			/*
+			 * FSP reports the latency in 0.1 ns and the bandwidth in 100 MB/s
+			 * units. The data is not valid on SPR-SP, leave it to the defaults.
+			 */
+			if (!CONFIG(SOC_INTEL_SAPPHIRERAPIDS_SP)) {
+				pds.pds[i].local.read_latency =
+					node.InitiatorTargetPerfData.RdLatency * 100;
+				pds.pds[i].local.read_bandwidth =
+					node.InitiatorTargetPerfData.RdBandwidth * 100;
+			}
 			dev = pcie_find_dsn(node.SerialNumber, node.VendorId, 0);
 			pds.pds[i].dev = dev;
 			pds.pds[i].distances = malloc(sizeof(uint8_t) * pds.num_pds);
@@ -99,6 +111,43 @@ void fill_pds(void)
 	}
 }
 
+/*
+ * Typical DDR5 and CXL Type 3 numbers. FSP does not report the performance of
+ * the processor attached memory and only on some SoCs the one of CXL memory.
+ */
+static const struct pd_perf ddr_local_default = { 110000, 25000 };
+static const struct pd_perf ddr_remote_default = { 180000, 15000 };
+static const struct pd_perf cxl_local_default = { 260000, 15000 };
+
+void fill_pds_perf(void)
+{
+	const struct pd_perf local = ddr_local_default;
+	const struct pd_perf remote = ddr_remote_default;
+	uint32_t extra_latency;
+
+	/* Going through the socket interconnect costs the same for any target */
+	extra_latency = remote.read_latency > local.read_latency ?
+			remote.read_latency - local.read_latency : 0;
+
+	for (uint8_t i = 0; i < pds.num_pds; i++) {
+		struct proximity_domain *pd = &pds.pds[i];
+
+		if (pd->pd_type == PD_TYPE_PROCESSOR) {
+			pd->local = local;
+			pd->remote = remote;
+			continue;
+		}
+
+		if (!pd->local.read_latency)
+			pd->local.read_latency = cxl_local_default.read_latency;
+		if (!pd->local.read_bandwidth)
+			pd->local.read_bandwidth = cxl_local_default.read_bandwidth;
+		pd->remote.read_latency = pd->local.read_latency + extra_latency;
+		pd->remote.read_bandwidth = MIN(pd->local.read_bandwidth,
+						remote.read_bandwidth);
+	}
+}
+
 /*
  * Return the total size of memory regions in generic initiator affinity domains.
  * The size is in unit of 64MB.
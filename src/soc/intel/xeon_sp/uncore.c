@@ -344,6 +344,7 @@ static void mmapvtd_read_resources(struct device *dev)
 		if (!once) {
 			/* Construct NUMA data structure. This is needed for CXL. */
 			fill_pds();
+			fill_pds_perf();
 			dump_pds();
 			once = true;
 		}
@@ -2,7 +2,9 @@
 
 #include <soc/acpi.h>
 #include <soc/numa.h>
+#include <soc/soc_util.h>
 #include <soc/util.h>
+#include <stdlib.h>
 
 unsigned long cxl_fill_srat(unsigned long current)
 {
@@ -33,9 +35,90 @@ unsigned long cxl_fill_srat(unsigned long current)
 	return current;
 }
 
+static bool pd_is_local(const struct proximity_domain *target, uint32_t initiator)
+{
+	return target->socket_bitmap & pds.pds[initiator].socket_bitmap;
+}
+
+/* Latency entries are in nanoseconds, bandwidth entries in MB/s */
+#define HMAT_LATENCY_BASE_UNIT		1000
+#define HMAT_BANDWIDTH_BASE_UNIT	1
+
+static uint16_t sllbi_value(const struct proximity_domain *target, uint32_t initiator,
+			    uint8_t data_type)
+{
+	const struct pd_perf *perf = pd_is_local(target, initiator) ?
+				     &target->local : &target->remote;
+	uint32_t value;
+
+	if (data_type == ACPI_HMAT_READ_LATENCY)
+		value = DIV_ROUND_UP(perf->read_latency, HMAT_LATENCY_BASE_UNIT);
+	else
+		value = perf->read_bandwidth / HMAT_BANDWIDTH_BASE_UNIT;
+
+	/* 0 means unreachable and 0xffff is reserved */
+	return MAX(MIN(value, 0xfffe), 1);
+}
+
+static unsigned long acpi_fill_hmat_sllbi(unsigned long current, uint8_t data_type)
+{
+	const uint32_t num_initiators = soc_get_num_cpus();
+	const uint32_t num_targets = pds.num_pds;
+	uint32_t *initiators = xmalloc(num_initiators * sizeof(uint32_t));
+	uint32_t *targets = xmalloc(num_targets * sizeof(uint32_t));
+	uint16_t *entries = xmalloc(num_initiators * num_targets * sizeof(uint16_t));
+
+	for (uint32_t i = 0; i < num_initiators; i++)
+		initiators[i] = i;
+
+	for (uint32_t t = 0; t < num_targets; t++) {
+		targets[t] = t;
+		for (uint32_t i = 0; i < num_initiators; i++)
+			entries[i * num_targets + t] = sllbi_value(&pds.pds[t], i, data_type);
+	}
+
+	current += acpi_create_hmat_sllbi((acpi_hmat_sllbi_t *)current,
+		ACPI_HMAT_SLLBI_MEMORY, data_type, num_initiators, initiators,
+		num_targets, targets,
+		data_type == ACPI_HMAT_READ_LATENCY ?
+		HMAT_LATENCY_BASE_UNIT : HMAT_BANDWIDTH_BASE_UNIT, entries);
+
+	free(entries);
+	free(targets);
+	free(initiators);
+
+	return current;
+}
+
 /*
- * The current kernel does not use HMAT table.
+ * In 2LM mode with HBM as cache, each socket's HBM is a direct mapped
+ * memory side cache in front of its DDR.
  */
+static unsigned long acpi_fill_hmat_msci(unsigned long current)
+{
+	const struct SystemMemoryMapHob *memory_map = get_system_memory_map();
+	const uint32_t num_sockets = soc_get_num_cpus();
+	const uint32_t attributes = ACPI_HMAT_CACHE_ATTRIBUTES(1, 1,
+		ACPI_HMAT_CACHE_ASSOC_DIRECT, ACPI_HMAT_CACHE_WRITE_BACK, 64);
+	uint64_t cache_size;
+
+	if (!memory_map || memory_map->volMemMode != 1 || memory_map->CacheMemType != 1 ||
+	    !memory_map->HbmCacheMemSize)
+		return current;
+
+	cache_size = ((uint64_t)memory_map->HbmCacheMemSize << MEM_ADDR_64MB_SHIFT_BITS) /
+		     num_sockets;
+
+	for (uint32_t i = 0; i < num_sockets; i++) {
+		printk(BIOS_DEBUG, "HMAT: memory side cache domain %u, size 0x%llx\n",
+		       i, cache_size);
+		current += acpi_create_hmat_msci((acpi_hmat_msci_t *)current, i,
+						 cache_size, attributes, 0, NULL);
+	}
+
+	return current;
+}
+
 unsigned long acpi_fill_hmat(unsigned long current)
 {
 	uint32_t pd_initiator = 0;
@@ -60,11 +143,9 @@ unsigned long acpi_fill_hmat(unsigned long current)
 						 pd_memory);
 	}
 
-	/*
-	 * We created only MPDA structure. In future, we could create
-	 * SLLBI structure to describe latency/bandwidth info when such info
-	 * is available.
-	 */
+	current = acpi_fill_hmat_sllbi(current, ACPI_HMAT_READ_LATENCY);
+	current = acpi_fill_hmat_sllbi(current, ACPI_HMAT_READ_BANDWIDTH);
+	current = acpi_fill_hmat_msci(current);
 
 	return current;
 }
@@ -5,6 +5,7 @@
 #include <delay.h>
 #include <device/mmio.h>
 #include <edid.h>
+#include <edid_cache.h>
 #include <soc/addressmap.h>
 #include <soc/dptx.h>
 #include <soc/dptx_hal.h>
@@ -214,19 +215,31 @@ static int dptx_get_edid(struct mtk_dp *mtk_dp, struct edid *out)
 	u8 edid[ONE_BLOCK_SIZE];
 	u8 tmp = 0;
 
+	_Static_assert(EDID_CACHE_ID_LENGTH == DP_AUX_MAX_PAYLOAD_BYTES,
+		       "EDID identity is read in one AUX transfer");
+
 	dptx_auxwrite_dpcd(mtk_dp, DP_AUX_I2C_WRITE, 0x50, 0x1, &tmp);
 
-	for (tmp = 0; tmp < ONE_BLOCK_SIZE / DP_AUX_MAX_PAYLOAD_BYTES; tmp++)
+	for (tmp = 0; tmp < ONE_BLOCK_SIZE / DP_AUX_MAX_PAYLOAD_BYTES; tmp++) {
 		dptx_auxread_dpcd(mtk_dp, DP_AUX_I2C_READ,
 				  0x50, DP_AUX_MAX_PAYLOAD_BYTES,
 				  edid + tmp * 16);
 
+		/* The first transfer has the panel identity, skip the rest if cached. */
+		if (tmp == 0 && edid_cache_lookup(0, edid, out) == 0) {
+			mtk_dp->edid = out;
+			return 0;
+		}
+	}
+
 	ret = decode_edid(edid, ONE_BLOCK_SIZE, out);
 	if (ret != EDID_CONFORMANT) {
 		printk(BIOS_ERR, "failed to decode edid(%d).\n", ret);
 		return -1;
 	}
 
+	edid_cache_update(0, edid, out);
+
 	mtk_dp->edid = out;
 	return 0;
 }
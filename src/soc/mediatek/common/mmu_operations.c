@@ -40,10 +40,14 @@ void mtk_mmu_init(void)
 
 void mtk_mmu_after_dram(void)
 {
+	mmu_config_batch_begin();
+
 	/* Map DRAM as cached now that it's up and running */
 	mmu_config_range(_dram, (uintptr_t)sdram_size(), NONSECURE_CACHED_MEM);
 
 	mtk_soc_after_dram();
+
+	mmu_config_batch_end();
 }
 
 void mtk_mmu_disable_l2c_sram(void)
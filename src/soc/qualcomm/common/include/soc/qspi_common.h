@@ -95,6 +95,7 @@ static struct qcom_qspi_regs * const qcom_qspi = (void *)QSPI_BASE;
 
 #define RESET_FIFO BIT(0)
 
+/* Maximum length of one DMA descriptor, longer transfers are chained */
 #define QSPI_MAX_PACKET_COUNT 0xFFC0
 
 void quadspi_init(uint32_t hz);
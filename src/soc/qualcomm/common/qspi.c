@@ -10,12 +10,23 @@
 #include <soc/clock.h>
 #include <symbols.h>
 #include <assert.h>
+#include <console/console.h>
 #include <gpio.h>
 #include <string.h>
+#include <timer.h>
 
 #define CACHE_LINE_SIZE	64
 
+/*
+ * Enough descriptors to read several MiB in one chain, filling the 8K
+ * DMA_COHERENT region. Only the unaligned head and tail of a transfer
+ * go through a bounce buffer, the rest is DMA'd directly.
+ */
+#define DMA_DESCRIPTORS		126
+#define DMA_BOUNCE_BUFFERS	2
+
 static int curr_desc_idx = -1;
+static int curr_buf_idx;
 
 struct cmd_desc {
 	uint32_t data_address;
@@ -57,8 +68,8 @@ enum bus_xfer_direction {
 };
 
 struct {
-	struct cmd_desc descriptors[3];
-	uint8_t buffers[3][CACHE_LINE_SIZE];
+	struct cmd_desc descriptors[DMA_DESCRIPTORS];
+	uint8_t buffers[DMA_BOUNCE_BUFFERS][CACHE_LINE_SIZE];
 } *dma = (void *)_dma_coherent;
 
 static void dma_transfer_chain(struct cmd_desc *chain)
@@ -81,6 +92,9 @@ static void flush_chain(void)
 	uint8_t *src;
 	uint8_t *dst;
 
+	if (curr_desc_idx == -1)
+		return;
+
 	dma_transfer_chain(desc);
 
 	while (desc) {
@@ -98,6 +112,7 @@ static void flush_chain(void)
 		desc = (void *)(uintptr_t)desc->next_descriptor;
 	}
 	curr_desc_idx = -1;
+	curr_buf_idx = 0;
 }
 
 static struct cmd_desc *allocate_descriptor(void)
@@ -106,14 +121,17 @@ static struct cmd_desc *allocate_descriptor(void)
 	struct cmd_desc *next;
 	uint8_t index;
 
+	/* Run what is queued when the pool is exhausted, CS stays asserted. */
+	if (curr_desc_idx == DMA_DESCRIPTORS - 1)
+		flush_chain();
+
 	current = (curr_desc_idx == -1) ?
 		NULL : &dma->descriptors[curr_desc_idx];
 
 	index = ++curr_desc_idx;
 	next = &dma->descriptors[index];
 
-	next->data_address = (uint32_t)(uintptr_t)dma->buffers[index];
-
+	next->data_address = 0;
 	next->next_descriptor = 0;
 	next->direction = MASTER_READ;
 	next->multi_io_mode = 0;
@@ -164,7 +182,9 @@ static void queue_bounce_data(uint8_t *data, uint32_t data_bytes,
 	desc = allocate_descriptor();
 	desc->direction = write;
 	desc->multi_io_mode = data_mode;
-	ptr = (void *)(uintptr_t)desc->data_address;
+	assert(curr_buf_idx < DMA_BOUNCE_BUFFERS);
+	ptr = dma->buffers[curr_buf_idx++];
+	desc->data_address = (uint32_t)(uintptr_t)ptr;
 
 	if (write) {
 		memcpy(ptr, data, data_bytes);
@@ -181,17 +201,25 @@ static void queue_direct_data(uint8_t *data, uint32_t data_bytes,
 			      enum qspi_mode data_mode, bool write)
 {
 	struct cmd_desc *desc;
-
-	desc = allocate_descriptor();
-	desc->direction = write;
-	desc->multi_io_mode = data_mode;
-	desc->data_address = (uint32_t)(uintptr_t)data;
-	desc->length = data_bytes;
+	uint32_t length;
 
 	if (write)
 		dcache_clean_by_mva(data, data_bytes);
 	else
 		dcache_invalidate_by_mva(data, data_bytes);
+
+	while (data_bytes) {
+		length = MIN(data_bytes, QSPI_MAX_PACKET_COUNT);
+
+		desc = allocate_descriptor();
+		desc->direction = write;
+		desc->multi_io_mode = data_mode;
+		desc->data_address = (uint32_t)(uintptr_t)data;
+		desc->length = length;
+
+		data += length;
+		data_bytes -= length;
+	}
 }
 
 static void queue_data(uint8_t *data, uint32_t data_bytes,
@@ -251,6 +279,7 @@ static void reg_init(void)
 void quadspi_init(uint32_t hz)
 {
 	assert(dcache_line_bytes() == CACHE_LINE_SIZE);
+	assert(sizeof(*dma) <= REGION_SIZE(dma_coherent));
 	clock_configure_qspi(hz * 4);
 	configure_gpios();
 	reg_init();
@@ -270,16 +299,24 @@ void qspi_release_bus(const struct spi_slave *slave)
 static int xfer(enum qspi_mode mode, const void *dout, size_t out_bytes,
 		void *din, size_t in_bytes)
 {
+	struct stopwatch sw;
+
 	if ((out_bytes && !dout) || (in_bytes && !din) ||
 		(in_bytes && out_bytes)) {
 		return -1;
 	}
 
+	stopwatch_init(&sw);
+
 	queue_data((uint8_t *)(out_bytes ? dout : din),
 		in_bytes | out_bytes, mode, !!out_bytes);
 
 	flush_chain();
 
+	if (CONFIG(DEBUG_SPI_FLASH) && in_bytes)
+		printk(BIOS_SPEW, "QSPI: read %zu bytes in %lld us\n", in_bytes,
+		       stopwatch_duration_usecs(&sw));
+
 	return 0;
 }
 
@@ -10,7 +10,7 @@ static const struct spi_ctrlr qspi_ctrlr = {
 	.release_bus = qspi_release_bus,
 	.xfer = qspi_xfer,
 	.xfer_dual = qspi_xfer_dual,
-	.max_xfer_size = QSPI_MAX_PACKET_COUNT,
+	.max_xfer_size = SPI_CTRLR_DEFAULT_MAX_XFER_SIZE,
 };
 
 const struct spi_ctrlr spi_qup_ctrlr = {
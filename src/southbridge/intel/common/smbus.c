@@ -392,6 +392,29 @@ int do_smbus_block_read(uintptr_t base, u8 device, u8 cmd, size_t max_bytes, u8
 	return ret;
 }
 
+int do_smbus_spd_read(uintptr_t base, u8 device, u8 offset, size_t bytes, u8 *buf)
+{
+	size_t i;
+	int ret;
+
+	if (!bytes || offset + bytes > 256)
+		return SMBUS_ERROR;
+
+	ret = do_i2c_eeprom_read(base, device, offset, bytes, buf);
+	if (ret == bytes)
+		return ret;
+
+	/* Stop at the first error, an empty slot would fail every byte. */
+	for (i = 0; i < bytes; i++) {
+		ret = do_smbus_read_byte(base, device, offset + i);
+		if (ret < 0)
+			return ret;
+		buf[i] = ret;
+	}
+
+	return bytes;
+}
+
 /*
  * The caller is responsible of settings HOSTC I2C_EN bit prior to making this
  * call!
@@ -0,0 +1,9 @@
+# SPDX-License-Identifier: GPL-2.0-only
+
+tests-y += xlat_table-test
+
+xlat_table-test-srcs += tests/arch/arm64/xlat_table-test.c
+xlat_table-test-srcs += tests/stubs/console.c
+xlat_table-test-srcs += tests/stubs/die.c
+xlat_table-test-srcs += src/arch/arm64/armv8/xlat_table.c
+xlat_table-test-cflags += -I src/arch/arm64/include/armv8
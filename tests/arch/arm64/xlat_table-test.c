@@ -0,0 +1,376 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/mmu.h>
+#include <commonlib/helpers.h>
+#include <string.h>
+#include <symbols.h>
+#include <tests/test.h>
+#include <types.h>
+
+#define XLAT_ENTRIES	(GRANULE_SIZE / sizeof(uint64_t))
+#define TTB_TABLES	1024
+#define TTB_SIZE	(TTB_TABLES * GRANULE_SIZE)
+
+/* Like TEST_REGION(), but tables have to be aligned to the granule size. */
+#define TTB_SYMBOL(symbol, value) TEST_SYMBOL(symbol, value)
+uint8_t _ttb[TTB_SIZE] __aligned(GRANULE_SIZE);
+TTB_SYMBOL(_ettb, _ttb + TTB_SIZE);
+
+/* The randomized test tracks the expected tag of every page in this window. */
+#define WINDOW_SIZE	(4ULL * GiB)
+#define WINDOW_PAGES	(WINDOW_SIZE / GRANULE_SIZE)
+#define TAG_UNMAPPED	0xff
+
+static uint8_t model[WINDOW_PAGES];
+
+static int tlb_invalidations;
+
+void xlat_tlb_invalidate(void)
+{
+	tlb_invalidations++;
+}
+
+static const uint64_t tags[] = {
+	MA_DEV | MA_S | MA_RW,
+	MA_MEM | MA_NS | MA_RW,
+	MA_MEM | MA_S | MA_RW | MA_MEM_NC,
+	MA_MEM | MA_S | MA_RO,
+};
+
+static int shift_of(int level)
+{
+	return L0_ADDR_SHIFT - level * BITS_RESOLVED_PER_LVL;
+}
+
+static uint64_t *table_of(uint64_t desc)
+{
+	return (uint64_t *)(uintptr_t)(desc & XLAT_ADDR_MASK);
+}
+
+/* Descriptor attributes as mandated by the MMU programming model. */
+static uint64_t ref_attr(uint64_t tag)
+{
+	uint64_t attr = BLOCK_ACCESS;
+
+	if (tag & MA_NS)
+		attr |= BLOCK_NS;
+	if (tag & MA_RO)
+		attr |= BLOCK_AP_RO;
+	if (!(tag & MA_MEM))
+		return attr | BLOCK_XN | (BLOCK_INDEX_MEM_DEV_NGNRNE << BLOCK_INDEX_SHIFT);
+	if (tag & MA_MEM_NC)
+		attr |= BLOCK_INDEX_MEM_NORMAL_NC << BLOCK_INDEX_SHIFT;
+	else
+		attr |= BLOCK_INDEX_MEM_NORMAL << BLOCK_INDEX_SHIFT;
+
+	return attr | BLOCK_SH_INNER_SHAREABLE;
+}
+
+/*
+ * Reference translation table walk for a 4K granule, 48-bit VA regime. Returns
+ * the level of the leaf descriptor or -1 if the address is not mapped.
+ */
+static int ref_walk(uint64_t va, uint64_t *pa, uint64_t *attr)
+{
+	uint64_t *table = (uint64_t *)_ttb;
+
+	for (int level = 0; level <= 3; level++) {
+		const uint64_t size = 1ULL << shift_of(level);
+		const uint64_t desc = table[(va >> shift_of(level)) % XLAT_ENTRIES];
+
+		if (!(desc & 1))
+			return -1;
+
+		if (level < 3 && (desc & DESC_MASK) == TABLE_DESC) {
+			assert_true(table_of(desc) >= (uint64_t *)_ttb);
+			assert_true(table_of(desc) < (uint64_t *)_ettb);
+			table = table_of(desc);
+			continue;
+		}
+
+		/* Block descriptors are not allowed at L0, page descriptors only at L3. */
+		assert_int_not_equal(level, 0);
+		assert_int_equal(desc & DESC_MASK, level == 3 ? PAGE_DESC : BLOCK_DESC);
+
+		*pa = (desc & XLAT_ADDR_MASK & ~(size - 1)) | (va & (size - 1));
+		*attr = desc & ~(XLAT_ADDR_MASK | BLOCK_CONTIGUOUS | DESC_MASK);
+		return level;
+	}
+
+	return -1;
+}
+
+static bool ref_is_leaf(uint64_t desc, int level)
+{
+	return level > 0 && (desc & DESC_MASK) == (level == 3 ? PAGE_DESC : BLOCK_DESC);
+}
+
+/* Whether count entries form one aligned, physically contiguous mapping. */
+static bool ref_uniform(const uint64_t *entry, size_t count, int level)
+{
+	const uint64_t size = 1ULL << shift_of(level);
+	const uint64_t mask = ~(XLAT_ADDR_MASK | BLOCK_CONTIGUOUS);
+
+	if (!ref_is_leaf(entry[0], level) || (entry[0] & XLAT_ADDR_MASK) % (count * size))
+		return false;
+
+	for (size_t i = 1; i < count; i++)
+		if ((entry[i] & mask) != (entry[0] & mask) ||
+		    (entry[i] & XLAT_ADDR_MASK) != (entry[0] & XLAT_ADDR_MASK) + i * size)
+			return false;
+
+	return true;
+}
+
+/*
+ * Check structural invariants: contiguous hints are set exactly on qualifying
+ * groups and no next level table could have been a block instead.
+ */
+static void check_table(const uint64_t *table, int level)
+{
+	if (level > 0) {
+		for (size_t i = 0; i < XLAT_ENTRIES; i += XLAT_CONTIG_ENTRIES) {
+			const bool contig = ref_uniform(&table[i], XLAT_CONTIG_ENTRIES, level);
+
+			for (size_t j = i; j < i + XLAT_CONTIG_ENTRIES; j++)
+				if (ref_is_leaf(table[j], level))
+					assert_int_equal(!!(table[j] & BLOCK_CONTIGUOUS), contig);
+		}
+	}
+
+	if (level == 3)
+		return;
+
+	for (size_t i = 0; i < XLAT_ENTRIES; i++) {
+		if ((table[i] & DESC_MASK) != TABLE_DESC)
+			continue;
+		if (level > 0)
+			assert_false(ref_uniform(table_of(table[i]), XLAT_ENTRIES, level + 1));
+		check_table(table_of(table[i]), level + 1);
+	}
+}
+
+static size_t used_tables(void)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < TTB_TABLES; i++)
+		if (((uint64_t *)_ttb)[i * XLAT_ENTRIES] != UNUSED_DESC)
+			count++;
+
+	return count;
+}
+
+static void check_mapping(uint64_t va, uint64_t tag, int expected_level)
+{
+	uint64_t pa, attr;
+	const int level = ref_walk(va, &pa, &attr);
+
+	assert_int_equal(level, expected_level);
+	assert_int_equal(pa, va);
+	assert_int_equal(attr, ref_attr(tag));
+}
+
+static int setup_xlat(void **state)
+{
+	memset(_ttb, 0xa5, TTB_SIZE);
+	xlat_init_tables();
+	tlb_invalidations = 0;
+	return 0;
+}
+
+static void test_xlat_largest_blocks(void **state)
+{
+	xlat_map_range(0, 4ULL * GiB, tags[0], false);
+	/* One L0 and one L1 table, everything else are 1G blocks */
+	assert_int_equal(used_tables(), 2);
+	check_mapping(0, tags[0], 1);
+	check_mapping(4ULL * GiB - 1, tags[0], 1);
+
+	/* 2M aligned range in the middle of a 1G block */
+	xlat_map_range(1ULL * GiB + 6 * MiB, 4 * MiB, tags[1], false);
+	assert_int_equal(used_tables(), 3);
+	check_mapping(1ULL * GiB + 4 * MiB, tags[0], 2);
+	check_mapping(1ULL * GiB + 6 * MiB, tags[1], 2);
+	check_mapping(1ULL * GiB + 10 * MiB, tags[0], 2);
+
+	/* Unaligned start needs pages up to the next 2M boundary */
+	xlat_map_range(3ULL * GiB - 8 * KiB, 2 * MiB + 8 * KiB, tags[1], false);
+	assert_int_equal(used_tables(), 6);
+	check_mapping(3ULL * GiB - 8 * KiB, tags[1], 3);
+	check_mapping(3ULL * GiB - 12 * KiB, tags[0], 3);
+	check_mapping(3ULL * GiB, tags[1], 2);
+
+	check_table((uint64_t *)_ttb, 0);
+}
+
+static void test_xlat_contiguous_hint(void **state)
+{
+	const uint64_t base = 2 * MiB;
+
+	xlat_map_range(base, 16 * 4 * KiB, tags[1], false);
+	xlat_map_range(base + 16 * 4 * KiB, 15 * 4 * KiB, tags[1], false);
+	assert_true(xlat_get_pte(base) & BLOCK_CONTIGUOUS);
+	assert_true(xlat_get_pte(base + 15 * 4 * KiB) & BLOCK_CONTIGUOUS);
+	assert_false(xlat_get_pte(base + 16 * 4 * KiB) & BLOCK_CONTIGUOUS);
+	check_table((uint64_t *)_ttb, 0);
+
+	/* Completing the second group sets its hint as well */
+	xlat_map_range(base + 31 * 4 * KiB, 4 * KiB, tags[1], false);
+	assert_true(xlat_get_pte(base + 16 * 4 * KiB) & BLOCK_CONTIGUOUS);
+
+	/* Changing a single page drops the hint of its group only */
+	xlat_map_range(base + 4 * KiB, 4 * KiB, tags[2], false);
+	assert_false(xlat_get_pte(base) & BLOCK_CONTIGUOUS);
+	assert_true(xlat_get_pte(base + 16 * 4 * KiB) & BLOCK_CONTIGUOUS);
+	check_table((uint64_t *)_ttb, 0);
+
+	/* 32M of 2M blocks carry the hint at L2 */
+	xlat_map_range(32 * MiB, 32 * MiB, tags[3], false);
+	assert_true(xlat_get_pte(32 * MiB) & BLOCK_CONTIGUOUS);
+	check_mapping(48 * MiB, tags[3], 2);
+	check_table((uint64_t *)_ttb, 0);
+}
+
+static void test_xlat_split_and_merge(void **state)
+{
+	xlat_map_range(0, 1ULL * GiB, tags[1], false);
+	assert_int_equal(used_tables(), 2);
+
+	xlat_map_range(1 * MiB, 4 * KiB, tags[0], false);
+	assert_int_equal(used_tables(), 4);
+	check_mapping(1 * MiB, tags[0], 3);
+	check_mapping(1 * MiB + 4 * KiB, tags[1], 3);
+	check_mapping(2 * MiB, tags[1], 2);
+
+	/* Restoring the page folds everything back into one 1G block */
+	xlat_map_range(1 * MiB, 4 * KiB, tags[1], false);
+	check_mapping(1 * MiB, tags[1], 1);
+	check_table((uint64_t *)_ttb, 0);
+
+	/* The unlinked tables only become free after the flush */
+	assert_int_equal(used_tables(), 4);
+	xlat_release_tables();
+	assert_int_equal(used_tables(), 2);
+
+	/* Remapping a range that is already mapped the same way is free */
+	xlat_map_range(64 * KiB, 64 * KiB, tags[1], false);
+	assert_int_equal(used_tables(), 2);
+	check_mapping(64 * KiB, tags[1], 1);
+}
+
+static void test_xlat_reused_tables(void **state)
+{
+	xlat_map_range(0, 1ULL * GiB, tags[0], false);
+
+	/* Splitting and merging the same block over and over must not leak tables */
+	for (int i = 0; i < 4 * TTB_TABLES; i++) {
+		const uint64_t page = (i % XLAT_ENTRIES) * 4 * KiB;
+
+		xlat_map_range(page, 4 * KiB, tags[1], false);
+		xlat_map_range(page, 4 * KiB, tags[0], false);
+		xlat_release_tables();
+	}
+	assert_int_equal(used_tables(), 2);
+	check_table((uint64_t *)_ttb, 0);
+}
+
+static void test_xlat_live_updates(void **state)
+{
+	const uint64_t base = 2 * MiB;
+
+	xlat_map_range(0, 1ULL * GiB, tags[1], false);
+	xlat_map_range(base, 16 * 4 * KiB, tags[0], false);
+	assert_true(xlat_get_pte(base) & BLOCK_CONTIGUOUS);
+	assert_int_equal(tlb_invalidations, 0);
+
+	/* Changing a page of a hinted group needs break-before-make of the group */
+	xlat_map_range(base + 4 * KiB, 4 * KiB, tags[2], true);
+	assert_int_equal(tlb_invalidations, 1);
+	check_mapping(base + 4 * KiB, tags[2], 3);
+	for (int i = 0; i < XLAT_CONTIG_ENTRIES; i++)
+		assert_false(xlat_get_pte(base + i * 4 * KiB) & BLOCK_CONTIGUOUS);
+	check_mapping(base, tags[0], 3);
+	check_mapping(base + 8 * KiB, tags[0], 3);
+
+	/* Splitting a hinted 2M block breaks its L2 group, the new table gets no hints */
+	xlat_map_range(64 * MiB, 4 * KiB, tags[0], true);
+	assert_int_equal(tlb_invalidations, 2);
+	assert_false(xlat_get_pte(64 * MiB + 4 * KiB) & BLOCK_CONTIGUOUS);
+	assert_false(xlat_get_pte(66 * MiB) & BLOCK_CONTIGUOUS);
+	check_mapping(64 * MiB + 4 * KiB, tags[1], 3);
+
+	/* Nothing is folded back while the MMU is on */
+	const size_t tables = used_tables();
+	xlat_map_range(64 * MiB, 4 * KiB, tags[1], true);
+	check_mapping(64 * MiB, tags[1], 3);
+	assert_int_equal(used_tables(), tables);
+
+	/* Once the MMU is off again, it is */
+	xlat_map_range(64 * MiB, 4 * KiB, tags[1], false);
+	xlat_release_tables();
+	check_mapping(64 * MiB, tags[1], 2);
+	assert_int_equal(used_tables(), tables - 1);
+}
+
+static uint32_t lcg_state;
+
+static uint32_t lcg_next(void)
+{
+	lcg_state = lcg_state * 1103515245 + 12345;
+	return lcg_state >> 8;
+}
+
+static void test_xlat_random_against_reference(void **state)
+{
+	memset(model, TAG_UNMAPPED, sizeof(model));
+	lcg_state = 0xc0ffee;
+
+	for (int op = 0; op < 200; op++) {
+		/* Mix large aligned ranges with small unaligned ones */
+		const uint64_t align = op % 3 ? 4 * KiB : 2 * MiB;
+		const uint64_t max_pages = op % 5 ? 1024 : WINDOW_PAGES / 4;
+		const uint64_t pages = lcg_next() % max_pages + 1;
+		const uint64_t start_page = lcg_next() % (WINDOW_PAGES - pages);
+		const uint64_t start = ALIGN_DOWN(start_page * GRANULE_SIZE, align);
+		const uint64_t size = pages * GRANULE_SIZE;
+		const uint8_t tag = lcg_next() % ARRAY_SIZE(tags);
+
+		xlat_map_range(start, size, tags[tag], false);
+		xlat_release_tables();
+		memset(&model[start / GRANULE_SIZE], tag, pages);
+	}
+
+	for (uint64_t page = 0; page < WINDOW_PAGES; page++) {
+		const uint64_t va = page * GRANULE_SIZE;
+		uint64_t pa, attr;
+
+		if (model[page] == TAG_UNMAPPED) {
+			assert_int_equal(ref_walk(va, &pa, &attr), -1);
+			continue;
+		}
+
+		assert_int_not_equal(ref_walk(va, &pa, &attr), -1);
+		assert_int_equal(pa, va);
+		assert_int_equal(attr, ref_attr(tags[model[page]]));
+		/* The builder's own walk has to agree with the reference */
+		assert_int_equal(xlat_get_pte(va) & ~(XLAT_ADDR_MASK | BLOCK_CONTIGUOUS |
+			DESC_MASK), attr);
+	}
+
+	check_table((uint64_t *)_ttb, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_xlat_largest_blocks, setup_xlat),
+		cmocka_unit_test_setup(test_xlat_contiguous_hint, setup_xlat),
+		cmocka_unit_test_setup(test_xlat_split_and_merge, setup_xlat),
+		cmocka_unit_test_setup(test_xlat_reused_tables, setup_xlat),
+		cmocka_unit_test_setup(test_xlat_live_updates, setup_xlat),
+		cmocka_unit_test_setup(test_xlat_random_against_reference, setup_xlat),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
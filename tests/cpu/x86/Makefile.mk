@@ -0,0 +1,14 @@
+# SPDX-License-Identifier: GPL-2.0-only
+
+tests-y += mtrr-test
+
+mtrr-test-srcs += tests/cpu/x86/mtrr-test.c
+mtrr-test-srcs += tests/stubs/console.c
+mtrr-test-srcs += src/lib/memrange.c
+mtrr-test-srcs += src/lib/xxhash.c
+mtrr-test-srcs += src/device/device_util.c
+mtrr-test-srcs += tests/stubs/die.c
+# mtrr.c contains inline assembly for x86_64 hosts only
+mtrr-test-cflags += -D__ARCH_x86_64__
+# The test provides its own main(), keep bootstate.h from declaring the stage entry
+mtrr-test-cflags += -D_MAIN_DECL_H_
@@ -0,0 +1,335 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include "../cpu/x86/mtrr/mtrr.c"
+
+#include <tests/test.h>
+
+/* Memory map entry, any gap up to 4GiB is filled with UC by the code under test. */
+struct map_entry {
+	uint64_t base;
+	uint64_t size;
+	int type;
+};
+
+struct memory_map {
+	const char *name;
+	int address_bits;
+	int num_mtrrs;
+	int above4gb;
+	struct map_entry entries[16];
+};
+
+#define WB MTRR_TYPE_WRBACK
+#define UC MTRR_TYPE_UNCACHEABLE
+#define WC MTRR_TYPE_WRCOMB
+
+/* Memory maps as seen on real boards, reduced to what matters for the MTRRs. */
+static const struct memory_map corpus[] = {
+	{
+		.name = "Intel client, 8GiB, IGD stolen memory",
+		.address_bits = 39, .num_mtrrs = 10, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0xc0000, 0x76f00000 - 0xc0000, WB },
+			{ 0x76f00000, 0x9100000, UC },
+			{ 0x80000000, 0x10000000, WC },
+			{ 0x100000000, 0x189100000 - 0x100000000, WB },
+		},
+	},
+	{
+		.name = "AMD client, 4GiB, odd TOM",
+		.address_bits = 48, .num_mtrrs = 8, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0xcd800000 - 0x100000, WB },
+			{ 0xe0000000, 0x10000000, WC },
+			{ 0x100000000, 0x12f340000 - 0x100000000, WB },
+		},
+	},
+	{
+		.name = "Intel client, 16GiB, unaligned TSEG, no above 4GiB",
+		.address_bits = 39, .num_mtrrs = 10, .above4gb = 0,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0x7b800000 - 0x100000, WB },
+			{ 0xc0000000, 0x10000000, WC },
+			{ 0x100000000, 0x47f800000 - 0x100000000, WB },
+		},
+	},
+	{
+		.name = "Two socket server, 512GiB, high MMIO per socket",
+		.address_bits = 46, .num_mtrrs = 10, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0x6f800000 - 0x100000, WB },
+			{ 0x100000000, 0x4000000000, WB },
+			{ 0x4100000000, 0x4000000000, WB },
+			{ 0x200000000000, 0x4000000000, UC },
+			{ 0x204000000000, 0x4000000000, UC },
+		},
+	},
+	{
+		.name = "Four socket server, 64-bit PCI holes between sockets",
+		.address_bits = 46, .num_mtrrs = 10, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0x5f000000 - 0x100000, WB },
+			{ 0x90000000, 0x10000000, WC },
+			{ 0x100000000, 0xf80000000, WB },
+			{ 0x1080000000, 0x80000000, UC },
+			{ 0x1100000000, 0x1000000000, WB },
+			{ 0x2100000000, 0x80000000, UC },
+			{ 0x2180000000, 0xf80000000, WB },
+			{ 0x3100000000, 0x80000000, UC },
+			{ 0x3180000000, 0x1000000000, WB },
+		},
+	},
+	{
+		.name = "One socket server, 64GiB, 2GiB TOLUD",
+		.address_bits = 46, .num_mtrrs = 10, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0x7ff00000, WB },
+			{ 0x100000000, 0xf00000000, WB },
+			{ 0x1000000000, 0x1c0000000, UC },
+			{ 0x200000000000, 0x4000000000, UC },
+		},
+	},
+	{
+		.name = "Two socket server, 2.5GiB TOLUD, WC framebuffer, 8 MTRRs",
+		.address_bits = 46, .num_mtrrs = 8, .above4gb = 1,
+		.entries = {
+			{ 0, 0xa0000, WB },
+			{ 0x100000, 0x9ff00000, WB },
+			{ 0xe0000000, 0x10000000, WC },
+			{ 0x100000000, 0x11a0000000, WB },
+			{ 0x12a0000000, 0x40000000, UC },
+			{ 0x12e0000000, 0x1200000000, WB },
+			{ 0x24e0000000, 0x100000000, UC },
+		},
+	},
+};
+
+static struct memranges test_addr_space;
+
+static void load_map(const struct memory_map *map)
+{
+	memranges_init_empty(&test_addr_space, NULL, 0);
+	for (size_t i = 0; i < ARRAY_SIZE(map->entries) && map->entries[i].size; i++)
+		memranges_insert(&test_addr_space, map->entries[i].base,
+				 map->entries[i].size, map->entries[i].type);
+	memranges_fill_holes_up_to(&test_addr_space, 4ULL * GiB, UC);
+	total_mtrrs = map->num_mtrrs;
+}
+
+static int combine_type(int a, int b)
+{
+	if (a < 0 || a == b)
+		return b;
+	if (a == UC || b == UC)
+		return UC;
+	if ((a == WB && b == MTRR_TYPE_WRTHROUGH) || (a == MTRR_TYPE_WRTHROUGH && b == WB))
+		return MTRR_TYPE_WRTHROUGH;
+	fail_msg("Undefined MTRR overlap of types %d and %d", a, b);
+	return -1;
+}
+
+/* Memory type resolution as described in the SDM. */
+static int effective_type(const struct var_mtrr_solution *sol, uint64_t addr)
+{
+	int type = -1;
+
+	for (int i = 0; i < sol->num_used; i++) {
+		const uint64_t base = ((uint64_t)sol->regs[i].base.hi << 32) |
+				      sol->regs[i].base.lo;
+		const uint64_t mask = ((uint64_t)sol->regs[i].mask.hi << 32) |
+				      sol->regs[i].mask.lo;
+
+		assert_true(mask & MTRR_PHYS_MASK_VALID);
+		if ((addr & mask & ~0xfffULL) == (base & mask & ~0xfffULL))
+			type = combine_type(type, base & 0xff);
+	}
+
+	return type < 0 ? sol->mtrr_default_type : type;
+}
+
+static void check_point(const struct var_mtrr_solution *sol, uint64_t addr, int type)
+{
+	if (addr < 1 * MiB)
+		return;
+	if (effective_type(sol, addr) != type)
+		fail_msg("Address 0x%llx has type %d instead of %d", addr,
+			 effective_type(sol, addr), type);
+}
+
+static void check_range(const struct var_mtrr_solution *sol, uint64_t base, uint64_t end,
+			int type)
+{
+	check_point(sol, base, type);
+	check_point(sol, ALIGN_DOWN(base + (end - base) / 2, 4 * KiB), type);
+	check_point(sol, end - 4 * KiB, type);
+}
+
+/* Check that every range and gap ends up with the intended type. */
+static void check_solution(const struct memory_map *map, const struct var_mtrr_solution *sol)
+{
+	const struct range_entry *r;
+	uint64_t cursor = 0;
+
+	memranges_each_entry(r, &test_addr_space) {
+		uint64_t end = range_entry_end(r);
+
+		if (!map->above4gb) {
+			if (range_entry_base(r) >= 4ULL * GiB)
+				break;
+			end = MIN(end, 4ULL * GiB);
+		}
+
+		if (range_entry_base(r) > cursor)
+			check_range(sol, cursor, range_entry_base(r), sol->mtrr_default_type);
+		check_range(sol, range_entry_base(r), end, range_entry_tag(r));
+		cursor = range_entry_end(r);
+	}
+}
+
+static int greedy_count(const struct memory_map *map)
+{
+	int wb_count, uc_count;
+
+	__calc_var_mtrrs(&test_addr_space, map->above4gb, map->address_bits,
+			 &wb_count, &uc_count);
+
+	return MIN(wb_count, uc_count);
+}
+
+static void test_solver_corpus(void **state)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+		const struct memory_map *map = &corpus[i];
+		struct var_mtrr_solution sol = { 0 };
+		int greedy, exact;
+
+		load_map(map);
+		greedy = greedy_count(map);
+
+		/* Allow the full storage so that the solution is always emitted. */
+		total_mtrrs = NUM_MTRR_STATIC_STORAGE;
+		exact = solve_var_mtrrs(&test_addr_space, map->above4gb, map->address_bits,
+					&sol);
+
+		print_message("%s: greedy %d, exact %d MTRRs\n", map->name, greedy, exact);
+		assert_in_range(exact, 0, greedy);
+		assert_int_equal(exact, sol.num_used);
+		check_solution(map, &sol);
+		assert_true(check_var_mtrr_solution(&test_addr_space, map->above4gb,
+						    map->address_bits, &sol));
+
+		memranges_teardown(&test_addr_space);
+	}
+}
+
+/* The greedy code needs more MTRRs than available here, the solver does not. */
+static void test_solver_avoids_dropping_wc(void **state)
+{
+	const struct memory_map *map = &corpus[6];
+	struct var_mtrr_solution sol = { 0 };
+	const struct range_entry *r;
+
+	load_map(map);
+	assert_true(greedy_count(map) > map->num_mtrrs);
+
+	calc_var_mtrr_solution(&test_addr_space, map->above4gb, map->address_bits, &sol);
+	assert_in_range(sol.num_used, 0, map->num_mtrrs);
+	check_solution(map, &sol);
+
+	memranges_each_entry(r, &test_addr_space)
+		if (range_entry_base(r) == 0xe0000000)
+			assert_int_equal(range_entry_tag(r), WC);
+
+	memranges_teardown(&test_addr_space);
+}
+
+static struct var_mtrr_cache cbmem_cache;
+static bool cbmem_cache_added;
+
+void *cbmem_find(u32 id)
+{
+	assert_int_equal(id, CBMEM_ID_MTRR_SOLUTION);
+	return cbmem_cache_added ? &cbmem_cache : NULL;
+}
+
+void *cbmem_add(u32 id, u64 size)
+{
+	assert_int_equal(id, CBMEM_ID_MTRR_SOLUTION);
+	assert_int_equal(size, sizeof(cbmem_cache));
+	cbmem_cache_added = true;
+	return &cbmem_cache;
+}
+
+static void test_solution_cache(void **state)
+{
+	const struct memory_map *map = &corpus[0];
+	struct var_mtrr_solution sol = { 0 };
+	struct var_mtrr_solution cached = { 0 };
+
+	load_map(map);
+	cbmem_cache_added = false;
+
+	get_var_mtrr_solution(&test_addr_space, map->above4gb, map->address_bits, &sol);
+	assert_true(cbmem_cache_added);
+	assert_memory_equal(&cbmem_cache.sol, &sol, sizeof(sol));
+
+	/*
+	 * Same address space, as on S3 resume: the cached solution is used. A
+	 * redundant copy of the first MTRR keeps it valid but tells it apart.
+	 */
+	cbmem_cache.sol.regs[sol.num_used] = sol.regs[0];
+	cbmem_cache.sol.num_used++;
+	get_var_mtrr_solution(&test_addr_space, map->above4gb, map->address_bits, &cached);
+	assert_memory_equal(&cached, &cbmem_cache.sol, sizeof(cached));
+
+	/* A cached solution that doesn't fit the address space is solved again. */
+	cbmem_cache.sol.num_used = 1;
+	get_var_mtrr_solution(&test_addr_space, map->above4gb, map->address_bits, &cached);
+	assert_int_equal(cached.num_used, sol.num_used);
+	assert_int_equal(cached.mtrr_default_type, sol.mtrr_default_type);
+	assert_memory_equal(cached.regs, sol.regs, sol.num_used * sizeof(sol.regs[0]));
+
+	/* A changed address space is solved again. */
+	cbmem_cache.sol.num_used = 1;
+	memranges_insert(&test_addr_space, 0x90000000, 0x1000000, WC);
+	get_var_mtrr_solution(&test_addr_space, map->above4gb, map->address_bits, &sol);
+	assert_int_not_equal(sol.num_used, 1);
+	assert_memory_equal(&cbmem_cache.sol, &sol, sizeof(sol));
+
+	memranges_teardown(&test_addr_space);
+}
+
+/* Device tree and resource list needed to link memrange.c */
+struct device *all_devices;
+struct resource *free_resources;
+
+/* Only used on the MSR programming paths, which are not tested here. */
+unsigned int cpu_phys_address_size(void)
+{
+	return 39;
+}
+
+void enable_lapic(void)
+{
+}
+
+void post_code(u8 value)
+{
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_solver_corpus),
+		cmocka_unit_test(test_solver_avoids_dropping_wc),
+		cmocka_unit_test(test_solution_cache),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -189,12 +189,74 @@ static void efi_test_new_write(void **state)
 	assert_string_equal((const char *)buf, "is awesome");
 }
 
+struct walk_result {
+	int count;
+	char name[EFI_FV_NAME_MAX];
+	char data[16];
+	uint32_t size;
+};
+
+static enum cb_err record_option(struct region_device *rdev, const char *opt_name,
+				 size_t data_offset, uint32_t data_size, void *arg)
+{
+	struct walk_result *res = arg;
+
+	assert_non_null(opt_name);
+	assert_true(data_size <= sizeof(res->data));
+
+	res->count++;
+	strcpy(res->name, opt_name);
+	res->size = data_size;
+	assert_int_equal(rdev_readat(rdev, res->data, data_offset, data_size), data_size);
+
+	return CB_SUCCESS;
+}
+
+static void efi_test_walk_options(void **state)
+{
+	static const EFI_GUID OtherGuid = {
+		0x12345678, 0x1234, 0x5678, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 } };
+	struct walk_result res;
+	enum cb_err ret;
+
+	mock_rdev(true);
+
+	memset(&res, 0, sizeof(res));
+	ret = efi_fv_walk_options(&flash_rdev_rw, &EficorebootNvDataGuid, record_option, &res);
+	assert_int_equal(ret, CB_SUCCESS);
+	assert_int_equal(res.count, 1);
+	assert_string_equal(res.name, name);
+	assert_int_equal(res.size, strlen("is great") + 1);
+	assert_string_equal(res.data, "is great");
+
+	/* Variables of other vendors are skipped */
+	mock_rdev(false);
+	memset(&res, 0, sizeof(res));
+	ret = efi_fv_walk_options(&flash_rdev_rw, &OtherGuid, record_option, &res);
+	assert_int_equal(ret, CB_SUCCESS);
+	assert_int_equal(res.count, 0);
+
+	/* Only the updated variable is left after a write */
+	mock_rdev(false);
+	ret = efi_fv_set_option(&flash_rdev_rw, &EficorebootNvDataGuid,
+				name, "is awesome", strlen("is awesome") + 1);
+	assert_int_equal(ret, CB_SUCCESS);
+
+	mock_rdev(false);
+	memset(&res, 0, sizeof(res));
+	ret = efi_fv_walk_options(&flash_rdev_rw, &EficorebootNvDataGuid, record_option, &res);
+	assert_int_equal(ret, CB_SUCCESS);
+	assert_int_equal(res.count, 1);
+	assert_string_equal(res.data, "is awesome");
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(efi_test_header),
 		cmocka_unit_test(efi_test_noop_existing_write),
-		cmocka_unit_test(efi_test_new_write)
+		cmocka_unit_test(efi_test_new_write),
+		cmocka_unit_test(efi_test_walk_options),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
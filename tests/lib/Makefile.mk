@@ -7,6 +7,7 @@ tests-y += hexstrtobin-test
 tests-y += imd-test
 tests-y += timestamp-test
 tests-y += edid-test
+tests-y += edid_cache-test
 tests-y += cbmem_console-romstage-test
 tests-y += cbmem_console-ramstage-test
 tests-y += fmap-test
@@ -65,6 +66,13 @@ edid-test-srcs += tests/lib/edid-test.c
 edid-test-srcs += src/lib/edid.c
 edid-test-srcs += tests/stubs/console.c
 
+edid_cache-test-srcs += tests/lib/edid_cache-test.c
+edid_cache-test-srcs += tests/stubs/console.c
+edid_cache-test-srcs += src/lib/crc_byte.c
+edid_cache-test-srcs += src/commonlib/region.c
+edid_cache-test-config += CONFIG_EDID_CACHE_IN_FMAP=1 \
+			  CONFIG_EDID_CACHE_FMAP_NAME=\"RW_EDID_CACHE\"
+
 cbmem_console-romstage-test-stage := romstage
 cbmem_console-romstage-test-srcs += tests/lib/cbmem_console-test.c
 cbmem_console-romstage-test-srcs += tests/stubs/console.c
@@ -115,6 +115,47 @@ void test_cbmemc_tx_byte_overflow(void **state)
 	free(check_buffer);
 }
 
+void test_cbmemc_tx_bytes(void **state)
+{
+	u32 cursor;
+	const unsigned char data[] =
+		"Random testing string\n"
+		"`1234567890-=~!@#$%^&*()_+\n";
+
+	cbmemc_tx_bytes(data, 10);
+	cbmemc_tx_bytes(&data[10], ARRAY_SIZE(data) - 10);
+
+	cursor = current_console->cursor & CURSOR_MASK;
+
+	assert_int_equal(ARRAY_SIZE(data), cursor);
+	assert_memory_equal(data, current_console->body, ARRAY_SIZE(data));
+}
+
+void test_cbmemc_tx_bytes_overflow(void **state)
+{
+	u32 cursor;
+	u32 flags;
+	const uint32_t console_size = current_console->size;
+	const uint32_t data_size = console_size + 100;
+	unsigned char *data = malloc(data_size);
+
+	for (int i = 0; i < data_size; ++i)
+		data[i] = 'a' + i % 26;
+
+	/* Span that wraps around the end of the buffer */
+	cbmemc_tx_bytes(data, data_size);
+
+	cursor = current_console->cursor & CURSOR_MASK;
+	flags = current_console->cursor & ~CURSOR_MASK;
+
+	assert_int_equal(OVERFLOW, flags & OVERFLOW);
+	assert_int_equal(100, cursor);
+	assert_memory_equal(current_console->body, &data[console_size], 100);
+	assert_memory_equal(&current_console->body[100], &data[100], console_size - 100);
+
+	free(data);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -123,6 +164,10 @@ int main(void)
 						teardown_cbmemc),
 		cmocka_unit_test_setup_teardown(test_cbmemc_tx_byte_overflow, setup_cbmemc,
 						teardown_cbmemc),
+		cmocka_unit_test_setup_teardown(test_cbmemc_tx_bytes, setup_cbmemc,
+						teardown_cbmemc),
+		cmocka_unit_test_setup_teardown(test_cbmemc_tx_bytes_overflow, setup_cbmemc,
+						teardown_cbmemc),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
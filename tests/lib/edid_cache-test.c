@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include "../lib/edid_cache.c"
+
+#include <stdlib.h>
+#include <tests/test.h>
+
+#define FLASH_SIZE	(4 * KiB)
+
+static struct region_device flash_rdev_rw;
+static uint8_t flash_buffer[FLASH_SIZE];
+
+int fmap_locate_area_as_rdev(const char *name, struct region_device *area)
+{
+	assert_string_equal(name, EDID_CACHE_FMAP_NAME);
+	return rdev_chain(area, &flash_rdev_rw, 0, FLASH_SIZE);
+}
+
+int fmap_locate_area_as_rdev_rw(const char *name, struct region_device *area)
+{
+	assert_string_equal(name, EDID_CACHE_FMAP_NAME);
+	return rdev_chain(area, &flash_rdev_rw, 0, FLASH_SIZE);
+}
+
+/* Start a new boot, which forgets everything but the flash contents. */
+static void reboot(void)
+{
+	memset(&cache, 0, sizeof(cache));
+	cache_state = CACHE_UNREAD;
+}
+
+static int setup_edid_cache(void **state)
+{
+	memset(flash_buffer, 0xff, sizeof(flash_buffer));
+	rdev_chain_mem_rw(&flash_rdev_rw, flash_buffer, sizeof(flash_buffer));
+	reboot();
+	return 0;
+}
+
+static void make_panel(uint8_t *id, struct edid *edid, uint8_t serial)
+{
+	static const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00,
+					  0x09, 0xe5, 0x8a, 0x07, 0x00, 0x00, 0x00, 0x00 };
+
+	memcpy(id, header, EDID_CACHE_ID_LENGTH);
+	id[12] = serial;
+
+	memset(edid, 0, sizeof(*edid));
+	edid->mode.name = "1920x1080@60Hz";
+	edid->mode.pixel_clock = 138700 + serial;
+	edid->mode.ha = 1920;
+	edid->mode.va = 1080;
+	edid->panel_bits_per_color = 8;
+	strcpy(edid->manufacturer_name, "BOE");
+	strcpy(edid->ascii_string, "NV140FHM-N49");
+}
+
+static void test_edid_cache_empty_flash(void **state)
+{
+	uint8_t id[EDID_CACHE_ID_LENGTH];
+	struct edid edid, out;
+
+	make_panel(id, &edid, 1);
+	assert_int_equal(-1, edid_cache_lookup(0, id, &out));
+
+	/* Nothing to write without an update. */
+	write_edid_cache(NULL);
+	for (size_t i = 0; i < sizeof(flash_buffer); i++)
+		assert_int_equal(0xff, flash_buffer[i]);
+}
+
+static void test_edid_cache_hit_after_reboot(void **state)
+{
+	uint8_t id[EDID_CACHE_ID_LENGTH];
+	struct edid edid, out;
+
+	make_panel(id, &edid, 1);
+	assert_int_equal(-1, edid_cache_lookup(0x2c08, id, &out));
+	edid_cache_update(0x2c08, id, &edid);
+	write_edid_cache(NULL);
+
+	reboot();
+	memset(&out, 0xaa, sizeof(out));
+	assert_int_equal(0, edid_cache_lookup(0x2c08, id, &out));
+	assert_null(out.mode.name);
+	assert_int_equal(edid.mode.pixel_clock, out.mode.pixel_clock);
+	assert_int_equal(edid.mode.ha, out.mode.ha);
+	assert_int_equal(edid.mode.va, out.mode.va);
+	assert_string_equal(edid.ascii_string, out.ascii_string);
+
+	/* Same panel on another connector is not a hit. */
+	assert_int_equal(-1, edid_cache_lookup(0x2c09, id, &out));
+}
+
+static void test_edid_cache_panel_swapped(void **state)
+{
+	uint8_t id[EDID_CACHE_ID_LENGTH], new_id[EDID_CACHE_ID_LENGTH];
+	struct edid edid, new_edid, out;
+
+	make_panel(id, &edid, 1);
+	edid_cache_update(0, id, &edid);
+	write_edid_cache(NULL);
+
+	reboot();
+	make_panel(new_id, &new_edid, 2);
+	assert_int_equal(-1, edid_cache_lookup(0, new_id, &out));
+	edid_cache_update(0, new_id, &new_edid);
+	write_edid_cache(NULL);
+
+	reboot();
+	assert_int_equal(-1, edid_cache_lookup(0, id, &out));
+	assert_int_equal(0, edid_cache_lookup(0, new_id, &out));
+	assert_int_equal(new_edid.mode.pixel_clock, out.mode.pixel_clock);
+}
+
+static void test_edid_cache_multiple_connectors(void **state)
+{
+	uint8_t id[EDID_CACHE_SLOTS + 1][EDID_CACHE_ID_LENGTH];
+	struct edid edid[EDID_CACHE_SLOTS + 1], out;
+
+	for (int i = 0; i < EDID_CACHE_SLOTS; i++) {
+		make_panel(id[i], &edid[i], i);
+		edid_cache_update(i, id[i], &edid[i]);
+	}
+	write_edid_cache(NULL);
+
+	reboot();
+	for (int i = 0; i < EDID_CACHE_SLOTS; i++) {
+		assert_int_equal(0, edid_cache_lookup(i, id[i], &out));
+		assert_int_equal(edid[i].mode.pixel_clock, out.mode.pixel_clock);
+	}
+
+	/* One connector too many starts over. */
+	make_panel(id[EDID_CACHE_SLOTS], &edid[EDID_CACHE_SLOTS], EDID_CACHE_SLOTS);
+	edid_cache_update(EDID_CACHE_SLOTS, id[EDID_CACHE_SLOTS], &edid[EDID_CACHE_SLOTS]);
+	write_edid_cache(NULL);
+
+	reboot();
+	assert_int_equal(0, edid_cache_lookup(EDID_CACHE_SLOTS, id[EDID_CACHE_SLOTS], &out));
+	assert_int_equal(-1, edid_cache_lookup(0, id[0], &out));
+}
+
+static void test_edid_cache_corrupted(void **state)
+{
+	uint8_t id[EDID_CACHE_ID_LENGTH];
+	struct edid edid, out;
+
+	make_panel(id, &edid, 1);
+	edid_cache_update(0, id, &edid);
+	write_edid_cache(NULL);
+
+	/* Flip a bit of the stored mode. */
+	flash_buffer[offsetof(struct edid_cache, slots[0].edid.mode.pixel_clock)] ^= 1;
+
+	reboot();
+	assert_int_equal(-1, edid_cache_lookup(0, id, &out));
+
+	/* A cache from a build with a different struct edid is not used either. */
+	reboot();
+	edid_cache_update(0, id, &edid);
+	cache.edid_size++;
+	write_edid_cache(NULL);
+
+	reboot();
+	assert_int_equal(-1, edid_cache_lookup(0, id, &out));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_edid_cache_empty_flash, setup_edid_cache),
+		cmocka_unit_test_setup(test_edid_cache_hit_after_reboot, setup_edid_cache),
+		cmocka_unit_test_setup(test_edid_cache_panel_swapped, setup_edid_cache),
+		cmocka_unit_test_setup(test_edid_cache_multiple_connectors, setup_edid_cache),
+		cmocka_unit_test_setup(test_edid_cache_corrupted, setup_edid_cache),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbfs.h>
+#include <commonlib/ux_locales_serialized.h>
 #include <stdbool.h>
 #include <string.h>
 #include <tests/test.h>
@@ -41,6 +42,38 @@ struct {
 	size_t size;
 } data;
 
+/* Index of DATA_DEFAULT, the slots are filled in by setup_index(). */
+struct index_name {
+	const char *name;
+	uint32_t offset;
+	uint16_t first_lang;
+	uint16_t num_langs;
+};
+
+static const struct index_name index_names[] = {
+	{ "name_1", 1, 0, 3 },
+	{ "name_15", 65, 3, 3 },
+	{ "name_20", 135, 6, 1 },
+};
+
+static const struct ux_locales_index_lang index_langs[] = {
+	{ .id_offset = 8, .id = 0 },
+	{ .id_offset = 26, .id = 2 },
+	{ .id_offset = 44, .id = 30 },
+	{ .id_offset = 73, .id = 4 },
+	{ .id_offset = 92, .id = 25 },
+	{ .id_offset = 113, .id = 60 },
+	{ .id_offset = 143, .id = 8 },
+};
+
+#define INDEX_SLOTS 8
+struct {
+	struct ux_locales_index_header header;
+	struct ux_locales_index_slot slots[INDEX_SLOTS];
+	struct ux_locales_index_lang langs[ARRAY_SIZE(index_langs)];
+	size_t size;
+} index_data;
+
 /* Mock functions. */
 void cbfs_unmap(void *mapping)
 {
@@ -51,6 +84,12 @@ void cbfs_unmap(void *mapping)
 void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
 		  size_t *size_out, bool force_ro, enum cbfs_type *type)
 {
+	/* The index is optional, it is only present if set up by the test. */
+	if (!strcmp(name, "preram_locales.idx")) {
+		*size_out = index_data.size;
+		return index_data.size ? &index_data : NULL;
+	}
+
 	/* Mock a successful CBFS mapping. */
 	if (mock_type(bool)) {
 		*size_out = data.size;
@@ -90,6 +129,36 @@ static int setup_default(void **state)
 	ret = memcpy(data.raw, data_default, data.size);
 	if (!ret)
 		return 1;
+	index_data.size = 0;
+	return 0;
+}
+
+static int setup_index(void **state)
+{
+	int ret = setup_default(state);
+	if (ret)
+		return ret;
+
+	memset(&index_data, 0, sizeof(index_data));
+	index_data.header.magic = UX_LOCALES_INDEX_MAGIC;
+	index_data.header.version = UX_LOCALES_INDEX_VERSION;
+	index_data.header.num_slots = INDEX_SLOTS;
+	index_data.header.locales_size = DATA_DEFAULT_SIZE;
+	index_data.header.num_langs = ARRAY_SIZE(index_langs);
+
+	for (size_t i = 0; i < ARRAY_SIZE(index_names); i++) {
+		const uint32_t hash = ux_locales_name_hash(index_names[i].name);
+		size_t slot = hash % INDEX_SLOTS;
+
+		while (index_data.slots[slot].name_offset)
+			slot = (slot + 1) % INDEX_SLOTS;
+		index_data.slots[slot].name_hash = hash;
+		index_data.slots[slot].name_offset = index_names[i].offset;
+		index_data.slots[slot].first_lang = index_names[i].first_lang;
+		index_data.slots[slot].num_langs = index_names[i].num_langs;
+	}
+	memcpy(index_data.langs, index_langs, sizeof(index_langs));
+	index_data.size = offsetof(typeof(index_data), size);
 	return 0;
 }
 
@@ -179,6 +248,43 @@ static void test_ux_locales_null_terminated(void **state)
 	assert_null(ux_locales_get_text("name_20"));
 }
 
+/* Put a language ID "60" into translation_15_4, where only searching finds it. */
+static void hide_lang_id_in_translation(void)
+{
+	memcpy(&data.raw[75], "60", 3);
+}
+
+static void test_ux_locales_index_used(void **state)
+{
+	hide_lang_id_in_translation();
+
+	will_return(_cbfs_alloc, true);
+	will_return(vb2api_get_locale_id, 60);
+	assert_string_equal(ux_locales_get_text("name_15"), "translation_15_60");
+}
+
+static void test_ux_locales_index_stale(void **state)
+{
+	hide_lang_id_in_translation();
+	index_data.header.locales_size++;
+
+	will_return(_cbfs_alloc, true);
+	will_return(vb2api_get_locale_id, 60);
+	/* Searching hits the language ID hidden in translation_15_4. */
+	assert_string_equal(ux_locales_get_text("name_15"), "nslation_15_4");
+}
+
+static void test_ux_locales_index_bad_offset(void **state)
+{
+	/* Let language ID 4 of name_15 point to the language ID 25. */
+	index_data.langs[3].id_offset = 92;
+
+	will_return(_cbfs_alloc, true);
+	will_return(vb2api_get_locale_id, 4);
+	/* The offset is rejected, searching still finds the right string. */
+	assert_string_equal(ux_locales_get_text("name_15"), "translation_15_4");
+}
+
 /*
  * This macro helps test ux_locales_get_text with `_name` and `_lang_id`.
  * If `_expect` is NULL, then the function should not find anything.
@@ -198,6 +304,21 @@ static void test_ux_locales_null_terminated(void **state)
 		},                                                                             \
 	})
 
+/* Same as UX_LOCALES_GET_TEXT_TEST, with preram_locales.idx present. */
+#define UX_LOCALES_GET_TEXT_INDEX_TEST(_name, _lang_id, _expect)                               \
+	((struct CMUnitTest) {                                                                 \
+		.name = "test_ux_locales_get_text_index(name=" _name ", lang_id=" #_lang_id    \
+			", expect=" #_expect ")",                                              \
+		.test_func = test_ux_locales_get_text,                                         \
+		.setup_func = setup_index,                                                     \
+		.teardown_func = teardown_unmap,                                               \
+		.initial_state = &(struct ux_locales_test_state) {                             \
+			.name = _name,                                                         \
+			.lang_id = _lang_id,                                                   \
+			.expect = _expect,                                                     \
+		},                                                                             \
+	})
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -229,6 +350,21 @@ int main(void)
 		/* Validity check of NULL terminated. */
 		cmocka_unit_test_setup_teardown(test_ux_locales_null_terminated,
 						setup_default, teardown_unmap),
+		/* Lookups through the index. */
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_1", 0, "translation_1_0"),
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_1", 30, "translation_1_30"),
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_20", 8, "translation_20_8"),
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_2", 3, NULL),
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_1", 7, "translation_1_0"),
+		UX_LOCALES_GET_TEXT_INDEX_TEST("name_15", 8, NULL),
+		/* The index is used instead of searching. */
+		cmocka_unit_test_setup_teardown(test_ux_locales_index_used, setup_index,
+						teardown_unmap),
+		/* Fallback to searching with a stale or broken index. */
+		cmocka_unit_test_setup_teardown(test_ux_locales_index_stale, setup_index,
+						teardown_unmap),
+		cmocka_unit_test_setup_teardown(test_ux_locales_index_bad_offset, setup_index,
+						teardown_unmap),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
@@ -24,6 +24,8 @@ cbfsobj += rmodule.o
 cbfsobj += xdr.o
 cbfsobj += partitioned_file.o
 cbfsobj += platform_fixups.o
+cbfsobj += locales_index.o
+cbfsobj += microcode_index.o
 # COMMONLIB
 cbfsobj += cbfs_private.o
 cbfsobj += fsp_relocate.o
@@ -1354,6 +1354,53 @@ static int cbfs_add_flat_binary(void)
 				  cbfstool_convert_mkflatpayload);
 }
 
+static int cbfstool_convert_locales_index(struct buffer *buffer,
+	unused uint32_t *offset, unused struct cbfs_file *header)
+{
+	struct buffer output;
+
+	if (parse_locales_to_index(buffer, &output) != 0)
+		return -1;
+
+	buffer_delete(buffer);
+	// Direct assign, no dupe.
+	memcpy(buffer, &output, sizeof(*buffer));
+	return 0;
+}
+
+static int cbfs_add_locales_index(void)
+{
+	param.type = CBFS_TYPE_RAW;
+	return cbfs_add_component(param.filename,
+				  param.name,
+				  param.headeroffset,
+				  cbfstool_convert_locales_index);
+}
+
+static int cbfstool_convert_microcode_index(struct buffer *buffer,
+	unused uint32_t *offset, unused struct cbfs_file *header)
+{
+	struct buffer output;
+
+	/* param.hash already defaults to the metadata hash algorithm here. */
+	if (parse_microcode_to_index(buffer, &output, param.hash) != 0)
+		return -1;
+
+	buffer_delete(buffer);
+	// Direct assign, no dupe.
+	memcpy(buffer, &output, sizeof(*buffer));
+	return 0;
+}
+
+static int cbfs_add_microcode_index(void)
+{
+	param.type = CBFS_TYPE_RAW;
+	return cbfs_add_component(param.filename,
+				  param.name,
+				  param.headeroffset,
+				  cbfstool_convert_microcode_index);
+}
+
 static int cbfs_add_integer(void)
 {
 	if (!param.u64val_assigned) {
@@ -1794,6 +1841,8 @@ static const struct command commands[] = {
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
 	{"add-master-header", "H:r:vh?j:", cbfs_add_master_header, true, true},
+	{"add-locales-index", "H:r:f:n:vA:h?", cbfs_add_locales_index, true, true},
+	{"add-microcode-index", "H:r:f:n:vA:h?", cbfs_add_microcode_index, true, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
 	{"create", "M:r:s:B:b:H:o:m:vh?", cbfs_create, true, true},
@@ -1989,6 +2038,12 @@ static void usage(char *name)
 	     " add-master-header [-r image,regions] \\                   \n"
 	     "        [-j topswap-size] (Intel CPUs only)                  "
 			"Add a legacy CBFS master header\n"
+	     " add-locales-index [-r image,regions] -f FILE -n NAME \\\n"
+	     "        [-A hash]                                            "
+			"Add an index for the preram_locales FILE\n"
+	     " add-microcode-index [-r image,regions] -f FILE -n NAME \\\n"
+	     "        [-A hash]                                            "
+			"Add an index for the Intel microcode blob FILE\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
 	     " compact -r image,regions                                    "
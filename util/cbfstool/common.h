@@ -190,6 +190,13 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 			   uint32_t location, const char *ignore_section,
 			   struct cbfs_file_attr_stageheader *stageheader);
 
+/* locales_index.c */
+int parse_locales_to_index(const struct buffer *input, struct buffer *output);
+
+/* microcode_index.c */
+int parse_microcode_to_index(const struct buffer *input, struct buffer *output,
+			     enum vb2_hash_algorithm algo);
+
 void print_supported_architectures(void);
 void print_supported_filetypes(void);
 
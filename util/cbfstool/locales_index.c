@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/endian.h>
+#include <commonlib/ux_locales_serialized.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+/*
+ * Build the index for a preram_locales file (see src/lib/ux_locales.c for the
+ * file format and commonlib/ux_locales_serialized.h for the index format).
+ */
+
+#define LOCALES_VERSION_BYTE	0x01
+#define LOCALES_DELIM_NAME	0x01
+#define LOCALES_LANG_ID_MAX	100
+
+struct locales_name {
+	uint32_t offset;
+	uint32_t hash;
+	uint16_t first_lang;
+	uint16_t num_langs;
+};
+
+/* Return the offset just past the 0-terminated string at offset, or 0 if unterminated. */
+static size_t skip_string(const char *data, size_t offset, size_t size)
+{
+	const char *end = memchr(data + offset, '\0', size - offset);
+
+	return end ? (size_t)(end - data) + 1 : 0;
+}
+
+/* Language IDs are written with "%d" by the firmware, so only accept that form. */
+static int parse_lang_id(const char *str)
+{
+	char canonical[4];
+	char *end;
+	long id;
+
+	id = strtol(str, &end, 10);
+	if (*end != '\0' || id < 0 || id >= LOCALES_LANG_ID_MAX)
+		return -1;
+	snprintf(canonical, sizeof(canonical), "%ld", id);
+	if (strcmp(canonical, str))
+		return -1;
+
+	return id;
+}
+
+static bool name_seen(const char *data, const struct locales_name *names, size_t num_names,
+		      const char *name)
+{
+	for (size_t i = 0; i < num_names; i++)
+		if (!strcmp(data + names[i].offset, name))
+			return true;
+	return false;
+}
+
+int parse_locales_to_index(const struct buffer *input, struct buffer *output)
+{
+	const char *data = buffer_get(input);
+	const size_t size = buffer_size(input);
+	struct locales_name *names = NULL;
+	struct ux_locales_index_lang *langs = NULL;
+	size_t num_names = 0, num_langs = 0, num_slots = 2;
+	size_t offset = 1;
+	int ret = -1;
+
+	if (size < 2 || size > UINT32_MAX || (uint8_t)data[0] != LOCALES_VERSION_BYTE) {
+		ERROR("Not a preram_locales file of version %d.\n", LOCALES_VERSION_BYTE);
+		return -1;
+	}
+
+	/* There can't be more names or languages than strings in the file. */
+	names = calloc(size, sizeof(*names));
+	langs = calloc(size, sizeof(*langs));
+	if (!names || !langs)
+		goto out;
+
+	while (offset < size) {
+		struct locales_name *name = &names[num_names];
+		bool duplicate;
+
+		name->offset = offset;
+		offset = skip_string(data, offset, size);
+		if (!offset) {
+			ERROR("Unterminated string name at 0x%x.\n", name->offset);
+			goto out;
+		}
+
+		/* The firmware search returns the first match, so index only that one. */
+		duplicate = name_seen(data, names, num_names, data + name->offset);
+		if (duplicate)
+			WARN("Duplicate string name '%s'.\n", data + name->offset);
+
+		name->hash = ux_locales_name_hash(data + name->offset);
+		name->first_lang = num_langs;
+
+		while (offset < size && data[offset] != LOCALES_DELIM_NAME) {
+			const size_t id_offset = offset;
+			const int id = parse_lang_id(data + id_offset);
+
+			offset = skip_string(data, offset, size);
+			if (!offset || offset >= size || id < 0) {
+				ERROR("Invalid language ID at 0x%zx.\n", id_offset);
+				goto out;
+			}
+			offset = skip_string(data, offset, size);
+			if (!offset) {
+				ERROR("Unterminated localized string at 0x%zx.\n", id_offset);
+				goto out;
+			}
+
+			if (duplicate)
+				continue;
+			langs[num_langs].id_offset = id_offset;
+			langs[num_langs].id = id;
+			num_langs++;
+		}
+		/* Skip DELIM_NAME */
+		offset++;
+
+		if (duplicate)
+			continue;
+		name->num_langs = num_langs - name->first_lang;
+		num_names++;
+	}
+
+	while (num_slots < 2 * num_names)
+		num_slots *= 2;
+	if (num_slots > UINT16_MAX || num_langs > UINT16_MAX) {
+		ERROR("Too many string names (%zu) or languages (%zu).\n", num_names,
+		      num_langs);
+		goto out;
+	}
+
+	const size_t slots_offset = sizeof(struct ux_locales_index_header);
+	const size_t langs_offset = slots_offset +
+				    num_slots * sizeof(struct ux_locales_index_slot);
+	if (buffer_create(output, langs_offset +
+			  num_langs * sizeof(struct ux_locales_index_lang), input->name))
+		goto out;
+	memset(buffer_get(output), 0, buffer_size(output));
+
+	uint8_t *idx = (uint8_t *)buffer_get(output);
+	write_le32(idx + offsetof(struct ux_locales_index_header, magic),
+		   UX_LOCALES_INDEX_MAGIC);
+	write_le16(idx + offsetof(struct ux_locales_index_header, version),
+		   UX_LOCALES_INDEX_VERSION);
+	write_le16(idx + offsetof(struct ux_locales_index_header, num_slots), num_slots);
+	write_le32(idx + offsetof(struct ux_locales_index_header, locales_size), size);
+	write_le16(idx + offsetof(struct ux_locales_index_header, num_langs), num_langs);
+
+	for (size_t i = 0; i < num_names; i++) {
+		size_t slot = names[i].hash & (num_slots - 1);
+		uint8_t *s;
+
+		/* Offset 0 is the version byte, so name_offset 0 marks an unused slot. */
+		while (read_le32(idx + slots_offset + slot * sizeof(struct ux_locales_index_slot) +
+				 offsetof(struct ux_locales_index_slot, name_offset)))
+			slot = (slot + 1) & (num_slots - 1);
+
+		s = idx + slots_offset + slot * sizeof(struct ux_locales_index_slot);
+		write_le32(s + offsetof(struct ux_locales_index_slot, name_hash), names[i].hash);
+		write_le32(s + offsetof(struct ux_locales_index_slot, name_offset),
+			   names[i].offset);
+		write_le16(s + offsetof(struct ux_locales_index_slot, first_lang),
+			   names[i].first_lang);
+		write_le16(s + offsetof(struct ux_locales_index_slot, num_langs),
+			   names[i].num_langs);
+	}
+
+	for (size_t i = 0; i < num_langs; i++) {
+		uint8_t *l = idx + langs_offset + i * sizeof(struct ux_locales_index_lang);
+
+		write_le32(l + offsetof(struct ux_locales_index_lang, id_offset),
+			   langs[i].id_offset);
+		write_le8(l + offsetof(struct ux_locales_index_lang, id), langs[i].id);
+	}
+
+	INFO("Indexed %zu string names with %zu localized strings.\n", num_names, num_langs);
+	ret = 0;
+
+out:
+	free(names);
+	free(langs);
+	return ret;
+}
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/endian.h>
+#include <commonlib/microcode_index_serialized.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+/*
+ * Build the index for an Intel microcode blob (see src/cpu/intel/microcode/microcode.c for
+ * the lookup and commonlib/microcode_index_serialized.h for the index format). The blob is
+ * walked exactly like the firmware fallback does, so both find the same patch.
+ */
+
+#define MICROCODE_HEADER_SIZE		48
+#define MICROCODE_DEFAULT_SIZE		2048
+#define MICROCODE_EXT_TABLE_SIZE	20
+#define MICROCODE_EXT_ENTRY_SIZE	12
+
+/* Offsets into the microcode header */
+#define MICROCODE_SIG		12
+#define MICROCODE_PF		24
+#define MICROCODE_DATA_SIZE	28
+#define MICROCODE_TOTAL_SIZE	32
+
+struct index_patch {
+	uint32_t offset;
+	uint32_t size;
+};
+
+static int add_sig(struct microcode_index_sig **sigs, size_t *num_sigs, uint32_t sig,
+		   uint32_t pf, size_t patch)
+{
+	struct microcode_index_sig *new = realloc(*sigs, (*num_sigs + 1) * sizeof(**sigs));
+
+	if (!new)
+		return -1;
+
+	new[*num_sigs].sig = sig;
+	new[*num_sigs].pf = pf;
+	new[*num_sigs].patch = patch;
+	*sigs = new;
+	(*num_sigs)++;
+	return 0;
+}
+
+int parse_microcode_to_index(const struct buffer *input, struct buffer *output,
+			     enum vb2_hash_algorithm algo)
+{
+	const uint8_t *data = (const uint8_t *)buffer_get(input);
+	const size_t blob_size = buffer_size(input);
+	struct microcode_index_sig *sigs = NULL;
+	struct index_patch *patches = NULL;
+	size_t num_sigs = 0, num_patches = 0;
+	size_t offset = 0, digest_size = 0;
+	int ret = -1;
+
+	if (blob_size > UINT32_MAX) {
+		ERROR("Microcode blob too large.\n");
+		return -1;
+	}
+
+	if (algo != VB2_HASH_INVALID)
+		digest_size = vb2_digest_size(algo);
+
+	while (blob_size - offset >= MICROCODE_HEADER_SIZE) {
+		const uint8_t *patch = data + offset;
+		const uint32_t data_size = read_le32(patch + MICROCODE_DATA_SIZE);
+		uint32_t total_size = read_le32(patch + MICROCODE_TOTAL_SIZE);
+		struct index_patch *new;
+
+		/* Older patches set the size fields to 0 and are 2048 bytes long. */
+		if (!total_size)
+			total_size = MICROCODE_DEFAULT_SIZE;
+
+		if (total_size > blob_size - offset) {
+			WARN("Microcode header at 0x%zx is corrupted, stop indexing.\n", offset);
+			break;
+		}
+
+		new = realloc(patches, (num_patches + 1) * sizeof(*patches));
+		if (!new)
+			goto out;
+		patches = new;
+		patches[num_patches].offset = offset;
+		patches[num_patches].size = total_size;
+
+		if (add_sig(&sigs, &num_sigs, read_le32(patch + MICROCODE_SIG),
+			    read_le32(patch + MICROCODE_PF), num_patches))
+			goto out;
+
+		/* Extended signature table, as long as it fits into the patch */
+		const int64_t ext_len = (int64_t)read_le32(patch + MICROCODE_TOTAL_SIZE) -
+					((int64_t)data_size + MICROCODE_HEADER_SIZE);
+		if (ext_len >= MICROCODE_EXT_TABLE_SIZE) {
+			const uint8_t *ext = patch + MICROCODE_HEADER_SIZE + data_size;
+			const uint32_t count = read_le32(ext);
+
+			if (ext_len >= MICROCODE_EXT_TABLE_SIZE +
+				       (int64_t)count * MICROCODE_EXT_ENTRY_SIZE) {
+				for (uint32_t i = 0; i < count; i++) {
+					const uint8_t *entry = ext + MICROCODE_EXT_TABLE_SIZE +
+							       i * MICROCODE_EXT_ENTRY_SIZE;
+					if (add_sig(&sigs, &num_sigs, read_le32(entry),
+						    read_le32(entry + 4), num_patches))
+						goto out;
+				}
+			}
+		}
+
+		num_patches++;
+		offset += total_size;
+	}
+
+	if (num_sigs > UINT16_MAX || num_patches > UINT16_MAX) {
+		ERROR("Too many microcode patches (%zu) or signatures (%zu).\n", num_patches,
+		      num_sigs);
+		goto out;
+	}
+
+	const size_t sigs_offset = sizeof(struct microcode_index_header);
+	const size_t patches_offset = sigs_offset + num_sigs * sizeof(struct microcode_index_sig);
+	const size_t patch_stride = sizeof(struct microcode_index_patch) + digest_size;
+	if (buffer_create(output, patches_offset + num_patches * patch_stride, input->name))
+		goto out;
+	memset(buffer_get(output), 0, buffer_size(output));
+
+	uint8_t *idx = (uint8_t *)buffer_get(output);
+	write_le32(idx + offsetof(struct microcode_index_header, magic), MICROCODE_INDEX_MAGIC);
+	write_le16(idx + offsetof(struct microcode_index_header, version),
+		   MICROCODE_INDEX_VERSION);
+	write_le16(idx + offsetof(struct microcode_index_header, num_sigs), num_sigs);
+	write_le16(idx + offsetof(struct microcode_index_header, num_patches), num_patches);
+	write_le8(idx + offsetof(struct microcode_index_header, hash_algo), algo);
+	write_le32(idx + offsetof(struct microcode_index_header, blob_size), blob_size);
+
+	for (size_t i = 0; i < num_sigs; i++) {
+		uint8_t *s = idx + sigs_offset + i * sizeof(struct microcode_index_sig);
+
+		write_le32(s + offsetof(struct microcode_index_sig, sig), sigs[i].sig);
+		write_le32(s + offsetof(struct microcode_index_sig, pf), sigs[i].pf);
+		write_le16(s + offsetof(struct microcode_index_sig, patch), sigs[i].patch);
+	}
+
+	for (size_t i = 0; i < num_patches; i++) {
+		uint8_t *p = idx + patches_offset + i * patch_stride;
+		struct vb2_hash hash;
+
+		write_le32(p + offsetof(struct microcode_index_patch, offset), patches[i].offset);
+		write_le32(p + offsetof(struct microcode_index_patch, size), patches[i].size);
+
+		if (!digest_size)
+			continue;
+		if (vb2_hash_calculate(false, data + patches[i].offset, patches[i].size, algo,
+				       &hash) != VB2_SUCCESS) {
+			ERROR("Failed to hash microcode patch at 0x%x.\n", patches[i].offset);
+			buffer_delete(output);
+			goto out;
+		}
+		memcpy(p + sizeof(struct microcode_index_patch), hash.raw, digest_size);
+	}
+
+	INFO("Indexed %zu microcode patches with %zu signatures.\n", num_patches, num_sigs);
+	ret = 0;
+
+out:
+	free(sigs);
+	free(patches);
+	return ret;
+}
@@ -18,6 +18,7 @@
 #include <libgen.h>
 #include <assert.h>
 #include <regex.h>
+#include <commonlib/amd_stb_serialized.h>
 #include <commonlib/bsd/cbmem_id.h>
 #include <commonlib/bsd/ipchksum.h>
 #include <commonlib/bsd/tpm_log_defs.h>
@@ -824,6 +825,174 @@ static void timestamp_add_now(uint32_t timestamp_id)
 	unmap_memory(&timestamp_mapping);
 }
 
+struct stb_timeline_entry {
+	double usecs;
+	bool is_stb;
+	uint32_t id;
+};
+
+static int compare_stb_timeline_entries(const void *a, const void *b)
+{
+	const struct stb_timeline_entry *ea = a;
+	const struct stb_timeline_entry *eb = b;
+
+	return (ea->usecs > eb->usecs) - (ea->usecs < eb->usecs);
+}
+
+static void print_stb_value(uint32_t val)
+{
+	if (val == AMD_STB_COREBOOT_SYNC)
+		printf("STB coreboot sync marker\n");
+	else if ((val & 0xffffff00) == AMD_STB_COREBOOT_POST_PREFIX)
+		printf("STB coreboot post code 0x%02x\n", val & 0xff);
+	else
+		printf("STB 0x%08x\n", val);
+}
+
+/*
+ * Dump the AMD Smart Trace Buffer log. The sync markers written by coreboot
+ * are paired with the TS_AMD_STB_SYNC timestamps to convert STB time into
+ * coreboot timestamp time, and the STB entries are then listed together with
+ * the coreboot timestamps on one timeline.
+ */
+static void dump_amd_stb(void)
+{
+	const struct amd_stb_log *log_p;
+	struct amd_stb_log *log;
+	const struct timestamp_table *tst_p;
+	struct timestamp_table *tst;
+	struct mapping stb_mapping, timestamp_mapping;
+	struct stb_timeline_entry *timeline;
+	uint64_t start, *stb_time, *stb_sync, *ts_sync;
+	uint64_t stb_time_high = 0;
+	uint32_t num_stb_sync = 0, num_ts_sync = 0, num_sync, n = 0;
+	size_t size;
+
+	if (find_cbmem_entry(CBMEM_ID_AMD_STB_LOG, &start, &size)) {
+		fprintf(stderr, "No AMD STB log found in coreboot table.\n");
+		return;
+	}
+
+	log_p = map_memory(&stb_mapping, start, size);
+	if (!log_p)
+		die("Unable to map AMD STB log\n");
+
+	log = malloc(size);
+	if (!log)
+		die("Failed to allocate memory");
+	aligned_memcpy(log, log_p, size);
+	unmap_memory(&stb_mapping);
+
+	if (log->magic != AMD_STB_LOG_MAGIC || size < sizeof(*log) ||
+	    log->num_entries > (size - sizeof(*log)) / sizeof(log->entries[0]))
+		die("Invalid AMD STB log\n");
+
+	/* The STB timer is 32 bits wide, unwrap it. */
+	stb_time = malloc((log->num_entries + 1) * sizeof(*stb_time));
+	stb_sync = malloc((log->num_entries + 1) * sizeof(*stb_sync));
+	if (!stb_time || !stb_sync)
+		die("Failed to allocate memory");
+	for (uint32_t i = 0; i < log->num_entries; i++) {
+		if (i && log->entries[i].ts < log->entries[i - 1].ts)
+			stb_time_high += 1ULL << 32;
+		stb_time[i] = stb_time_high | log->entries[i].ts;
+		if (log->entries[i].val == AMD_STB_COREBOOT_SYNC)
+			stb_sync[num_stb_sync++] = stb_time[i];
+	}
+
+	if (timestamps.tag != LB_TAG_TIMESTAMPS)
+		die("No timestamps found in coreboot table.\n");
+
+	size = sizeof(*tst_p);
+	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
+	if (!tst_p)
+		die("Unable to map timestamp header\n");
+	timestamp_set_tick_freq(tst_p->tick_freq_mhz);
+	size += tst_p->num_entries * sizeof(tst_p->entries[0]);
+	unmap_memory(&timestamp_mapping);
+
+	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
+	if (!tst_p)
+		die("Unable to map full timestamp table\n");
+	tst = malloc(size);
+	if (!tst)
+		die("Failed to allocate memory");
+	aligned_memcpy(tst, tst_p, size);
+	unmap_memory(&timestamp_mapping);
+
+	qsort(&tst->entries[0], tst->num_entries, sizeof(struct timestamp_entry),
+	      compare_timestamp_entries);
+
+	ts_sync = malloc((tst->num_entries + 1) * sizeof(*ts_sync));
+	if (!ts_sync)
+		die("Failed to allocate memory");
+	for (uint32_t i = 0; i < tst->num_entries; i++) {
+		if (tst->entries[i].entry_id == TS_AMD_STB_SYNC)
+			ts_sync[num_ts_sync++] = tst->entries[i].entry_stamp + tst->base_time;
+	}
+
+	/*
+	 * Older STB entries may have been dropped when the FIFO was full, but
+	 * the last sync points are always there. Pair them from the end.
+	 */
+	num_sync = num_stb_sync < num_ts_sync ? num_stb_sync : num_ts_sync;
+	if (num_stb_sync != num_ts_sync)
+		fprintf(stderr, "Warning: %u STB sync markers, but %u sync timestamps.\n",
+			num_stb_sync, num_ts_sync);
+
+	if (num_sync < 2 || stb_sync[num_stb_sync - 1] == stb_sync[num_stb_sync - num_sync]) {
+		fprintf(stderr, "Not enough sync points, printing raw STB entries.\n");
+		for (uint32_t i = 0; i < log->num_entries; i++) {
+			printf("%12" PRIu64 "  ", stb_time[i]);
+			print_stb_value(log->entries[i].val);
+		}
+		goto out;
+	}
+
+	const double stb0 = stb_sync[num_stb_sync - num_sync];
+	const double stb1 = stb_sync[num_stb_sync - 1];
+	const double ts0 = arch_convert_raw_ts_entry(ts_sync[num_ts_sync - num_sync]);
+	const double ts1 = arch_convert_raw_ts_entry(ts_sync[num_ts_sync - 1]);
+	const double scale = (ts1 - ts0) / (stb1 - stb0);
+
+	debug("STB tick: %f us\n", scale);
+
+	timeline = malloc((log->num_entries + tst->num_entries + 1) * sizeof(*timeline));
+	if (!timeline)
+		die("Failed to allocate memory");
+
+	for (uint32_t i = 0; i < log->num_entries; i++) {
+		timeline[n].usecs = ts0 + (stb_time[i] - stb0) * scale;
+		timeline[n].is_stb = true;
+		timeline[n++].id = log->entries[i].val;
+	}
+	for (uint32_t i = 0; i < tst->num_entries; i++) {
+		timeline[n].usecs = arch_convert_raw_ts_entry(tst->entries[i].entry_stamp +
+							      tst->base_time);
+		timeline[n].is_stb = false;
+		timeline[n++].id = tst->entries[i].entry_id;
+	}
+
+	qsort(timeline, n, sizeof(*timeline), compare_stb_timeline_entries);
+
+	/* Same time base as the absolute times of `cbmem -t` */
+	for (uint32_t i = 0; i < n; i++) {
+		printf("%14.0f  ", timeline[i].usecs);
+		if (timeline[i].is_stb)
+			print_stb_value(timeline[i].id);
+		else
+			printf("%4d:%s\n", timeline[i].id, timestamp_name(timeline[i].id));
+	}
+
+	free(timeline);
+out:
+	free(ts_sync);
+	free(tst);
+	free(stb_sync);
+	free(stb_time);
+	free(log);
+}
+
 static bool can_print(const uint8_t *data, size_t len)
 {
 	unsigned int i;
@@ -1536,7 +1705,7 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cCltTLAxVvh?]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
@@ -1551,6 +1720,7 @@ static void print_usage(const char *name, int exit_code)
 	     "   -S | --stacked-timestamps:        print stacked timestamps (e.g. for flame graph tools)\n"
 	     "   -a | --add-timestamp ID:          append timestamp with ID\n"
 	     "   -L | --tcpa-log                   print TPM log\n"
+	     "   -A | --amd-stb                    print AMD STB log on the timestamp timeline\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1682,6 +1852,7 @@ int main(int argc, char** argv)
 	int print_hexdump = 0;
 	int print_rawdump = 0;
 	int print_tcpa_log = 0;
+	int print_amd_stb = 0;
 	enum timestamps_print_type timestamp_type = TIMESTAMPS_PRINT_NONE;
 	enum console_print_type console_type = CONSOLE_PRINT_FULL;
 	unsigned int rawdump_id = 0;
@@ -1698,6 +1869,7 @@ int main(int argc, char** argv)
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
+		{"amd-stb", 0, 0, 'A'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"stacked-timestamps", 0, 0, 'S'},
@@ -1709,7 +1881,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c12B:CltTSa:LxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c12B:CltTSa:LAxVvh?r:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1741,6 +1913,10 @@ int main(int argc, char** argv)
 			print_tcpa_log = 1;
 			print_defaults = 0;
 			break;
+		case 'A':
+			print_amd_stb = 1;
+			print_defaults = 0;
+			break;
 		case 'x':
 			print_hexdump = 1;
 			print_defaults = 0;
@@ -1890,6 +2066,9 @@ int main(int argc, char** argv)
 	if (print_tcpa_log)
 		dump_tpm_log();
 
+	if (print_amd_stb)
+		dump_amd_stb();
+
 	unmap_memory(&lbtable_mapping);
 
 	close(mem_fd);